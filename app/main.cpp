@@ -19,6 +19,16 @@ int main() {
 		else if (!strcmp(command, "hard")) {
 			server.sendTestLog(true);
 		}
+		else if (!strcmp(command, "console")) {
+			server.setConsoleEnabled(!server.isConsoleEnabled());
+			printf("[[SYSTEM]] Console output : %s\n", server.isConsoleEnabled() ? "ON" : "OFF");
+		}
+		else if (!strcmp(command, "metrics")) {
+			std::string metrics;
+			server.dumpMetrics(metrics);
+			fwrite(metrics.data(), 1, metrics.size(), stdout);
+			fflush(stdout);
+		}
 		else if (!strcmp(command, "exit")) {
 			is_running = false;
 		}
@@ -0,0 +1,493 @@
+// Drives a SimpleLogServer over loopback and reports throughput and end-to-end latency.
+//
+// By default the server runs in this process, so every line can be timed from the moment a client
+// put it on the wire until the writer thread handed it to the LogPool. With --host the load goes to
+// an external server instead and only throughput is reported.
+
+#include <simple_log_server.hpp>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    enum class SizeDistribution { FIXED, UNIFORM, EXPONENTIAL };
+
+    struct Options
+    {
+        std::string host;
+        uint32_t port{ 13580 };
+        size_t clients{ 4 };
+        size_t min_size{ 32 };
+        size_t max_size{ 256 };
+        SizeDistribution distribution{ SizeDistribution::UNIFORM };
+        // lines per second over all clients (0 : as fast as possible)
+        double rate{ 0 };
+        double duration{ 10 };
+        bool is_legacy{ false };
+        // frames carry a CRC32C (LogHeader::FLAG_CHECKSUM)
+        bool is_checksummed{ false };
+        // every corrupt_interval-th frame gets a flipped payload byte and stray bytes after it (0 : none)
+        size_t corrupt_interval{ 0 };
+        // reactors of the epoll backend for the in-process server (0 : SocketRequestServer)
+        size_t epoll_reactors{ 0 };
+        // connections that stay open without sending anything
+        size_t idle{ 0 };
+        // the in-process server writes its segments with LogSegmentWriterType::DIRECT
+        bool is_direct{ false };
+        // pool shards of the in-process server, keyed by signature (one per client)
+        size_t shards{ 1 };
+        std::string directory;
+        std::string output;
+    };
+
+    // Log-linear latency histogram : 64 sub-buckets per power of two (~1.5% precision)
+    class LatencyHistogram
+    {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 6;
+        static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+        LatencyHistogram() : _counts(64 * SUB_BUCKETS, 0) {}
+
+        void record(uint64_t value)
+        {
+            _counts[index(value)]++;
+            _total++;
+            _max = std::max(_max, value);
+        }
+
+        uint64_t percentile(double p) const
+        {
+            if (_total == 0)
+                return 0;
+            uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * _total));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < _counts.size(); i++) {
+                seen += _counts[i];
+                if (seen >= target)
+                    return std::min(upperBound(i), _max);
+            }
+            return _max;
+        }
+
+        inline uint64_t total() const { return _total; }
+        inline uint64_t max() const { return _max; }
+
+    private:
+        static size_t index(uint64_t value)
+        {
+            if (value < SUB_BUCKETS)
+                return static_cast<size_t>(value);
+            size_t exponent = 63 - __builtin_clzll(value);
+            size_t shift = exponent - SUB_BUCKET_BITS;
+            size_t sub = static_cast<size_t>((value >> shift) & (SUB_BUCKETS - 1));
+            return (shift + 1) * SUB_BUCKETS + sub;
+        }
+        static uint64_t upperBound(size_t index)
+        {
+            if (index < SUB_BUCKETS)
+                return index;
+            size_t shift = index / SUB_BUCKETS - 1;
+            uint64_t sub = index % SUB_BUCKETS;
+            return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+        }
+
+        std::vector<uint64_t> _counts;
+        uint64_t _total{ 0 };
+        uint64_t _max{ 0 };
+    };
+
+    struct ClientResult
+    {
+        uint64_t lines{ 0 };
+        uint64_t bytes{ 0 };
+        // lines damaged on purpose (--corrupt)
+        uint64_t corrupted{ 0 };
+        bool is_connected{ false };
+    };
+
+    inline uint64_t nowNanoseconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void printUsage()
+    {
+        printf(
+            "usage: SimpleLogLoadGenerator [options]\n"
+            "  --host ADDRESS          send to an external server (default: run one in process)\n"
+            "  --port PORT             server port (default: 13580)\n"
+            "  --clients N             concurrent connections (default: 4)\n"
+            "  --size MIN[:MAX]        content size in bytes (default: 32:256)\n"
+            "  --distribution NAME     fixed | uniform | exponential (default: uniform)\n"
+            "  --rate LINES            lines per second over all clients, 0 = unlimited (default: 0)\n"
+            "  --duration SECONDS      (default: 10)\n"
+            "  --legacy                send fixed-size legacy frames\n"
+            "  --checksum              send a CRC32C with every frame\n"
+            "  --corrupt N             damage every Nth frame and follow it with stray bytes\n"
+            "                          (rejected with --checksum, framing is recovered with --epoll)\n"
+            "  --epoll REACTORS        run the in-process server on the epoll backend\n"
+            "  --idle N                keep N more connections open that send nothing\n"
+            "  --direct                the in-process server writes segments with O_DIRECT instead of mmap\n"
+            "  --shards N              the in-process server writes into N pool shards, one client per shard\n"
+            "  --directory PATH        where the in-process server writes its segments\n"
+            "  --output FILE           save the results as JSON\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+
+            if (arg == "--host") options.host = value();
+            else if (arg == "--port") options.port = static_cast<uint32_t>(atoi(value()));
+            else if (arg == "--clients") options.clients = static_cast<size_t>(atoi(value()));
+            else if (arg == "--size") {
+                const char* v = value();
+                options.min_size = strtoul(v, nullptr, 10);
+                const char* colon = strchr(v, ':');
+                options.max_size = colon ? strtoul(colon + 1, nullptr, 10) : options.min_size;
+            }
+            else if (arg == "--distribution") {
+                std::string v = value();
+                if (v == "fixed") options.distribution = SizeDistribution::FIXED;
+                else if (v == "uniform") options.distribution = SizeDistribution::UNIFORM;
+                else if (v == "exponential") options.distribution = SizeDistribution::EXPONENTIAL;
+                else return false;
+            }
+            else if (arg == "--rate") options.rate = atof(value());
+            else if (arg == "--duration") options.duration = atof(value());
+            else if (arg == "--legacy") options.is_legacy = true;
+            else if (arg == "--checksum") options.is_checksummed = true;
+            else if (arg == "--corrupt") options.corrupt_interval = strtoul(value(), nullptr, 10);
+            else if (arg == "--epoll") options.epoll_reactors = static_cast<size_t>(atoi(value()));
+            else if (arg == "--idle") options.idle = static_cast<size_t>(atoi(value()));
+            else if (arg == "--direct") options.is_direct = true;
+            else if (arg == "--shards") options.shards = std::max<size_t>(strtoul(value(), nullptr, 10), 1);
+            else if (arg == "--directory") options.directory = value();
+            else if (arg == "--output") options.output = value();
+            else return false;
+        }
+
+        if (options.clients == 0)
+            options.clients = 1;
+        // 내용 앞에 붙는 송신 시각 "#<ns> " 자리를 남긴다
+        options.min_size = std::max<size_t>(options.min_size, 24);
+        options.max_size = std::min<size_t>(std::max(options.max_size, options.min_size), LogLine::CONTENT_SIZE - 1);
+        options.min_size = std::min(options.min_size, options.max_size);
+        return true;
+    }
+
+    size_t nextSize(const Options& options, std::mt19937& rng)
+    {
+        switch (options.distribution) {
+        case SizeDistribution::FIXED:
+            return options.min_size;
+        case SizeDistribution::UNIFORM:
+            return std::uniform_int_distribution<size_t>(options.min_size, options.max_size)(rng);
+        case SizeDistribution::EXPONENTIAL: {
+            // min_size에서 시작해서 짧은 로그가 대부분이고 가끔 긴 로그가 섞인다
+            double mean = (options.max_size - options.min_size) / 8.0 + 1.0;
+            size_t size = options.min_size + static_cast<size_t>(std::exponential_distribution<double>(1.0 / mean)(rng));
+            return std::min(size, options.max_size);
+        }
+        }
+        return options.min_size;
+    }
+
+    void runClient(const Options& options, size_t id, const std::atomic<bool>& is_running, ClientResult& result)
+    {
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options.port));
+        inet_pton(AF_INET, options.host.empty() ? "127.0.0.1" : options.host.c_str(), &addr.sin_addr);
+
+        if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(sock);
+            return;
+        }
+        result.is_connected = true;
+
+        std::mt19937 rng{ static_cast<uint32_t>(id * 7919 + 1) };
+        char signature[LogHeader::SIGNATURE_SIZE];
+        snprintf(signature, sizeof(signature), "LoadGenerator::client%zu", id);
+        LogLine line{ signature, "BENCH", LogColor::Teal, "" };
+        if (options.is_legacy)
+            line.header.version = LogHeader::VERSION_LEGACY;
+
+        // 속도 제한이 없으면 여러 줄을 모아서 보내고, 있으면 한 줄씩 제 시간에 보낸다
+        constexpr size_t BATCH_BYTES = 64 * 1024;
+        std::vector<char> batch;
+        batch.reserve(BATCH_BYTES + LogLine::SIZE);
+
+        const bool is_paced = options.rate > 0;
+        const auto interval = std::chrono::nanoseconds(is_paced ? static_cast<int64_t>(1e9 * options.clients / options.rate) : 0);
+        auto next_send = std::chrono::steady_clock::now();
+
+        auto flush = [&]() {
+            const char* data = batch.data();
+            size_t remaining = batch.size();
+            while (remaining > 0) {
+                ssize_t sent = send(sock, data, remaining, MSG_NOSIGNAL);
+                if (sent <= 0)
+                    return false;
+                data += sent;
+                remaining -= static_cast<size_t>(sent);
+            }
+            batch.clear();
+            return true;
+        };
+
+        while (is_running.load(std::memory_order_relaxed)) {
+            if (is_paced) {
+                std::this_thread::sleep_until(next_send);
+                next_send += interval;
+            }
+
+            size_t size = nextSize(options, rng);
+            int prefix = snprintf(line.content, LogLine::CONTENT_SIZE, "#%llu ", static_cast<unsigned long long>(nowNanoseconds()));
+            memset(line.content + prefix, 'x', size - prefix);
+            line.content[size] = '\0';
+            line.header.payload_size = static_cast<uint32_t>(size + 1);
+            if (!options.is_legacy) {
+                // 조회 시험에도 쓸 수 있게 줄마다 시각과 순번을 새로 붙인다
+                line.header.timestamp = LogTimestamp::now();
+                line.header.sequence++;
+            }
+
+            if (options.is_checksummed && !options.is_legacy)
+                line.seal();
+
+            size_t wire_size = line.wireSize();
+            const char* raw = reinterpret_cast<const char*>(&line);
+            batch.insert(batch.end(), raw, raw + wire_size);
+            result.lines++;
+            result.bytes += wire_size;
+
+            if (options.corrupt_interval > 0 && result.lines % options.corrupt_interval == 0) {
+                // 내용 한 바이트를 바꾸고 프레임 사이에 헤더가 아닌 바이트를 끼워 넣는다
+                batch[batch.size() - 2] ^= 0x20;
+                static constexpr char STRAY[] = "SLO\x01garbage";
+                batch.insert(batch.end(), STRAY, STRAY + sizeof(STRAY) - 1);
+                result.corrupted++;
+            }
+
+            if (is_paced || batch.size() >= BATCH_BYTES) {
+                if (!flush())
+                    break;
+            }
+        }
+        flush();
+        close(sock);
+    }
+
+    void writeJson(const Options& options, const std::vector<ClientResult>& results, double elapsed, uint64_t written, const LatencyHistogram* latency)
+    {
+        FILE* file = fopen(options.output.c_str(), "w");
+        if (!file) {
+            printf("[[SYSTEM]] Cannot open %s\n", options.output.c_str());
+            return;
+        }
+
+        uint64_t lines = 0;
+        uint64_t bytes = 0;
+        for (auto& result : results) {
+            lines += result.lines;
+            bytes += result.bytes;
+        }
+
+        const char* distribution = options.distribution == SizeDistribution::FIXED ? "fixed"
+            : options.distribution == SizeDistribution::UNIFORM ? "uniform" : "exponential";
+
+        fprintf(file, "{\n");
+        fprintf(file, "  \"timestamp\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+        fprintf(file, "  \"configuration\": {\n");
+        fprintf(file, "    \"server\": \"%s\",\n", options.host.empty() ? "in-process" : options.host.c_str());
+        fprintf(file, "    \"clients\": %zu,\n", options.clients);
+        fprintf(file, "    \"min_size\": %zu,\n", options.min_size);
+        fprintf(file, "    \"max_size\": %zu,\n", options.max_size);
+        fprintf(file, "    \"distribution\": \"%s\",\n", distribution);
+        fprintf(file, "    \"rate\": %.1f,\n", options.rate);
+        fprintf(file, "    \"duration\": %.3f,\n", options.duration);
+        fprintf(file, "    \"legacy\": %s,\n", options.is_legacy ? "true" : "false");
+        fprintf(file, "    \"checksum\": %s,\n", options.is_checksummed ? "true" : "false");
+        fprintf(file, "    \"corrupt_interval\": %zu,\n", options.corrupt_interval);
+        fprintf(file, "    \"epoll_reactors\": %zu,\n", options.epoll_reactors);
+        fprintf(file, "    \"idle\": %zu,\n", options.idle);
+        fprintf(file, "    \"segment_writer\": \"%s\",\n", options.is_direct ? "direct" : "memory_mapped");
+        fprintf(file, "    \"shards\": %zu\n", options.shards);
+        fprintf(file, "  },\n");
+        fprintf(file, "  \"results\": {\n");
+        fprintf(file, "    \"elapsed\": %.3f,\n", elapsed);
+        fprintf(file, "    \"lines_sent\": %llu,\n", static_cast<unsigned long long>(lines));
+        fprintf(file, "    \"bytes_sent\": %llu,\n", static_cast<unsigned long long>(bytes));
+        fprintf(file, "    \"lines_written\": %llu,\n", static_cast<unsigned long long>(written));
+        fprintf(file, "    \"lines_per_sec\": %.1f,\n", lines / elapsed);
+        fprintf(file, "    \"mb_per_sec\": %.3f,\n", bytes / elapsed / (1024.0 * 1024.0));
+        if (latency && latency->total() > 0) {
+            fprintf(file, "    \"latency_us\": { \"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f }\n",
+                latency->percentile(50) / 1e3, latency->percentile(99) / 1e3, latency->percentile(99.9) / 1e3, latency->max() / 1e3);
+        }
+        else {
+            fprintf(file, "    \"latency_us\": null\n");
+        }
+        fprintf(file, "  }\n");
+        fprintf(file, "}\n");
+        fclose(file);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return -1;
+    }
+
+    if (!options.directory.empty() && chdir(options.directory.c_str()) != 0) {
+        printf("[[SYSTEM]] Cannot change directory to %s\n", options.directory.c_str());
+        return -1;
+    }
+
+    // 서버를 같은 프로세스에서 돌리면 writer가 받은 시점까지의 지연을 잴 수 있다
+    LatencyHistogram latency;
+    std::mutex latency_mutex;
+    std::atomic<uint64_t> written{ 0 };
+    std::unique_ptr<SimpleLogServer> server;
+    if (options.host.empty()) {
+        SimpleLogServerConfiguration configuration;
+        configuration.port = options.port;
+        configuration.console.is_enabled = false;
+        if (options.is_direct)
+            configuration.pool.segment_writer = LogSegmentWriterType::DIRECT;
+        // 클라이언트마다 signature가 다르다
+        configuration.shards.shard_count = options.shards;
+        configuration.shards.key = LogShardKey::SIGNATURE;
+        if (options.epoll_reactors > 0) {
+            configuration.ingestion = LogIngestion::EPOLL;
+            configuration.epoll.reactor_count = options.epoll_reactors;
+        }
+        configuration.writer.on_written = [&](const LogLine* lines, size_t count) {
+            uint64_t now = nowNanoseconds();
+            // shard마다 writer 스레드가 따로 있다
+            std::lock_guard<std::mutex> lock(latency_mutex);
+            for (size_t i = 0; i < count; i++) {
+                if (lines[i].content[0] != '#')
+                    continue;
+                uint64_t sent = strtoull(lines[i].content + 1, nullptr, 10);
+                latency.record(now > sent ? now - sent : 0);
+            }
+            written.fetch_add(count, std::memory_order_release);
+        };
+
+        server.reset(new SimpleLogServer(configuration));
+        if (!*server) {
+            return -1;
+        }
+    }
+
+    // 대부분 조용한 에이전트들을 흉내 낸다
+    std::vector<int> idle_sockets;
+    for (size_t i = 0; i < options.idle; i++) {
+        int sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options.port));
+        inet_pton(AF_INET, options.host.empty() ? "127.0.0.1" : options.host.c_str(), &addr.sin_addr);
+        if (connect(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(sock);
+            printf("[[SYSTEM]] Only %zu idle connections could be opened\n", i);
+            break;
+        }
+        idle_sockets.push_back(sock);
+    }
+
+    std::atomic<bool> is_running{ true };
+    std::vector<ClientResult> results(options.clients);
+    std::vector<std::thread> clients;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.clients; i++) {
+        clients.emplace_back([&, i]() { runClient(options, i, is_running, results[i]); });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    is_running = false;
+    for (auto& client : clients)
+        client.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t lines = 0;
+    uint64_t bytes = 0;
+    uint64_t corrupted = 0;
+    size_t connected = 0;
+    for (auto& result : results) {
+        lines += result.lines;
+        bytes += result.bytes;
+        corrupted += result.corrupted;
+        connected += result.is_connected ? 1 : 0;
+    }
+    if (connected == 0) {
+        printf("[[SYSTEM]] No client could connect to port %u\n", options.port);
+        return -1;
+    }
+
+    if (server) {
+        // 보낸 로그가 모두 writer에 도착할 때까지 기다린다 (최대 10초). 체크섬이 있으면 손상된 줄은 버려진다.
+        uint64_t expected = options.is_checksummed ? lines - corrupted : lines;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (written.load(std::memory_order_acquire) < expected && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        server.reset();
+    }
+
+    for (int sock : idle_sockets)
+        close(sock);
+
+    printf("clients        : %zu (%zu connected)\n", options.clients, connected);
+    if (!idle_sockets.empty())
+        printf("idle clients   : %zu\n", idle_sockets.size());
+    printf("lines sent     : %llu\n", static_cast<unsigned long long>(lines));
+    if (corrupted > 0)
+        printf("lines damaged  : %llu\n", static_cast<unsigned long long>(corrupted));
+    printf("lines/sec      : %.1f\n", lines / elapsed);
+    printf("MB/sec         : %.3f\n", bytes / elapsed / (1024.0 * 1024.0));
+    if (latency.total() > 0) {
+        printf("lines written  : %llu\n", static_cast<unsigned long long>(written.load()));
+        printf("latency p50    : %.1f us\n", latency.percentile(50) / 1e3);
+        printf("latency p99    : %.1f us\n", latency.percentile(99) / 1e3);
+        printf("latency p999   : %.1f us\n", latency.percentile(99.9) / 1e3);
+        printf("latency max    : %.1f us\n", latency.max() / 1e3);
+    }
+
+    if (!options.output.empty())
+        writeJson(options, results, elapsed, written.load(), options.host.empty() ? &latency : nullptr);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <simple_log_client.hpp>
+#include <simple_log_server.hpp>
+
+#include <memory>
+
+using namespace Bn3Monkey;
+
+// SimpleLogClient::log as seen by the application thread, with an in-process server draining the sender.
+// The iterations fit in the queue, so this is the cost of the call itself and not of the network.
+static void BM_SimpleLogClient_Log(benchmark::State& state)
+{
+    SimpleLogServerConfiguration server_configuration;
+    server_configuration.port = 13591;
+    server_configuration.console.is_enabled = false;
+    server_configuration.pool.is_compressed = false;
+    auto server = std::make_unique<SimpleLogServer>(server_configuration);
+
+    SimpleLogClientConfiguration configuration;
+    configuration.port = server_configuration.port;
+    configuration.signature = "Benchmark::SimpleLogClient";
+    configuration.queue_capacity = 8 * 1024 * 1024;
+    SimpleLogClient client{ configuration };
+
+    const char content[] = "request finished in 42 us";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.log("BENCH", LogColor::Green, content, sizeof(content) - 1));
+    }
+    state.counters["dropped"] = static_cast<double>(client.dropped());
+    client.flush();
+}
+BENCHMARK(BM_SimpleLogClient_Log)->Iterations(50000);
+
+// SLOG with the same content as BM_SimpleLogClient_Log : the arguments are queued in binary and formatted by the server
+static void BM_SimpleLogClient_Slog(benchmark::State& state)
+{
+    SimpleLogServerConfiguration server_configuration;
+    server_configuration.port = 13592;
+    server_configuration.console.is_enabled = false;
+    server_configuration.pool.is_compressed = false;
+    auto server = std::make_unique<SimpleLogServer>(server_configuration);
+
+    SimpleLogClientConfiguration configuration;
+    configuration.port = server_configuration.port;
+    configuration.signature = "Benchmark::SimpleLogClient";
+    configuration.queue_capacity = 8 * 1024 * 1024;
+    SimpleLogClient client{ configuration };
+
+    const char* name = "request";
+    uint64_t elapsed = 42;
+    for (auto _ : state) {
+        SLOG_TO(client, "BENCH", LogColor::Green, "{} finished in {} us", name, elapsed);
+    }
+    state.counters["dropped"] = static_cast<double>(client.dropped());
+    client.flush();
+}
+BENCHMARK(BM_SimpleLogClient_Slog)->Iterations(50000);
+
+// LogFormat::expand as done by the server for every SLOG line
+static void BM_LogFormat_Expand(benchmark::State& state)
+{
+    char arguments[64];
+    char* end = LogFormat::encode(arguments, arguments + sizeof(arguments), "request");
+    end = LogFormat::encode(end, arguments + sizeof(arguments), uint64_t{ 42 });
+
+    char content[LogLine::CONTENT_SIZE];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LogFormat::expand("{} finished in {} us", arguments, static_cast<size_t>(end - arguments), content, sizeof(content)));
+    }
+}
+BENCHMARK(BM_LogFormat_Expand);
@@ -0,0 +1,140 @@
+#include <benchmark/benchmark.h>
+
+#include <log_pool/log_pool.hpp>
+#include <log_pool/log_block_codec.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+static std::vector<LogLine> makeLines(size_t count, size_t content_size)
+{
+    std::string content(content_size, 'x');
+    std::vector<LogLine> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; i++)
+        lines.emplace_back("Benchmark::LogPool", "BENCH", LogColor::Green, content.c_str());
+    return lines;
+}
+
+static Durability toDurability(int64_t value)
+{
+    switch (value) {
+    case 1: return Durability::ASYNC;
+    case 2: return Durability::GROUP_COMMIT;
+    default: return Durability::SYNC;
+    }
+}
+
+// LogPool::write : args are content size, commit interval in lines, durability (0 SYNC, 1 ASYNC, 2 GROUP_COMMIT)
+// and segment writer (0 MEMORY_MAPPED, 1 DIRECT)
+static void BM_LogPool_Write(benchmark::State& state)
+{
+    LogPoolConfiguration configuration;
+    configuration.interval_lines_of_commit = static_cast<size_t>(state.range(1));
+    configuration.durability = toDurability(state.range(2));
+    configuration.segment_writer = state.range(3) == 1 ? LogSegmentWriterType::DIRECT : LogSegmentWriterType::MEMORY_MAPPED;
+    // 쓰는 경로만 재도록 압축은 끈다
+    configuration.is_compressed = false;
+
+    auto lines = makeLines(1024, static_cast<size_t>(state.range(0)));
+    size_t index = 0;
+    {
+        LogPool pool{ configuration };
+        for (auto _ : state) {
+            pool.write(lines[index++ & 1023]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogPool_Write)
+    ->ArgNames({ "size", "interval", "durability", "writer" })
+    ->Args({ 32, 64, 0, 0 })
+    ->Args({ 32, 1024, 0, 0 })
+    ->Args({ 32, 64, 1, 0 })
+    ->Args({ 32, 64, 2, 0 })
+    ->Args({ 512, 64, 0, 0 })
+    ->Args({ 512, 64, 2, 0 })
+    ->Args({ LogLine::CONTENT_SIZE - 1, 64, 0, 0 })
+    ->Args({ 32, 64, 0, 1 })
+    ->Args({ 32, 64, 1, 1 })
+    ->Args({ 32, 64, 2, 1 })
+    ->Args({ 512, 64, 2, 1 })
+    ->UseRealTime();
+
+// LogPool::writeBatch : args are content size, batch size and segment writer (0 MEMORY_MAPPED, 1 DIRECT)
+static void BM_LogPool_WriteBatch(benchmark::State& state)
+{
+    LogPoolConfiguration configuration;
+    configuration.durability = Durability::GROUP_COMMIT;
+    configuration.is_compressed = false;
+    configuration.segment_writer = state.range(2) == 1 ? LogSegmentWriterType::DIRECT : LogSegmentWriterType::MEMORY_MAPPED;
+
+    size_t batch = static_cast<size_t>(state.range(1));
+    auto lines = makeLines(batch, static_cast<size_t>(state.range(0)));
+    {
+        LogPool pool{ configuration };
+        for (auto _ : state) {
+            pool.writeBatch(lines.data(), lines.size());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    state.SetBytesProcessed(state.iterations() * batch * state.range(0));
+}
+BENCHMARK(BM_LogPool_WriteBatch)
+    ->ArgNames({ "size", "batch", "writer" })
+    ->Args({ 32, 16, 0 })
+    ->Args({ 32, 256, 0 })
+    ->Args({ 512, 256, 0 })
+    ->Args({ 32, 256, 1 })
+    ->Args({ 512, 256, 1 })
+    ->UseRealTime();
+
+// A segment block of records as the compactor sees it
+static std::vector<char> makeBlock()
+{
+    std::vector<char> block(LogSegmentCompactor::BLOCK_SIZE);
+    size_t offset = 0;
+    size_t index = 0;
+    while (offset + LogRecord::MAX_SIZE <= block.size()) {
+        char content[64];
+        snprintf(content, sizeof(content), "request %zu finished in %zu us", index * 7919, index % 1000);
+        LogLine line{ "Benchmark::LogBlockCodec", "BENCH", LogColor::Green, content };
+        offset += LogRecord::encode(block.data() + offset, line);
+        index++;
+    }
+    block.resize(offset);
+    return block;
+}
+
+// LogBlockCodec::compress of one segment block
+static void BM_LogBlockCodec_Compress(benchmark::State& state)
+{
+    auto block = makeBlock();
+    std::vector<char> compressed(LogBlockCodec::getCompressBound(block.size()));
+    size_t size = 0;
+    for (auto _ : state) {
+        size = LogBlockCodec::compress(block.data(), block.size(), compressed.data(), compressed.size());
+        benchmark::DoNotOptimize(size);
+    }
+    state.SetBytesProcessed(state.iterations() * block.size());
+    state.counters["ratio"] = size ? static_cast<double>(block.size()) / size : 0;
+}
+BENCHMARK(BM_LogBlockCodec_Compress);
+
+// LogBlockCodec::decompress of one segment block
+static void BM_LogBlockCodec_Decompress(benchmark::State& state)
+{
+    auto block = makeBlock();
+    std::vector<char> compressed(LogBlockCodec::getCompressBound(block.size()));
+    size_t size = LogBlockCodec::compress(block.data(), block.size(), compressed.data(), compressed.size());
+    std::vector<char> raw(block.size());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LogBlockCodec::decompress(compressed.data(), size, raw.data(), raw.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * block.size());
+}
+BENCHMARK(BM_LogBlockCodec_Decompress);
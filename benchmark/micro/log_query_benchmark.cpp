@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include <log_query/log_content_matcher.hpp>
+
+#include <string>
+
+using namespace Bn3Monkey;
+
+// LogContentMatcher over a content without a match (the common case of a search) :
+// args are implementation (1 SCALAR, 2 SSE2, 3 AVX2) and content size
+static void BM_LogContentMatcher_Miss(benchmark::State& state)
+{
+    const auto implementation = static_cast<LogContentMatcher::Implementation>(state.range(0));
+    if (implementation > LogContentMatcher::getSupportedImplementation()) {
+        state.SkipWithError("not supported on this CPU");
+        return;
+    }
+
+    const std::string content(static_cast<size_t>(state.range(1)), 'x');
+    LogContentMatcher matcher{ { "needle", "xxxxy" }, implementation };
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matcher.matches(content.data(), content.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * content.size());
+}
+BENCHMARK(BM_LogContentMatcher_Miss)
+    ->ArgNames({ "impl", "bytes" })
+    ->Args({ 1, 64 })
+    ->Args({ 1, 900 })
+    ->Args({ 2, 64 })
+    ->Args({ 2, 900 })
+    ->Args({ 3, 64 })
+    ->Args({ 3, 900 });
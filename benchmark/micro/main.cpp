@@ -0,0 +1,31 @@
+// Microbenchmarks of the server hot paths.
+// LogPool writes segments into the working directory, so everything runs inside a scratch directory.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+
+int main(int argc, char** argv)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    fs::path directory = fs::temp_directory_path(error) / "simple_log_micro_benchmark";
+    fs::create_directories(directory, error);
+    fs::current_path(directory, error);
+    if (error) {
+        printf("[[SYSTEM]] Cannot use %s (%s)\n", directory.string().c_str(), error.message().c_str());
+        return -1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    fs::current_path(directory.parent_path(), error);
+    fs::remove_all(directory, error);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+
+#include <memory_mapped_file/memory_mapped_file.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace Bn3Monkey;
+
+// MemoryMappedFile::commit of a freshly dirtied range : args are range size in bytes and sync (0 SYNCHRONOUS, 1 ASYNCHRONOUS)
+static void BM_MemoryMappedFile_Commit(benchmark::State& state)
+{
+    constexpr size_t FILE_SIZE = 64 * 1024 * 1024;
+    const size_t length = static_cast<size_t>(state.range(0));
+    const auto sync = state.range(1) == 0 ? MemoryMappedFile::Sync::SYNCHRONOUS : MemoryMappedFile::Sync::ASYNCHRONOUS;
+
+    {
+        MemoryMappedFile file{ "memory_mapped_file_benchmark.bin", MemoryMappedFile::Access::READWRITE_WITH_CREATE, FILE_SIZE, MemoryMappedFile::HINT_PREALLOCATE };
+        if (!file) {
+            state.SkipWithError("cannot map file");
+            return;
+        }
+
+        size_t offset = 0;
+        for (auto _ : state) {
+            if (offset + length > file.size())
+                offset = 0;
+            memset(file.data() + offset, 'x', length);
+            file.commit(offset, length, sync);
+            offset += length;
+        }
+    }
+    std::remove("memory_mapped_file_benchmark.bin");
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_MemoryMappedFile_Commit)
+    ->ArgNames({ "bytes", "async" })
+    ->Args({ 4096, 0 })
+    ->Args({ 64 * 1024, 0 })
+    ->Args({ 1024 * 1024, 0 })
+    ->Args({ 4096, 1 })
+    ->Args({ 64 * 1024, 1 })
+    ->UseRealTime();
+
+// Page faults of a fresh segment, with and without HINT_POPULATE
+static void BM_MemoryMappedFile_FirstTouch(benchmark::State& state)
+{
+    constexpr size_t FILE_SIZE = 4 * 1024 * 1024;
+    const uint32_t hints = MemoryMappedFile::HINT_PREALLOCATE | (state.range(0) ? MemoryMappedFile::HINT_POPULATE : MemoryMappedFile::HINT_NONE);
+    const size_t page_size = MemoryMappedFile::getPageSize();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::remove("memory_mapped_file_benchmark.bin");
+        MemoryMappedFile file{ "memory_mapped_file_benchmark.bin", MemoryMappedFile::Access::READWRITE_WITH_CREATE, FILE_SIZE, hints };
+        state.ResumeTiming();
+
+        for (size_t offset = 0; offset < file.size(); offset += page_size)
+            file.data()[offset] = 'x';
+        benchmark::ClobberMemory();
+    }
+    std::remove("memory_mapped_file_benchmark.bin");
+    state.SetBytesProcessed(state.iterations() * FILE_SIZE);
+}
+BENCHMARK(BM_MemoryMappedFile_FirstTouch)->ArgName("populate")->Arg(0)->Arg(1)->UseRealTime();
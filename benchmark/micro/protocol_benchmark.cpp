@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+
+#include <simple_log_protocol.hpp>
+#include <log_pool/log_record.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+static std::string makeContent(size_t size)
+{
+    return std::string(size, 'x');
+}
+
+// LogHeader reads the clock and takes a sequence number on every construction
+static void BM_LogHeader_Construct(benchmark::State& state)
+{
+    for (auto _ : state) {
+        LogHeader header{ "Benchmark::LogHeader", "BENCH", LogColor::Blue };
+        benchmark::DoNotOptimize(header);
+    }
+}
+BENCHMARK(BM_LogHeader_Construct);
+
+// Display formatting of a timestamp. Within the same second only the milliseconds are formatted.
+static void BM_LogTimestamp_Format(benchmark::State& state)
+{
+    uint64_t timestamp = LogTimestamp::now();
+    char text[LogTimestamp::TEXT_SIZE + 1];
+    for (auto _ : state) {
+        LogTimestamp::format(timestamp, text);
+        benchmark::DoNotOptimize(text);
+        // state.range(0) : nanoseconds between consecutive timestamps
+        timestamp += static_cast<uint64_t>(state.range(0));
+    }
+}
+BENCHMARK(BM_LogTimestamp_Format)->Arg(1000)->Arg(1000000000);
+
+static void BM_LogHeader_UpgradeLegacyTime(benchmark::State& state)
+{
+    LogHeader legacy;
+    memcpy(legacy.magic, LogHeader::MAGIC, sizeof(legacy.magic));
+    memcpy(reinterpret_cast<char*>(&legacy) + LogHeader::OFFSET_LEGACY_DATE, "2024-01-02 03:04:05:678|", LogHeader::LEGACY_DATE_SIZE);
+    for (auto _ : state) {
+        LogHeader header = legacy;
+        header.upgradeLegacyTime();
+        benchmark::DoNotOptimize(header);
+    }
+}
+BENCHMARK(BM_LogHeader_UpgradeLegacyTime);
+
+static void BM_LogLine_Construct(benchmark::State& state)
+{
+    auto content = makeContent(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        LogLine line{ "Benchmark::LogLine", "BENCH", LogColor::Blue, content.c_str() };
+        benchmark::DoNotOptimize(line);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogLine_Construct)->Arg(16)->Arg(128)->Arg(512)->Arg(LogLine::CONTENT_SIZE - 1);
+
+static void BM_LogLine_IsValid(benchmark::State& state)
+{
+    LogLine line{ "Benchmark::LogLine", "BENCH", LogColor::Blue, "content" };
+    const char* header = reinterpret_cast<const char*>(&line.header);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(header);
+        bool is_valid = LogLine::isValid(header);
+        benchmark::DoNotOptimize(is_valid);
+    }
+}
+BENCHMARK(BM_LogLine_IsValid);
+
+static void BM_LogLine_GetPayloadSize(benchmark::State& state)
+{
+    LogLine line{ "Benchmark::LogLine", "BENCH", LogColor::Blue, "content" };
+    const char* header = reinterpret_cast<const char*>(&line.header);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(header);
+        size_t size = LogLine::getPayloadSize(header);
+        benchmark::DoNotOptimize(size);
+    }
+}
+BENCHMARK(BM_LogLine_GetPayloadSize);
+
+// Ingest check of a frame sent with FLAG_CHECKSUM (CRC32C over header and payload)
+static void BM_LogLine_IsIntact(benchmark::State& state)
+{
+    auto content = makeContent(static_cast<size_t>(state.range(0)));
+    LogLine line{ "Benchmark::LogLine", "BENCH", LogColor::Blue, content.c_str() };
+    line.seal();
+    const char* header = reinterpret_cast<const char*>(&line.header);
+    size_t payload_size = LogLine::getPayloadSize(header);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(header);
+        bool is_intact = LogLine::isIntact(header, line.content, payload_size);
+        benchmark::DoNotOptimize(is_intact);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(line.wireSize()));
+    state.SetLabel(LogChecksum::isAccelerated() ? "crc32 instruction" : "table");
+}
+BENCHMARK(BM_LogLine_IsIntact)->Arg(16)->Arg(128)->Arg(512)->Arg(LogLine::CONTENT_SIZE - 1);
+
+static void BM_LogChecksum_Software(benchmark::State& state)
+{
+    auto content = makeContent(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        uint32_t checksum = LogChecksum::computeSoftware(content.data(), content.size());
+        benchmark::DoNotOptimize(checksum);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogChecksum_Software)->Arg(128)->Arg(LogLine::SIZE);
+
+// Search for the next header after a damaged frame, over bytes that hold none
+static void BM_LogLine_FindHeader(benchmark::State& state)
+{
+    std::string data(static_cast<size_t>(state.range(0)), 'x');
+    for (auto _ : state) {
+        size_t offset = LogLine::findHeader(data.data(), data.size());
+        benchmark::DoNotOptimize(offset);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogLine_FindHeader)->Arg(LogLine::SIZE)->Arg(64 * 1024);
+
+// Encoding of a LogLine into its on-disk record (the per-line work of LogPool::append)
+static void BM_LogRecord_Encode(benchmark::State& state)
+{
+    auto content = makeContent(static_cast<size_t>(state.range(0)));
+    LogLine line{ "Benchmark::LogRecord", "BENCH", LogColor::Blue, content.c_str() };
+    std::vector<char> buffer(LogRecord::MAX_SIZE);
+    for (auto _ : state) {
+        size_t size = LogRecord::encode(buffer.data(), line);
+        benchmark::DoNotOptimize(size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LogRecord_Encode)->Arg(16)->Arg(128)->Arg(512)->Arg(LogLine::CONTENT_SIZE - 1);
+
+static void BM_LogRecord_Render(benchmark::State& state)
+{
+    auto content = makeContent(static_cast<size_t>(state.range(0)));
+    LogLine line{ "Benchmark::LogRecord", "BENCH", LogColor::Blue, content.c_str() };
+    std::vector<char> record(LogRecord::MAX_SIZE);
+    LogRecord::encode(record.data(), line);
+    std::vector<char> buffer(2 * LogLine::SIZE);
+    for (auto _ : state) {
+        size_t size = LogRecord{ record.data() }.render(buffer.data(), buffer.size());
+        benchmark::DoNotOptimize(size);
+    }
+}
+BENCHMARK(BM_LogRecord_Render)->Arg(16)->Arg(512);
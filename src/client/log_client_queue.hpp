@@ -0,0 +1,153 @@
+#ifndef __BN3MONKEY_LOG_CLIENT_QUEUE__
+#define __BN3MONKEY_LOG_CLIENT_QUEUE__
+
+#include <simple_log_protocol.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace Bn3Monkey
+{
+    // Single-producer single-consumer byte ring of wire frames (LogHeader + payload) owned by one application thread.
+    // Frames are written in their wire form, so the sender hands the ring memory to the socket as it is
+    // (at most two spans, when the data wraps around) without building LogLines.
+    class LogClientQueue
+    {
+    public:
+        explicit LogClientQueue(size_t capacity)
+        {
+            size_t size = LogLine::SIZE;
+            while (size < capacity)
+                size <<= 1;
+            _mask = size - 1;
+            // 처음 쓰는 로그가 page fault를 맞지 않도록 미리 채워 둔다
+            _data.reset(new char[size]());
+        }
+
+        LogClientQueue(const LogClientQueue&) = delete;
+        LogClientQueue& operator=(const LogClientQueue&) = delete;
+
+        // Producer : appends one frame. Returns false if there is no room until the sender catches up.
+        inline bool push(const LogHeader& header, const char* content, size_t content_size)
+        {
+            size_t frame_size = sizeof(LogHeader) + content_size + 1;
+            if (_mask + 1 - (_tail - _head.load(std::memory_order_acquire)) < frame_size)
+                return false;
+
+            write(_tail, &header, sizeof(LogHeader));
+            write(_tail + sizeof(LogHeader), content, content_size);
+            const char nul = '\0';
+            write(_tail + sizeof(LogHeader) + content_size, &nul, 1);
+
+            _tail += frame_size;
+            _staged.store(_tail, std::memory_order_release);
+            return true;
+        }
+        // Producer : bytes staged since the last call that returned non-zero, once they reach batch_bytes
+        inline size_t announce(size_t batch_bytes)
+        {
+            size_t unannounced = _tail - _announced;
+            if (unannounced < batch_bytes)
+                return 0;
+            _announced = _tail;
+            return unannounced;
+        }
+
+        // Consumer : staged bytes as up to two contiguous spans. Returns the number of spans.
+        inline size_t peek(const char* (&spans)[2], size_t (&sizes)[2]) const
+        {
+            size_t head = _head.load(std::memory_order_relaxed);
+            size_t staged = _staged.load(std::memory_order_acquire);
+            size_t size = staged - head;
+            if (size == 0)
+                return 0;
+
+            size_t begin = head & _mask;
+            size_t contiguous = _mask + 1 - begin;
+            spans[0] = _data.get() + begin;
+            if (size <= contiguous) {
+                sizes[0] = size;
+                return 1;
+            }
+            sizes[0] = contiguous;
+            spans[1] = _data.get();
+            sizes[1] = size - contiguous;
+            return 2;
+        }
+        // Consumer : releases bytes that were sent. Keeps track of where frames begin,
+        // so that a frame cut by a broken connection can be skipped (see dropPartialFrame).
+        inline void consume(size_t size)
+        {
+            size_t head = _head.load(std::memory_order_relaxed);
+            while (size > 0) {
+                if (_frame_remaining == 0)
+                    _frame_remaining = getFrameSize(head);
+                size_t taken = size < _frame_remaining ? size : _frame_remaining;
+                _frame_remaining -= taken;
+                head += taken;
+                size -= taken;
+            }
+            _head.store(head, std::memory_order_release);
+        }
+        // Consumer : true if only a part of the oldest frame has been sent
+        inline bool hasPartialFrame() const { return _frame_remaining > 0; }
+        // Consumer : discards the rest of a partly sent frame. A new connection has to start at a frame.
+        inline void dropPartialFrame()
+        {
+            if (_frame_remaining == 0)
+                return;
+            _head.store(_head.load(std::memory_order_relaxed) + _frame_remaining, std::memory_order_release);
+            _frame_remaining = 0;
+        }
+
+        inline size_t pending() const {
+            return _staged.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        }
+
+        // Either side is gone : the producer thread exited or the client was destroyed.
+        // The producer detaches after its last push, so a detached queue without pending bytes can be freed.
+        inline void detach() { _is_detached.store(true, std::memory_order_release); }
+        inline bool isDetached() const { return _is_detached.load(std::memory_order_acquire); }
+
+    private:
+        inline void write(size_t position, const void* src, size_t size)
+        {
+            size_t begin = position & _mask;
+            size_t contiguous = _mask + 1 - begin;
+            if (size <= contiguous) {
+                memcpy(_data.get() + begin, src, size);
+            }
+            else {
+                memcpy(_data.get() + begin, src, contiguous);
+                memcpy(_data.get(), static_cast<const char*>(src) + contiguous, size - contiguous);
+            }
+        }
+        inline size_t getFrameSize(size_t position) const
+        {
+            char header[LogHeader::OFFSET_PAYLOAD_SIZE + sizeof(uint32_t)];
+            for (size_t i = 0; i < sizeof(header); i++)
+                header[i] = _data[(position + i) & _mask];
+            uint32_t payload_size;
+            memcpy(&payload_size, header + LogHeader::OFFSET_PAYLOAD_SIZE, sizeof(payload_size));
+            return sizeof(LogHeader) + payload_size;
+        }
+
+        std::unique_ptr<char[]> _data;
+        size_t _mask{ 0 };
+
+        // producer only
+        alignas(64) size_t _tail{ 0 };
+        size_t _announced{ 0 };
+        // written by the producer, read by the consumer
+        alignas(64) std::atomic<size_t> _staged{ 0 };
+        // written by the consumer, read by the producer
+        alignas(64) std::atomic<size_t> _head{ 0 };
+        // consumer only
+        size_t _frame_remaining{ 0 };
+        std::atomic<bool> _is_detached{ false };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_CLIENT_QUEUE__
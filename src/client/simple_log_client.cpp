@@ -0,0 +1,549 @@
+#include "simple_log_client.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace Bn3Monkey;
+
+static std::atomic<uint64_t> next_client_id{ 1 };
+
+// a single send gathers at most this many spans (2 per thread)
+static constexpr size_t MAX_SPANS = 512;
+
+static std::atomic<SimpleLogClient*> default_client{ nullptr };
+
+// Format strings used by SLOG in this process, in the order they were first used
+struct LogFormatRegistry
+{
+	std::mutex mutex;
+	std::vector<std::pair<uint64_t, std::string>> formats;
+};
+static LogFormatRegistry& getFormatRegistry()
+{
+	static LogFormatRegistry registry;
+	return registry;
+}
+
+Bn3Monkey::SimpleLogClient::SimpleLogClient(const SimpleLogClientConfiguration& configuration) :
+	_configuration(configuration),
+	_id(next_client_id.fetch_add(1)),
+	_header(configuration.signature.c_str(), "", LogColor::Blue)
+{
+	if (_configuration.queue_capacity < LogLine::SIZE)
+		_configuration.queue_capacity = LogLine::SIZE;
+	if (_configuration.batch_bytes == 0)
+		_configuration.batch_bytes = 1;
+
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::SimpleLogClient::~SimpleLogClient()
+{
+	SimpleLogClient* self = this;
+	default_client.compare_exchange_strong(self, nullptr);
+
+	_is_running = false;
+	wake();
+	if (_thread.joinable())
+		_thread.join();
+
+	// 로그를 남긴 스레드의 캐시가 다음에 정리할 수 있도록 표시한다
+	{
+		std::lock_guard<std::mutex> lock(_queue_mutex);
+		for (auto& queue : _queues)
+			queue->detach();
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+bool Bn3Monkey::SimpleLogClient::log(const char* tag, LogColor color, const char* content)
+{
+	return log(tag, color, content, strnlen(content, LogLine::CONTENT_SIZE - 1));
+}
+
+bool Bn3Monkey::SimpleLogClient::log(const char* tag, LogColor color, const char* content, size_t size)
+{
+	return push(tag, color, 0, 0, content, size);
+}
+
+bool Bn3Monkey::SimpleLogClient::push(const char* tag, LogColor color, uint8_t flags, uint64_t format_id, const char* payload, size_t size)
+{
+	if (size > LogLine::CONTENT_SIZE - 1)
+		size = LogLine::CONTENT_SIZE - 1;
+
+	LogHeader header = _header;
+	memcpy(header.tag, tag, strnlen(tag, LogHeader::TAG_SIZE - 1));
+	header.color = color;
+	header.timestamp = LogTimestamp::now();
+	header.sequence = _sequence.fetch_add(1, std::memory_order_relaxed);
+	header.payload_size = static_cast<uint32_t>(size + 1);
+	header.flags = flags;
+	header.format_id = format_id;
+	if (_configuration.is_checksummed)
+		seal(header, payload, size);
+
+	auto* queue = getLocalQueue();
+	if (!queue->push(header, payload, size)) {
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		wake();
+		return false;
+	}
+	if (queue->announce(_configuration.batch_bytes) > 0)
+		wake();
+	return true;
+}
+
+void Bn3Monkey::SimpleLogClient::seal(LogHeader& header, const char* payload, size_t size)
+{
+	// payload 뒤에 붙여 보내는 NUL까지 포함한다
+	static constexpr char nul = '\0';
+	header.flags |= LogHeader::FLAG_CHECKSUM;
+	header.setChecksum(LogChecksum::compute(&nul, 1, LogChecksum::compute(payload, size, header.computeChecksum())));
+}
+
+bool Bn3Monkey::SimpleLogClient::logf(const char* tag, LogColor color, const char* format, ...)
+{
+	thread_local char content[LogLine::CONTENT_SIZE];
+
+	va_list args;
+	va_start(args, format);
+	int size = vsnprintf(content, sizeof(content), format, args);
+	va_end(args);
+	if (size < 0)
+		return false;
+
+	return log(tag, color, content, static_cast<size_t>(size));
+}
+
+void Bn3Monkey::SimpleLogClient::setDefault(SimpleLogClient* client)
+{
+	default_client.store(client, std::memory_order_release);
+}
+
+SimpleLogClient* Bn3Monkey::SimpleLogClient::getDefault()
+{
+	return default_client.load(std::memory_order_acquire);
+}
+
+bool Bn3Monkey::SimpleLogClient::define(uint64_t format_id, const char* format)
+{
+	auto& registry = getFormatRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (auto& defined : registry.formats) {
+		if (defined.first == format_id)
+			return true;
+	}
+	registry.formats.emplace_back(format_id, format);
+	return true;
+}
+
+bool Bn3Monkey::SimpleLogClient::flush(std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (pending() > 0) {
+		if (std::chrono::steady_clock::now() >= deadline)
+			return false;
+		wake();
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+	}
+	return true;
+}
+
+size_t Bn3Monkey::SimpleLogClient::pending()
+{
+	std::lock_guard<std::mutex> lock(_queue_mutex);
+	size_t ret = 0;
+	for (auto& queue : _queues)
+		ret += queue->pending();
+	return ret;
+}
+
+LogClientQueue* Bn3Monkey::SimpleLogClient::getLocalQueue()
+{
+	// 로그를 남기는 스레드마다 client별로 하나의 큐를 가진다.
+	// 스레드가 끝나면 큐를 detach해서 sender가 남은 로그를 보내고 해제하게 한다.
+	struct LocalQueues {
+		std::vector<std::pair<uint64_t, std::shared_ptr<LogClientQueue>>> entries;
+		~LocalQueues() {
+			for (auto& entry : entries)
+				entry.second->detach();
+		}
+	};
+	thread_local LocalQueues local;
+
+	for (auto& entry : local.entries) {
+		if (entry.first == _id)
+			return entry.second.get();
+	}
+
+	// 없어진 client의 큐는 여기서 놓는다
+	local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end(),
+		[](const std::pair<uint64_t, std::shared_ptr<LogClientQueue>>& entry) { return entry.second->isDetached(); }),
+		local.entries.end());
+
+	std::shared_ptr<LogClientQueue> queue{ new LogClientQueue(_configuration.queue_capacity) };
+	{
+		std::lock_guard<std::mutex> lock(_queue_mutex);
+		_queues.push_back(queue);
+		_queue_generation.fetch_add(1, std::memory_order_release);
+	}
+	local.entries.emplace_back(_id, queue);
+	return queue.get();
+}
+
+void Bn3Monkey::SimpleLogClient::wake()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_is_woken = true;
+	_cv.notify_one();
+}
+
+void Bn3Monkey::SimpleLogClient::run()
+{
+	std::vector<LogClientQueue*> queues;
+	uint64_t generation = 0;
+	auto refresh = [&]() {
+		if (generation == _queue_generation.load(std::memory_order_acquire))
+			return;
+		std::lock_guard<std::mutex> lock(_queue_mutex);
+		generation = _queue_generation.load(std::memory_order_relaxed);
+		queues.clear();
+		for (auto& queue : _queues)
+			queues.push_back(queue.get());
+	};
+	auto hasPending = [&]() {
+		for (auto* queue : queues) {
+			if (queue->pending() > 0)
+				return true;
+		}
+		return false;
+	};
+
+	auto next_connect = std::chrono::steady_clock::now();
+	while (_is_running) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (!_is_woken)
+				_cv.wait_for(lock, _configuration.flush_interval);
+			_is_woken = false;
+		}
+		refresh();
+
+		if (!_is_connected) {
+			// 서버가 없는 동안에는 큐에 쌓아 두고 주기적으로 다시 연결한다
+			auto now = std::chrono::steady_clock::now();
+			if (now < next_connect || !hasPending())
+				continue;
+			if (!connect()) {
+				next_connect = now + _configuration.reconnect_interval;
+				continue;
+			}
+		}
+
+		while (_is_running && hasPending()) {
+			if (!send(queues)) {
+				disconnect();
+				next_connect = std::chrono::steady_clock::now();
+				break;
+			}
+		}
+		collect(queues);
+	}
+
+	// 종료 전에 남은 로그를 close_timeout 동안 보내 본다
+	auto deadline = std::chrono::steady_clock::now() + _configuration.close_timeout;
+	generation = 0;
+	refresh();
+	while (hasPending() && std::chrono::steady_clock::now() < deadline) {
+		if (!_is_connected && !connect()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+			continue;
+		}
+		if (!send(queues))
+			disconnect();
+	}
+	disconnect();
+}
+
+bool Bn3Monkey::SimpleLogClient::connect()
+{
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	std::string port = std::to_string(_configuration.port);
+	if (getaddrinfo(_configuration.host.c_str(), port.c_str(), &hints, &result) != 0)
+		return false;
+
+	for (addrinfo* address = result; address; address = address->ai_next) {
+#ifdef _WIN32
+		SOCKET sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (sock == INVALID_SOCKET)
+			continue;
+		if (::connect(sock, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0) {
+			closesocket(sock);
+			continue;
+		}
+		DWORD timeout = 100;
+		setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+#else
+		int sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (sock < 0)
+			continue;
+		if (::connect(sock, address->ai_addr, address->ai_addrlen) != 0) {
+			::close(sock);
+			continue;
+		}
+		// 서버가 받지 못하는 동안에도 종료 요청을 확인할 수 있게 한다
+		timeval timeout{};
+		timeout.tv_usec = 100 * 1000;
+		setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+		int on = 1;
+		setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#endif
+		int nodelay = 1;
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nodelay), sizeof(nodelay));
+
+		_socket = static_cast<intptr_t>(sock);
+		_is_connected = true;
+		break;
+	}
+
+	freeaddrinfo(result);
+	return _is_connected;
+}
+
+void Bn3Monkey::SimpleLogClient::disconnect()
+{
+	if (_socket >= 0) {
+#ifdef _WIN32
+		closesocket(static_cast<SOCKET>(_socket));
+#else
+		::close(static_cast<int>(_socket));
+#endif
+		_socket = -1;
+	}
+	_is_connected = false;
+
+	// 중간까지 보낸 프레임은 새 연결에서 이어 보낼 수 없다
+	std::lock_guard<std::mutex> lock(_queue_mutex);
+	for (auto& queue : _queues)
+		queue->dropPartialFrame();
+	_resume_queue = 0;
+	// 새 연결(서버가 재시작되었을 수도 있다)에는 포맷 문자열을 다시 보낸다
+	_definition_count = 0;
+}
+
+bool Bn3Monkey::SimpleLogClient::isPeerClosed()
+{
+	char buffer[64];
+#ifdef _WIN32
+	SOCKET sock = static_cast<SOCKET>(_socket);
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(sock, &readable);
+	timeval timeout{};
+	if (select(0, &readable, nullptr, nullptr, &timeout) <= 0)
+		return false;
+	return recv(sock, buffer, sizeof(buffer), 0) <= 0;
+#else
+	ssize_t result = recv(static_cast<int>(_socket), buffer, sizeof(buffer), MSG_DONTWAIT);
+	if (result < 0)
+		return errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR;
+	return result == 0;
+#endif
+}
+
+bool Bn3Monkey::SimpleLogClient::send(const std::vector<LogClientQueue*>& queues)
+{
+	if (queues.empty())
+		return true;
+
+	// 여러 스레드의 큐를 한 번의 vectored send로 보낸다
+	const char* spans[MAX_SPANS];
+	size_t sizes[MAX_SPANS];
+	size_t owners[MAX_SPANS];
+	size_t count = 0;
+	size_t start = _resume_queue % queues.size();
+	for (size_t i = 0; i < queues.size() && count + 2 <= MAX_SPANS; i++) {
+		size_t index = (start + i) % queues.size();
+		const char* queue_spans[2];
+		size_t queue_sizes[2];
+		size_t n = queues[index]->peek(queue_spans, queue_sizes);
+		for (size_t j = 0; j < n; j++) {
+			spans[count] = queue_spans[j];
+			sizes[count] = queue_sizes[j];
+			owners[count] = index;
+			count++;
+		}
+	}
+	if (count == 0)
+		return true;
+
+	// 서버는 아무것도 보내지 않으므로 읽을 것이 있다면 연결이 끊긴 것이다.
+	// 끊긴 연결에 보낸 로그는 RST를 받기 전까지 오류 없이 사라진다.
+	if (isPeerClosed())
+		return false;
+	// 큐를 본 뒤에 확인해야 방금 본 로그가 쓰는 포맷 문자열까지 보인다
+	if (!sendDefinitions())
+		return false;
+
+	size_t sent = 0;
+#ifdef _WIN32
+	WSABUF buffers[MAX_SPANS];
+	for (size_t i = 0; i < count; i++) {
+		buffers[i].buf = const_cast<char*>(spans[i]);
+		buffers[i].len = static_cast<ULONG>(sizes[i]);
+	}
+	DWORD result = 0;
+	if (WSASend(static_cast<SOCKET>(_socket), buffers, static_cast<DWORD>(count), &result, 0, nullptr, nullptr) != 0) {
+		int error = WSAGetLastError();
+		return error == WSAETIMEDOUT || error == WSAEWOULDBLOCK;
+	}
+	sent = result;
+#else
+	iovec buffers[MAX_SPANS];
+	for (size_t i = 0; i < count; i++) {
+		buffers[i].iov_base = const_cast<char*>(spans[i]);
+		buffers[i].iov_len = sizes[i];
+	}
+	msghdr message{};
+	message.msg_iov = buffers;
+	message.msg_iovlen = count;
+#ifdef MSG_NOSIGNAL
+	ssize_t result = sendmsg(static_cast<int>(_socket), &message, MSG_NOSIGNAL);
+#else
+	ssize_t result = sendmsg(static_cast<int>(_socket), &message, 0);
+#endif
+	if (result < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	sent = static_cast<size_t>(result);
+#endif
+
+	// 보낸 만큼 큐를 비우고, 프레임 중간에서 멈췄으면 다음에는 그 큐부터 보낸다
+	_resume_queue = (start + 1) % queues.size();
+	for (size_t i = 0; i < count && sent > 0; i++) {
+		size_t taken = sent < sizes[i] ? sent : sizes[i];
+		queues[owners[i]]->consume(taken);
+		sent -= taken;
+		if (queues[owners[i]]->hasPartialFrame())
+			_resume_queue = owners[i];
+	}
+	return true;
+}
+
+void Bn3Monkey::SimpleLogClient::collect(std::vector<LogClientQueue*>& queues)
+{
+	// 끝난 스레드의 큐는 다 보낸 뒤에 해제한다
+	bool has_detached = false;
+	for (auto* queue : queues) {
+		if (queue->isDetached() && queue->pending() == 0) {
+			has_detached = true;
+			break;
+		}
+	}
+	if (!has_detached)
+		return;
+
+	LogClientQueue* resume_queue = queues.empty() ? nullptr : queues[_resume_queue % queues.size()];
+
+	std::lock_guard<std::mutex> lock(_queue_mutex);
+	_queues.erase(std::remove_if(_queues.begin(), _queues.end(),
+		[](const std::shared_ptr<LogClientQueue>& queue) { return queue->isDetached() && queue->pending() == 0; }),
+		_queues.end());
+	_queue_generation.fetch_add(1, std::memory_order_relaxed);
+
+	// 프레임 중간에서 멈춘 큐는 비어 있지 않으므로 남아 있다
+	queues.clear();
+	_resume_queue = 0;
+	for (auto& queue : _queues) {
+		if (queue.get() == resume_queue)
+			_resume_queue = queues.size();
+		queues.push_back(queue.get());
+	}
+}
+
+bool Bn3Monkey::SimpleLogClient::sendDefinitions()
+{
+	std::string frames;
+	size_t count = 0;
+	{
+		auto& registry = getFormatRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		count = registry.formats.size();
+		for (size_t i = _definition_count; i < count; i++) {
+			auto& format = registry.formats[i];
+			size_t size = format.second.size() < LogLine::CONTENT_SIZE - 1 ? format.second.size() : LogLine::CONTENT_SIZE - 1;
+
+			LogHeader header = _header;
+			header.timestamp = LogTimestamp::now();
+			header.payload_size = static_cast<uint32_t>(size + 1);
+			header.flags = LogHeader::FLAG_FORMAT_DEFINITION;
+			header.format_id = format.first;
+			if (_configuration.is_checksummed)
+				seal(header, format.second.data(), size);
+			frames.append(reinterpret_cast<const char*>(&header), sizeof(header));
+			frames.append(format.second.data(), size);
+			frames.push_back('\0');
+		}
+	}
+
+	// 드물게 일어나므로 다 보낼 때까지 기다린다.
+	// 서버가 받지 않으면 종료 요청 뒤 close_timeout까지만 기다린다.
+	auto deadline = std::chrono::steady_clock::now() + _configuration.close_timeout;
+	auto isWaiting = [&]() { return _is_running || std::chrono::steady_clock::now() < deadline; };
+	const char* data = frames.data();
+	size_t remaining = frames.size();
+	while (remaining > 0) {
+#ifdef _WIN32
+		int result = ::send(static_cast<SOCKET>(_socket), data, static_cast<int>(remaining), 0);
+		if (result <= 0) {
+			int error = WSAGetLastError();
+			if (result < 0 && (error == WSAETIMEDOUT || error == WSAEWOULDBLOCK) && isWaiting())
+				continue;
+			return false;
+		}
+#else
+#ifdef MSG_NOSIGNAL
+		ssize_t result = ::send(static_cast<int>(_socket), data, remaining, MSG_NOSIGNAL);
+#else
+		ssize_t result = ::send(static_cast<int>(_socket), data, remaining, 0);
+#endif
+		if (result <= 0) {
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) && isWaiting())
+				continue;
+			return false;
+		}
+#endif
+		data += result;
+		remaining -= static_cast<size_t>(result);
+	}
+	_definition_count = count;
+	return true;
+}
@@ -0,0 +1,160 @@
+#ifndef __BN3MONKEY_SIMPLE_LOG_CLIENT__
+#define __BN3MONKEY_SIMPLE_LOG_CLIENT__
+
+#include <simple_log_protocol.hpp>
+#include <simple_log_format.hpp>
+#include "log_client_queue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    struct SimpleLogClientConfiguration
+    {
+        std::string host{ "127.0.0.1" };
+        uint32_t port{ 13579 };
+        // signature of every log sent by this client
+        std::string signature{ "SimpleLogClient" };
+        // bytes of frames each thread can queue. This is also what is kept while the server is unavailable,
+        // logs beyond it are dropped.
+        size_t queue_capacity{ 1024 * 1024 };
+        // a thread wakes the sender up every batch_bytes
+        size_t batch_bytes{ 64 * 1024 };
+        // queued logs are sent at least this often
+        std::chrono::milliseconds flush_interval{ 5 };
+        std::chrono::milliseconds reconnect_interval{ 1000 };
+        // how long the destructor keeps trying to send what is still queued
+        std::chrono::milliseconds close_timeout{ 1000 };
+        // send a CRC32C with every frame (LogHeader::FLAG_CHECKSUM), so that the server rejects damaged ones
+        bool is_checksummed{ false };
+    };
+
+    // Sends logs to a SimpleLogServer without making the calling thread wait for the network.
+    // Every thread writes wire frames into its own LogClientQueue, and a sender thread gathers the queues
+    // of all threads into one vectored send. While the server is unavailable, logs stay queued and the
+    // sender reconnects every reconnect_interval.
+    class SimpleLogClient
+    {
+    public:
+        explicit SimpleLogClient(const SimpleLogClientConfiguration& configuration = SimpleLogClientConfiguration{});
+        ~SimpleLogClient();
+
+        SimpleLogClient(const SimpleLogClient&) = delete;
+        SimpleLogClient& operator=(const SimpleLogClient&) = delete;
+
+        // Returns false if the log was dropped because the queue of this thread is full
+        bool log(const char* tag, LogColor color, const char* content);
+        bool log(const char* tag, LogColor color, const char* content, size_t size);
+        // printf-style content
+        bool logf(const char* tag, LogColor color, const char* format, ...);
+        // Deferred formatting, use SLOG or SLOG_TO instead.
+        // Only the id of the format string and the arguments in binary are queued, the server formats the content.
+        template<typename Format, typename... Arguments>
+        bool print(Format format, const char* tag, LogColor color, const Arguments&... arguments);
+
+        // Client used by SLOG
+        static void setDefault(SimpleLogClient* client);
+        static SimpleLogClient* getDefault();
+
+        // Waits until the logs queued so far are sent. Returns false on timeout.
+        bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds{ 1000 });
+
+        inline bool isConnected() const { return _is_connected.load(std::memory_order_relaxed); }
+        inline uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+        size_t pending();
+
+    private:
+        bool push(const char* tag, LogColor color, uint8_t flags, uint64_t format_id, const char* payload, size_t size);
+        // Sets FLAG_CHECKSUM and the checksum of a frame whose payload is the size bytes at payload and a NUL
+        static void seal(LogHeader& header, const char* payload, size_t size);
+        // Registers a format string of the process once. Its definition is sent before any log that uses it.
+        static bool define(uint64_t format_id, const char* format);
+        // Returns false if the connection was lost
+        bool sendDefinitions();
+
+        LogClientQueue* getLocalQueue();
+        void wake();
+        void run();
+        bool connect();
+        void disconnect();
+        bool isPeerClosed();
+        // Returns false if the connection was lost
+        bool send(const std::vector<LogClientQueue*>& queues);
+        // Frees the drained queues of threads that exited
+        void collect(std::vector<LogClientQueue*>& queues);
+
+        SimpleLogClientConfiguration _configuration;
+        uint64_t _id;
+        // signature and version filled in once, copied for every log
+        LogHeader _header;
+        std::atomic<uint64_t> _sequence{ 0 };
+
+        std::mutex _queue_mutex;
+        // shared with the thread_local caches of the logging threads, see getLocalQueue
+        std::vector<std::shared_ptr<LogClientQueue>> _queues;
+        std::atomic<uint64_t> _queue_generation{ 0 };
+        // queue that has to be sent first, because the last send stopped in the middle of its frame
+        size_t _resume_queue{ 0 };
+        // format strings already sent on this connection
+        size_t _definition_count{ 0 };
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _is_woken{ false };
+
+        intptr_t _socket{ -1 };
+        std::atomic<bool> _is_connected{ false };
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<bool> _is_running{ true };
+        std::thread _thread;
+    };
+
+    template<typename Format, typename... Arguments>
+    inline bool SimpleLogClient::print(Format format, const char* tag, LogColor color, const Arguments&... arguments)
+    {
+        constexpr const char* text = format();
+        constexpr size_t placeholder_count = LogFormat::countPlaceholders(text);
+        static_assert(placeholder_count != LogFormat::INVALID, "SLOG format has a brace that is neither {} nor escaped");
+        static_assert(placeholder_count == sizeof...(Arguments), "SLOG format and arguments do not match");
+        constexpr uint64_t format_id = LogFormat::hash(text);
+
+        // 호출 위치마다 한 번만 등록한다
+        static const bool is_defined = define(format_id, text);
+        (void)is_defined;
+
+        char payload[LogLine::CONTENT_SIZE - 1];
+        char* output = payload;
+        const char* end = payload + sizeof(payload);
+        auto encode = [&](const auto& argument) {
+            if (char* next = LogFormat::encode(output, end, argument))
+                output = next;
+            else
+                end = output;
+        };
+        (encode(arguments), ...);
+        (void)encode;
+
+        return push(tag, color, LogHeader::FLAG_FORMATTED, format_id, payload, static_cast<size_t>(output - payload));
+    }
+}
+
+// SLOG("TAG", LogColor::Green, "request {} finished in {} us", id, elapsed);
+// The format string is checked against the arguments at compile time. Does nothing without a default client.
+#define SLOG(tag, color, format, ...) \
+    do { \
+        if (auto* __slog_client = ::Bn3Monkey::SimpleLogClient::getDefault()) \
+            SLOG_TO(*__slog_client, tag, color, format, ##__VA_ARGS__); \
+    } while (false)
+
+#define SLOG_TO(client, tag, color, format, ...) \
+    (client).print([]() constexpr { return format; }, tag, color, ##__VA_ARGS__)
+
+#endif // __BN3MONKEY_SIMPLE_LOG_CLIENT__
@@ -0,0 +1,147 @@
+#include "simple_log_checksum.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMPLE_LOG_CHECKSUM_SSE42
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <nmmintrin.h>
+#else
+#include <nmmintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define SIMPLE_LOG_CHECKSUM_ARMV8
+#include <arm_acle.h>
+#endif
+
+using namespace Bn3Monkey;
+
+namespace
+{
+	// reflected polynomial of CRC32C
+	constexpr uint32_t POLYNOMIAL = 0x82F63B78u;
+
+	struct Tables
+	{
+		uint32_t values[8][256];
+
+		Tables()
+		{
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+					crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+				values[0][i] = crc;
+			}
+			for (uint32_t i = 0; i < 256; i++) {
+				for (size_t table = 1; table < 8; table++)
+					values[table][i] = (values[table - 1][i] >> 8) ^ values[0][values[table - 1][i] & 0xFF];
+			}
+		}
+	};
+
+	const Tables& getTables()
+	{
+		static const Tables tables;
+		return tables;
+	}
+
+	uint32_t updateSoftware(const uint8_t* data, size_t size, uint32_t crc)
+	{
+		auto& t = getTables().values;
+		// 8바이트씩 한 번에 표 8개를 찾는다 (little endian 기준)
+		while (size >= 8) {
+			uint32_t low;
+			uint32_t high;
+			memcpy(&low, data, sizeof(low));
+			memcpy(&high, data + 4, sizeof(high));
+			low ^= crc;
+			crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+				^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+			data += 8;
+			size -= 8;
+		}
+		while (size-- > 0)
+			crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+		return crc;
+	}
+
+#if defined(SIMPLE_LOG_CHECKSUM_SSE42)
+#if !defined(_MSC_VER)
+	__attribute__((target("sse4.2")))
+#endif
+	uint32_t updateHardware(const uint8_t* data, size_t size, uint32_t crc)
+	{
+		uint64_t crc64 = crc;
+		while (size >= 8) {
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			crc64 = _mm_crc32_u64(crc64, value);
+			data += 8;
+			size -= 8;
+		}
+		crc = static_cast<uint32_t>(crc64);
+		while (size-- > 0)
+			crc = _mm_crc32_u8(crc, *data++);
+		return crc;
+	}
+
+	bool detectHardware()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 20)) != 0;
+#else
+		return __builtin_cpu_supports("sse4.2");
+#endif
+	}
+#elif defined(SIMPLE_LOG_CHECKSUM_ARMV8)
+	uint32_t updateHardware(const uint8_t* data, size_t size, uint32_t crc)
+	{
+		while (size >= 8) {
+			uint64_t value;
+			memcpy(&value, data, sizeof(value));
+			crc = __crc32cd(crc, value);
+			data += 8;
+			size -= 8;
+		}
+		while (size-- > 0)
+			crc = __crc32cb(crc, *data++);
+		return crc;
+	}
+
+	bool detectHardware()
+	{
+		return true;
+	}
+#else
+	uint32_t updateHardware(const uint8_t* data, size_t size, uint32_t crc)
+	{
+		return updateSoftware(data, size, crc);
+	}
+
+	bool detectHardware()
+	{
+		return false;
+	}
+#endif
+}
+
+uint32_t Bn3Monkey::LogChecksum::compute(const void* data, size_t size, uint32_t crc)
+{
+	static const bool is_accelerated = detectHardware();
+	auto* bytes = static_cast<const uint8_t*>(data);
+	return ~(is_accelerated ? updateHardware(bytes, size, ~crc) : updateSoftware(bytes, size, ~crc));
+}
+
+uint32_t Bn3Monkey::LogChecksum::computeSoftware(const void* data, size_t size, uint32_t crc)
+{
+	return ~updateSoftware(static_cast<const uint8_t*>(data), size, ~crc);
+}
+
+bool Bn3Monkey::LogChecksum::isAccelerated()
+{
+	return detectHardware();
+}
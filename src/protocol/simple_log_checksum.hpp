@@ -0,0 +1,24 @@
+#if !defined(__SIMPLE_LOG_CHECKSUM__)
+#define __SIMPLE_LOG_CHECKSUM__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Bn3Monkey
+{
+    // CRC32C (Castagnoli), the checksum of iSCSI, SCTP and ext4 metadata.
+    // Computed with the crc32 instructions of SSE4.2 (x86-64, detected at runtime) or ARMv8 when available,
+    // and with slicing-by-8 tables otherwise. Both give the same values.
+    class LogChecksum
+    {
+    public:
+        // CRC32C of size bytes. Pass the previous result as crc to continue over another range:
+        // compute(b, m, compute(a, n)) is the CRC32C of a followed by b.
+        static uint32_t compute(const void* data, size_t size, uint32_t crc = 0);
+        // Table-driven path only (for comparison with the accelerated one)
+        static uint32_t computeSoftware(const void* data, size_t size, uint32_t crc = 0);
+        static bool isAccelerated();
+    };
+}
+
+#endif // __SIMPLE_LOG_CHECKSUM__
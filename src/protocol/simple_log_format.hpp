@@ -0,0 +1,252 @@
+#ifndef __BN3MONKEY_SIMPLE_LOG_FORMAT__
+#define __BN3MONKEY_SIMPLE_LOG_FORMAT__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Bn3Monkey
+{
+    // Deferred formatting.
+    // A client sends the id of a format string and the arguments in binary (type + value), and the server expands
+    // them into the content with the format string the client sent ahead of them (LogHeader::FLAG_FORMAT_DEFINITION).
+    // Format strings only know "{}" placeholders. "{{" and "}}" are literal braces.
+    class LogFormat
+    {
+    public:
+        static constexpr size_t INVALID = static_cast<size_t>(-1);
+
+        enum class ArgumentType : uint8_t
+        {
+            BOOL = 1,
+            CHAR,
+            INT,
+            UINT,
+            DOUBLE,
+            STRING,
+            POINTER,
+        };
+
+        // FNV-1a, so that the id of a format string is known at compile time
+        static constexpr uint64_t hash(const char* format)
+        {
+            uint64_t ret = 14695981039346656037ull;
+            for (; *format; format++) {
+                ret ^= static_cast<uint8_t>(*format);
+                ret *= 1099511628211ull;
+            }
+            return ret;
+        }
+
+        // Number of "{}" in format, or INVALID if a brace is neither a placeholder nor escaped
+        static constexpr size_t countPlaceholders(const char* format)
+        {
+            size_t ret = 0;
+            for (; *format; format++) {
+                if (*format == '{') {
+                    if (format[1] == '{' || format[1] == '}') {
+                        ret += format[1] == '}';
+                        format++;
+                        continue;
+                    }
+                    return INVALID;
+                }
+                if (*format == '}') {
+                    if (format[1] != '}')
+                        return INVALID;
+                    format++;
+                }
+            }
+            return ret;
+        }
+
+        // Appends value to [output, end). Returns the end of what was written, or nullptr if it does not fit.
+        template<typename T>
+        static inline char* encode(char* output, const char* end, const T& value)
+        {
+            using Type = std::decay_t<T>;
+            if constexpr (std::is_same_v<Type, bool>) {
+                uint8_t raw = value ? 1 : 0;
+                return put(output, end, ArgumentType::BOOL, &raw, sizeof(raw));
+            }
+            else if constexpr (std::is_same_v<Type, char>) {
+                return put(output, end, ArgumentType::CHAR, &value, sizeof(value));
+            }
+            else if constexpr (std::is_enum_v<Type>) {
+                return encode(output, end, static_cast<std::underlying_type_t<Type>>(value));
+            }
+            else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+                int64_t raw = static_cast<int64_t>(value);
+                return put(output, end, ArgumentType::INT, &raw, sizeof(raw));
+            }
+            else if constexpr (std::is_integral_v<Type>) {
+                uint64_t raw = static_cast<uint64_t>(value);
+                return put(output, end, ArgumentType::UINT, &raw, sizeof(raw));
+            }
+            else if constexpr (std::is_floating_point_v<Type>) {
+                double raw = static_cast<double>(value);
+                return put(output, end, ArgumentType::DOUBLE, &raw, sizeof(raw));
+            }
+            else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) {
+                return putString(output, end, value, strnlen(value, std::extent_v<T>));
+            }
+            else if constexpr (std::is_same_v<Type, const char*> || std::is_same_v<Type, char*>) {
+                const char* text = value ? static_cast<const char*>(value) : "(null)";
+                return putString(output, end, text, strlen(text));
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                std::string_view text = value;
+                return putString(output, end, text.data(), text.size());
+            }
+            else if constexpr (std::is_pointer_v<Type>) {
+                uint64_t raw = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+                return put(output, end, ArgumentType::POINTER, &raw, sizeof(raw));
+            }
+            else {
+                static_assert(std::is_void_v<T> && !std::is_void_v<T>, "SLOG arguments are numbers, chars, strings or pointers");
+                return nullptr;
+            }
+        }
+
+        // Writes format with its placeholders replaced by arguments (as encoded above) and a terminating NUL.
+        // Returns the length of the text.
+        static inline size_t expand(const char* format, const char* arguments, size_t arguments_size, char* output, size_t output_size)
+        {
+            if (output_size == 0)
+                return 0;
+
+            const char* end = arguments + arguments_size;
+            size_t size = 0;
+            auto append = [&](const char* text, size_t length) {
+                size_t room = output_size - 1 - size;
+                if (length > room)
+                    length = room;
+                memcpy(output + size, text, length);
+                size += length;
+            };
+
+            for (; *format && size < output_size - 1; format++) {
+                if ((format[0] == '{' && format[1] == '{') || (format[0] == '}' && format[1] == '}')) {
+                    append(format, 1);
+                    format++;
+                    continue;
+                }
+                if (format[0] != '{' || format[1] != '}') {
+                    append(format, 1);
+                    continue;
+                }
+                format++;
+
+                if (end - arguments < 1) {
+                    append("{}", 2);
+                    continue;
+                }
+                char text[32];
+                auto type = static_cast<ArgumentType>(*arguments++);
+                switch (type) {
+                case ArgumentType::BOOL:
+                case ArgumentType::CHAR:
+                    if (end - arguments < 1) {
+                        arguments = end;
+                        break;
+                    }
+                    if (type == ArgumentType::BOOL)
+                        *arguments ? append("true", 4) : append("false", 5);
+                    else
+                        append(arguments, 1);
+                    arguments++;
+                    break;
+                case ArgumentType::STRING: {
+                    uint16_t length = 0;
+                    if (end - arguments < static_cast<ptrdiff_t>(sizeof(length))) {
+                        arguments = end;
+                        break;
+                    }
+                    memcpy(&length, arguments, sizeof(length));
+                    arguments += sizeof(length);
+                    if (end - arguments < length)
+                        length = static_cast<uint16_t>(end - arguments);
+                    append(arguments, length);
+                    arguments += length;
+                    break;
+                }
+                case ArgumentType::INT:
+                case ArgumentType::UINT:
+                case ArgumentType::DOUBLE:
+                case ArgumentType::POINTER: {
+                    uint64_t raw = 0;
+                    if (end - arguments < static_cast<ptrdiff_t>(sizeof(raw))) {
+                        arguments = end;
+                        break;
+                    }
+                    memcpy(&raw, arguments, sizeof(raw));
+                    arguments += sizeof(raw);
+
+                    int length = 0;
+                    if (type == ArgumentType::INT) {
+                        length = snprintf(text, sizeof(text), "%lld", static_cast<long long>(static_cast<int64_t>(raw)));
+                    }
+                    else if (type == ArgumentType::UINT) {
+                        length = snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(raw));
+                    }
+                    else if (type == ArgumentType::DOUBLE) {
+                        double value;
+                        memcpy(&value, &raw, sizeof(value));
+                        // 다시 읽었을 때 같은 값이 되는 가장 짧은 표현을 쓴다
+                        length = snprintf(text, sizeof(text), "%.15g", value);
+                        if (strtod(text, nullptr) != value)
+                            length = snprintf(text, sizeof(text), "%.17g", value);
+                    }
+                    else {
+                        length = snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(raw));
+                    }
+                    if (length > 0)
+                        append(text, static_cast<size_t>(length) < sizeof(text) ? static_cast<size_t>(length) : sizeof(text) - 1);
+                    break;
+                }
+                default:
+                    // 알 수 없는 타입 뒤의 인자는 해석할 수 없다
+                    arguments = end;
+                    append("{?}", 3);
+                    break;
+                }
+            }
+            output[size] = '\0';
+            return size;
+        }
+
+    private:
+        static inline char* put(char* output, const char* end, ArgumentType type, const void* value, size_t size)
+        {
+            if (end - output < static_cast<ptrdiff_t>(1 + size))
+                return nullptr;
+            *output++ = static_cast<char>(type);
+            memcpy(output, value, size);
+            return output + size;
+        }
+        // Cut to the room left, so that a long string does not drop the whole log
+        static inline char* putString(char* output, const char* end, const char* text, size_t size)
+        {
+            constexpr size_t OVERHEAD = 1 + sizeof(uint16_t);
+            if (end - output < static_cast<ptrdiff_t>(OVERHEAD))
+                return nullptr;
+            size_t room = static_cast<size_t>(end - output) - OVERHEAD;
+            if (size > room)
+                size = room;
+            if (size > UINT16_MAX)
+                size = UINT16_MAX;
+            uint16_t length = static_cast<uint16_t>(size);
+            *output++ = static_cast<char>(ArgumentType::STRING);
+            memcpy(output, &length, sizeof(length));
+            memcpy(output + sizeof(length), text, size);
+            return output + sizeof(length) + size;
+        }
+    };
+}
+
+#endif // __BN3MONKEY_SIMPLE_LOG_FORMAT__
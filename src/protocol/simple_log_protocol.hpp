@@ -20,9 +20,14 @@
     #error "Unsupported compiler"
 #endif
 
+#include "simple_log_checksum.hpp"
+
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <atomic>
 #include <chrono>
+#include <ctime>
 
 namespace Bn3Monkey
 {
@@ -49,75 +54,229 @@ namespace Bn3Monkey
     
 
 
+    // Log time is carried as nanoseconds since the Unix epoch and only turned into text for display.
+    // Formatting and parsing cache the calendar part of the last second per thread,
+    // so consecutive logs only pay for the milliseconds.
+    class LogTimestamp
+    {
+    public:
+        static constexpr char FORMAT[] = "YYYY-MM-DD HH:MM:SS:mmm";
+        static constexpr size_t TEXT_SIZE = sizeof(FORMAT) - 1; // 23
+        static constexpr size_t SECOND_TEXT_SIZE = TEXT_SIZE - 4; // "YYYY-MM-DD HH:MM:SS"
+
+        static inline uint64_t now() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        // Writes "YYYY-MM-DD HH:MM:SS:mmm" (local time) and a terminating NUL into buffer
+        static inline void format(uint64_t timestamp, char (&buffer)[TEXT_SIZE + 1]) {
+            struct Cache {
+                int64_t second{ -1 };
+                char text[SECOND_TEXT_SIZE + 1]{ 0 };
+            };
+            thread_local Cache cache;
+
+            const int64_t second = static_cast<int64_t>(timestamp / 1000000000ull);
+            const int ms = static_cast<int>(timestamp / 1000000ull % 1000);
+
+            if (second != cache.second) {
+                std::time_t tt = static_cast<std::time_t>(second);
+                std::tm tmv{};
+#if defined(_WIN32)
+                localtime_s(&tmv, &tt);
+#else
+                localtime_r(&tt, &tmv);
+#endif
+                snprintf(cache.text, sizeof(cache.text), "%04u-%02u-%02u %02u:%02u:%02u",
+                    static_cast<unsigned>(tmv.tm_year + 1900) % 10000u,
+                    static_cast<unsigned>(tmv.tm_mon + 1) % 100u,
+                    static_cast<unsigned>(tmv.tm_mday) % 100u,
+                    static_cast<unsigned>(tmv.tm_hour) % 100u,
+                    static_cast<unsigned>(tmv.tm_min) % 100u,
+                    static_cast<unsigned>(tmv.tm_sec) % 100u);
+                cache.second = second;
+            }
+
+            memcpy(buffer, cache.text, SECOND_TEXT_SIZE);
+            buffer[SECOND_TEXT_SIZE] = ':';
+            buffer[SECOND_TEXT_SIZE + 1] = static_cast<char>('0' + ms / 100);
+            buffer[SECOND_TEXT_SIZE + 2] = static_cast<char>('0' + ms / 10 % 10);
+            buffer[SECOND_TEXT_SIZE + 3] = static_cast<char>('0' + ms % 10);
+            buffer[TEXT_SIZE] = '\0';
+        }
+
+        // Inverse of format. Returns 0 if text is not a date in that shape.
+        static inline uint64_t parse(const char* text, size_t size) {
+            struct Cache {
+                char text[SECOND_TEXT_SIZE]{ 0 };
+                int64_t second{ -1 };
+            };
+            thread_local Cache cache;
+
+            if (size < SECOND_TEXT_SIZE)
+                return 0;
+
+            if (cache.second < 0 || memcmp(cache.text, text, SECOND_TEXT_SIZE) != 0) {
+                // text is not NUL-terminated, so only the first SECOND_TEXT_SIZE bytes are read
+                std::tm tmv{};
+                if (!parseDigits(text, 4, '-', tmv.tm_year) || !parseDigits(text + 5, 2, '-', tmv.tm_mon) ||
+                    !parseDigits(text + 8, 2, ' ', tmv.tm_mday) || !parseDigits(text + 11, 2, ':', tmv.tm_hour) ||
+                    !parseDigits(text + 14, 2, ':', tmv.tm_min) || !parseDigits(text + 17, 2, '\0', tmv.tm_sec))
+                    return 0;
+                tmv.tm_year -= 1900;
+                tmv.tm_mon -= 1;
+                tmv.tm_isdst = -1;
+                std::time_t tt = mktime(&tmv);
+                if (tt < 0)
+                    return 0;
+                memcpy(cache.text, text, SECOND_TEXT_SIZE);
+                cache.second = static_cast<int64_t>(tt);
+            }
+
+            uint64_t ms = 0;
+            if (size >= TEXT_SIZE) {
+                for (size_t i = SECOND_TEXT_SIZE + 1; i < TEXT_SIZE; i++) {
+                    if (text[i] < '0' || text[i] > '9')
+                        break;
+                    ms = ms * 10 + static_cast<uint64_t>(text[i] - '0');
+                }
+            }
+            return static_cast<uint64_t>(cache.second) * 1000000000ull + ms * 1000000ull;
+        }
+
+    private:
+        // count digits followed by separator ('\0' : no separator)
+        static inline bool parseDigits(const char* text, size_t count, char separator, int& value) {
+            value = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (text[i] < '0' || text[i] > '9')
+                    return false;
+                value = value * 10 + (text[i] - '0');
+            }
+            return separator == '\0' || text[count] == separator;
+        }
+    };
+
     PACK_START
     struct LogHeader
     {
         static constexpr size_t SIZE = 96;
         static constexpr char MAGIC[] {'S', 'L', 'O', 'G'};
-        static constexpr char DATE_FORMAT[] = "YYYY-MM-NN HH:MM:DD:mmm ";
+
+        // VERSION_LEGACY : payload is always LogLine::CONTENT_SIZE bytes, time is local date text
+        // VERSION_VARIABLE_LENGTH : payload is payload_size bytes, time is local date text
+        // VERSION_BINARY_TIME : payload is payload_size bytes, time is timestamp + sequence
+        static constexpr uint8_t VERSION_LEGACY = 0;
+        static constexpr uint8_t VERSION_VARIABLE_LENGTH = 1;
+        static constexpr uint8_t VERSION_BINARY_TIME = 2;
+        static constexpr uint8_t VERSION = VERSION_BINARY_TIME;
+
+        // Before VERSION_BINARY_TIME, timestamp, sequence and format_id held "YYYY-MM-DD HH:MM:SS:mmm|"
+        static constexpr char LEGACY_DATE_FORMAT[] = "YYYY-MM-NN HH:MM:DD:mmm ";
         static constexpr char SIGNATURE_FORMAT[] = "12345678901234567890123456789012";
         static constexpr char TAG_FORMAT[] = "1234567890123456";
         
 
         static constexpr size_t MAGIC_SIZE = sizeof(MAGIC); // 4
-        static constexpr size_t DATE_FORMAT_SIZE = sizeof(DATE_FORMAT)-1; // 24
+        static constexpr size_t PAYLOAD_SIZE_SIZE = sizeof(uint32_t); // 4
+        static constexpr size_t LEGACY_DATE_SIZE = sizeof(LEGACY_DATE_FORMAT)-1; // 24
+        static constexpr size_t TIMESTAMP_SIZE = sizeof(uint64_t); // 8
+        static constexpr size_t SEQUENCE_SIZE = sizeof(uint64_t); // 8
+        static constexpr size_t FORMAT_ID_SIZE = LEGACY_DATE_SIZE - TIMESTAMP_SIZE - SEQUENCE_SIZE; // 8
         // for function name or class name
         static constexpr size_t SIGNATURE_SIZE = sizeof(SIGNATURE_FORMAT)-1;// 32
         static constexpr size_t TAG_SIZE = sizeof(TAG_FORMAT) - 1; // 16
         static constexpr size_t COLOR_SIZE = sizeof(LogColor); // 4
+        static constexpr size_t VERSION_SIZE = sizeof(uint8_t); // 1
+        static constexpr size_t FLAGS_SIZE = sizeof(uint8_t); // 1
+        static constexpr size_t CHECKSUM_SIZE = sizeof(uint32_t); // 4
         
         static constexpr size_t OFFSET_MAGIC = 0;
-        static constexpr size_t OFFSET_DATE_FORMAT = MAGIC_SIZE + sizeof(uint32_t); // 8
-        static constexpr size_t OFFSET_SIGNATURE = OFFSET_DATE_FORMAT + DATE_FORMAT_SIZE; // 32
+        static constexpr size_t OFFSET_PAYLOAD_SIZE = MAGIC_SIZE; // 4
+        static constexpr size_t OFFSET_TIMESTAMP = OFFSET_PAYLOAD_SIZE + PAYLOAD_SIZE_SIZE; // 8
+        static constexpr size_t OFFSET_SEQUENCE = OFFSET_TIMESTAMP + TIMESTAMP_SIZE; // 16
+        static constexpr size_t OFFSET_FORMAT_ID = OFFSET_SEQUENCE + SEQUENCE_SIZE; // 24
+        static constexpr size_t OFFSET_LEGACY_DATE = OFFSET_TIMESTAMP; // 8
+        static constexpr size_t OFFSET_SIGNATURE = OFFSET_LEGACY_DATE + LEGACY_DATE_SIZE; // 32
         static constexpr size_t OFFSET_TAG = OFFSET_SIGNATURE + SIGNATURE_SIZE; // 64
         static constexpr size_t OFFSET_COLOR = OFFSET_TAG + TAG_SIZE; // 80
+        static constexpr size_t OFFSET_VERSION = OFFSET_COLOR + COLOR_SIZE; // 84
+        static constexpr size_t OFFSET_FLAGS = OFFSET_VERSION + VERSION_SIZE; // 85
+        static constexpr size_t OFFSET_CHECKSUM = OFFSET_FLAGS + FLAGS_SIZE; // 86
 
-        static constexpr size_t RESERVED_SIZE = SIZE - OFFSET_COLOR - COLOR_SIZE;
+        static constexpr size_t RESERVED_SIZE = SIZE - OFFSET_CHECKSUM - CHECKSUM_SIZE; // 6
+
+        // Payload is the binary arguments of the format string format_id (see LogFormat), expanded by the server
+        static constexpr uint8_t FLAG_FORMATTED = 1 << 0;
+        // Payload is the format string of format_id. It is not a log.
+        static constexpr uint8_t FLAG_FORMAT_DEFINITION = 1 << 1;
+        // checksum holds the CRC32C of the frame (see computeChecksum). Without it, checksum is not looked at.
+        static constexpr uint8_t FLAG_CHECKSUM = 1 << 2;
+        static constexpr uint8_t FLAGS_KNOWN = FLAG_FORMATTED | FLAG_FORMAT_DEFINITION | FLAG_CHECKSUM;
 
 
         char magic[MAGIC_SIZE] {0};
-        uint32_t _padding1 {0};
-        char date_format[DATE_FORMAT_SIZE] {0};
+        // Legacy clients leave this zero-filled (it used to be padding)
+        uint32_t payload_size {0};
+        // nanoseconds since the Unix epoch
+        uint64_t timestamp {0};
+        // per-process counter, orders logs created within the same timestamp
+        uint64_t sequence {0};
+        // only with FLAG_FORMATTED or FLAG_FORMAT_DEFINITION
+        uint64_t format_id {0};
         char signature[SIGNATURE_SIZE]{ 0 };
         char tag[TAG_SIZE] {0};
         LogColor color {0};        
+        uint8_t version {VERSION_LEGACY};
+        // Legacy clients leave this zero-filled (it used to be reserved)
+        uint8_t flags {0};
+        // little endian uint32_t, only with FLAG_CHECKSUM. Bytes because the field is not aligned.
+        uint8_t checksum[CHECKSUM_SIZE] {0};
         char reserved[RESERVED_SIZE] {0};
 
         LogHeader() = default;
-        LogHeader(const char* signature, const char* tag, LogColor color) : color(color) {
+        LogHeader(const char* signature, const char* tag, LogColor color) : timestamp(LogTimestamp::now()), sequence(nextSequence()), color(color), version(VERSION) {
             memcpy(magic, MAGIC, sizeof(magic));
-            printLogDate(date_format);
             snprintf(this->signature, SIGNATURE_SIZE, "%s", signature);
             snprintf(this->tag, TAG_SIZE, "%s", tag);
         }
 
+        inline uint32_t getChecksum() const {
+            return static_cast<uint32_t>(checksum[0]) | static_cast<uint32_t>(checksum[1]) << 8
+                | static_cast<uint32_t>(checksum[2]) << 16 | static_cast<uint32_t>(checksum[3]) << 24;
+        }
+        inline void setChecksum(uint32_t value) {
+            for (size_t i = 0; i < CHECKSUM_SIZE; i++)
+                checksum[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        // CRC32C of the header without its checksum bytes.
+        // The checksum of a frame continues it over the payload : LogChecksum::compute(payload, size, computeChecksum())
+        inline uint32_t computeChecksum() const {
+            auto* data = reinterpret_cast<const char*>(this);
+            uint32_t ret = LogChecksum::compute(data, OFFSET_CHECKSUM);
+            return LogChecksum::compute(data + OFFSET_CHECKSUM + CHECKSUM_SIZE, SIZE - OFFSET_CHECKSUM - CHECKSUM_SIZE, ret);
+        }
 
-    private:
-        inline void printLogDate(char (&date_format)[DATE_FORMAT_SIZE]) {
-            auto now = std::chrono::system_clock::now();
-            auto since_epoch_milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch());
-
-            const int ms = static_cast<int>(since_epoch_milliseconds.count() % 1000);
+        // Replaces the date text of a header older than VERSION_BINARY_TIME with timestamp and sequence
+        inline void upgradeLegacyTime() {
+            if (version >= VERSION_BINARY_TIME)
+                return;
 
-            std::time_t tt = std::chrono::system_clock::to_time_t(now);
-            std::tm tmv;
+            char date[LEGACY_DATE_SIZE + 1];
+            memcpy(date, reinterpret_cast<const char*>(this) + OFFSET_LEGACY_DATE, LEGACY_DATE_SIZE);
+            date[LEGACY_DATE_SIZE] = '\0';
+            timestamp = LogTimestamp::parse(date, strnlen(date, LEGACY_DATE_SIZE));
+            sequence = 0;
+            format_id = 0;
+            flags = 0;
+            version = VERSION_BINARY_TIME;
+        }
 
-#if defined(_WIN32)
-            if (localtime_s(&tmv, &tt) != 0) {
-                return;
-            }
-#else
-            if (localtime_r(&tt, &tmv) == nullptr) {
-                return;
-            }
-#endif
-            snprintf(date_format, sizeof(date_format), "%04d-%02d-%02d %02d:%02d:%02d:%03d|", tmv.tm_year + 1900,
-                tmv.tm_mon + 1,
-                tmv.tm_mday,
-                tmv.tm_hour,
-                tmv.tm_min,
-                tmv.tm_sec,
-                ms);
+    private:
+        static inline uint64_t nextSequence() {
+            static std::atomic<uint64_t> sequence{ 0 };
+            return sequence.fetch_add(1, std::memory_order_relaxed);
         }
     };
     PACK_END
@@ -148,16 +307,76 @@ namespace Bn3Monkey
                 size = MAX_TEXT;
 
             memcpy(this->content, content, size);
+            // payload carries the terminating NUL so that it is never empty
+            header.payload_size = static_cast<uint32_t>(size + 1);
+        }
+
+        // Number of bytes this line occupies on the wire (header + payload)
+        inline size_t wireSize() const {
+            return HEADER_SIZE + getPayloadSize(reinterpret_cast<const char*>(&header));
+        }
+
+        // Sets FLAG_CHECKSUM and the checksum of the line as it is sent (wireSize bytes)
+        inline void seal() {
+            header.flags |= LogHeader::FLAG_CHECKSUM;
+            size_t payload_size = getPayloadSize(reinterpret_cast<const char*>(&header));
+            header.setChecksum(LogChecksum::compute(content, payload_size, header.computeChecksum()));
         }
 
+        // Whether a received header can start a frame.
+        // Besides the magic, the fields a misaligned or damaged stream gets wrong are checked.
         static bool isValid(const char* input_buffer) {
-            auto* ret = reinterpret_cast<const LogHeader*>(input_buffer);
-            
             if (memcmp(input_buffer, LogHeader::MAGIC, LogHeader::MAGIC_SIZE) != 0)
                 return false;
 
+            auto* header = reinterpret_cast<const LogHeader*>(input_buffer);
+            if (header->version > LogHeader::VERSION)
+                return false;
+            if (header->version >= LogHeader::VERSION_VARIABLE_LENGTH) {
+                uint32_t payload_size;
+                memcpy(&payload_size, input_buffer + LogHeader::OFFSET_PAYLOAD_SIZE, sizeof(payload_size));
+                if (payload_size > CONTENT_SIZE || (header->flags & ~LogHeader::FLAGS_KNOWN) != 0)
+                    return false;
+            }
             return true;
         }
+
+        // Whether a received frame matches its checksum. Frames without FLAG_CHECKSUM are not checked.
+        static bool isIntact(const char* input_buffer, const char* payload, size_t payload_size) {
+            auto* header = reinterpret_cast<const LogHeader*>(input_buffer);
+            if (header->version < LogHeader::VERSION_VARIABLE_LENGTH || !(header->flags & LogHeader::FLAG_CHECKSUM))
+                return true;
+            return LogChecksum::compute(payload, payload_size, header->computeChecksum()) == header->getChecksum();
+        }
+
+        // Resynchronizes a stream that lost its framing : offset of the first byte of data that can start a header,
+        // which is the magic or, at the end of data, a part of it. size if there is none.
+        static size_t findHeader(const char* data, size_t size) {
+            size_t offset = 0;
+            while (offset < size) {
+                auto* found = static_cast<const char*>(memchr(data + offset, LogHeader::MAGIC[0], size - offset));
+                if (!found)
+                    return size;
+                offset = static_cast<size_t>(found - data);
+                size_t length = size - offset < LogHeader::MAGIC_SIZE ? size - offset : LogHeader::MAGIC_SIZE;
+                if (memcmp(found, LogHeader::MAGIC, length) == 0)
+                    return offset;
+                offset++;
+            }
+            return size;
+        }
+
+        // Payload size announced by a received header.
+        // Legacy headers always carry a full CONTENT_SIZE payload.
+        static size_t getPayloadSize(const char* input_buffer) {
+            auto* header = reinterpret_cast<const LogHeader*>(input_buffer);
+            if (header->version < LogHeader::VERSION_VARIABLE_LENGTH)
+                return CONTENT_SIZE;
+
+            uint32_t payload_size;
+            memcpy(&payload_size, input_buffer + LogHeader::OFFSET_PAYLOAD_SIZE, sizeof(payload_size));
+            return payload_size < CONTENT_SIZE ? payload_size : CONTENT_SIZE;
+        }
     };
     PACK_END
 
@@ -0,0 +1,135 @@
+#include "log_console.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+size_t Bn3Monkey::LogPrinter::format(const LogLine& logline, char* buffer, size_t size)
+{
+	const uint32_t v = static_cast<uint32_t>(logline.header.color);
+	int32_t r = (v >> 16) & 0xFF;
+	int32_t g = (v >> 8) & 0xFF;
+	int32_t b = v & 0xFF;
+
+	char date[LogTimestamp::TEXT_SIZE + 1];
+	LogTimestamp::format(logline.header.timestamp, date);
+
+	int ret = snprintf(buffer, size, "\x1b[38;2;%d;%d;%dm%s %.*s %.*s | %.*s\x1b[0m\n",
+		r, g, b,
+		date,
+		static_cast<int>(strnlen(logline.header.signature, LogHeader::SIGNATURE_SIZE)), logline.header.signature,
+		static_cast<int>(strnlen(logline.header.tag, LogHeader::TAG_SIZE)), logline.header.tag,
+		static_cast<int>(strnlen(logline.content, LogLine::CONTENT_SIZE)), logline.content);
+	if (ret < 0)
+		return 0;
+	return static_cast<size_t>(ret) < size ? static_cast<size_t>(ret) : size - 1;
+}
+
+Bn3Monkey::LogConsoleSink::LogConsoleSink(const LogConsoleConfiguration& configuration) :
+	_configuration(configuration),
+	_queue(configuration.queue_capacity, OverflowPolicy::DROP_NEWEST),
+	_is_enabled(configuration.is_enabled)
+{
+	if (_configuration.sampling_rate == 0)
+		_configuration.sampling_rate = 1;
+
+	_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::LogConsoleSink::~LogConsoleSink()
+{
+	_is_running = false;
+	_queue.close();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void Bn3Monkey::LogConsoleSink::print(const LogLine& line)
+{
+	if (!isEnabled())
+		return;
+
+	if (_configuration.sampling_rate > 1) {
+		thread_local size_t sampling_count{ 0 };
+		if (sampling_count++ % _configuration.sampling_rate != 0)
+			return;
+	}
+
+	if (!acquireRate()) {
+		_suppressed.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	_queue.push(line);
+}
+
+bool Bn3Monkey::LogConsoleSink::acquireRate()
+{
+	if (_configuration.max_lines_per_second == 0)
+		return true;
+
+	int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t window = _rate_window.load(std::memory_order_relaxed);
+	if (window != now && _rate_window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+		_rate_count.store(0, std::memory_order_relaxed);
+	}
+	return _rate_count.fetch_add(1, std::memory_order_relaxed) < _configuration.max_lines_per_second;
+}
+
+void Bn3Monkey::LogConsoleSink::run()
+{
+	constexpr size_t BUFFER_SIZE = 64 * 1024;
+	constexpr size_t LINE_SIZE = 2 * LogLine::SIZE;
+	std::unique_ptr<char[]> buffer{ new char[BUFFER_SIZE] };
+	uint64_t reported_suppressed = 0;
+
+	LogLine line;
+	while (true) {
+		if (!_queue.pop(line, std::chrono::milliseconds(100))) {
+			if (!_is_running)
+				break;
+			continue;
+		}
+
+		// 큐에 쌓인 만큼 한 버퍼에 모아서 한 번에 출력한다
+		size_t size = 0;
+		do {
+			size += LogPrinter::format(line, buffer.get() + size, BUFFER_SIZE - size);
+		} while (size + LINE_SIZE <= BUFFER_SIZE && _queue.pop(line));
+
+		uint64_t suppressed = this->suppressed();
+		if (suppressed != reported_suppressed && size + LINE_SIZE <= BUFFER_SIZE) {
+			int ret = snprintf(buffer.get() + size, BUFFER_SIZE - size, "[[SYSTEM]] %llu lines were not printed to the console\n",
+				static_cast<unsigned long long>(suppressed - reported_suppressed));
+			if (ret > 0)
+				size += static_cast<size_t>(ret);
+			reported_suppressed = suppressed;
+		}
+
+		flush(buffer.get(), size);
+	}
+}
+
+void Bn3Monkey::LogConsoleSink::flush(const char* buffer, size_t size)
+{
+	// printf로 찍은 시스템 메시지와 섞이지 않도록 먼저 비운다
+	fflush(stdout);
+	while (size > 0) {
+#ifdef _WIN32
+		int written = _write(1, buffer, static_cast<unsigned int>(size));
+#else
+		ssize_t written = ::write(STDOUT_FILENO, buffer, size);
+#endif
+		if (written <= 0)
+			break;
+		buffer += written;
+		size -= static_cast<size_t>(written);
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef __BN3MONKEY_LOG_CONSOLE__
+#define __BN3MONKEY_LOG_CONSOLE__
+
+#include <simple_log_protocol.hpp>
+#include "../log_writer/log_ring_buffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    class LogPrinter
+    {
+    public:
+        // Colored console rendering of a line. Returns the number of bytes written to buffer.
+        static size_t format(const LogLine& logline, char* buffer, size_t size);
+    };
+
+    struct LogConsoleConfiguration
+    {
+        // lines waiting for the console. Lines are dropped when it is full.
+        size_t queue_capacity{ 1024 };
+        // at most this many lines are printed per second (0 : unlimited)
+        size_t max_lines_per_second{ 2000 };
+        // one out of every sampling_rate lines is printed
+        size_t sampling_rate{ 1 };
+        bool is_enabled{ true };
+    };
+
+    // Console output that never blocks the caller.
+    // Lines go through sampling and a per-second rate limit, are queued, and a console thread
+    // formats everything available into one buffer and hands it to the terminal with a single write.
+    class LogConsoleSink
+    {
+    public:
+        explicit LogConsoleSink(const LogConsoleConfiguration& configuration = LogConsoleConfiguration{});
+        ~LogConsoleSink();
+
+        LogConsoleSink(const LogConsoleSink&) = delete;
+        LogConsoleSink& operator=(const LogConsoleSink&) = delete;
+
+        void print(const LogLine& line);
+
+        inline void setEnabled(bool is_enabled) { _is_enabled.store(is_enabled, std::memory_order_relaxed); }
+        inline bool isEnabled() const { return _is_enabled.load(std::memory_order_relaxed); }
+
+        // lines that were not printed because of the rate limit or a full queue
+        inline uint64_t suppressed() const { return _suppressed.load(std::memory_order_relaxed) + _queue.dropped(); }
+
+    private:
+        bool acquireRate();
+        void run();
+        void flush(const char* buffer, size_t size);
+
+        LogConsoleConfiguration _configuration;
+        LogRingBuffer<LogLine> _queue;
+
+        std::atomic<bool> _is_enabled;
+        alignas(64) std::atomic<int64_t> _rate_window{ 0 };
+        std::atomic<size_t> _rate_count{ 0 };
+        std::atomic<uint64_t> _suppressed{ 0 };
+
+        std::atomic<bool> _is_running{ true };
+        std::thread _thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_CONSOLE__
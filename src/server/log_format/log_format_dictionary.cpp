@@ -0,0 +1,37 @@
+#include "log_format_dictionary.hpp"
+
+#include <cstdio>
+
+using namespace Bn3Monkey;
+
+bool Bn3Monkey::LogFormatDictionary::define(uint64_t format_id, const char* format, size_t size)
+{
+	// 다른 client가 쓰는 id를 다른 문자열로 덮어쓰지 못하게 한다
+	std::string text{ format, strnlen(format, size) };
+	if (LogFormat::hash(text.c_str()) != format_id)
+		return false;
+
+	std::unique_lock<std::shared_mutex> lock(_mutex);
+	if (_formats.find(format_id) != _formats.end())
+		return true;
+	if (_formats.size() >= MAX_FORMATS)
+		return false;
+	_formats.emplace(format_id, std::move(text));
+	return true;
+}
+
+bool Bn3Monkey::LogFormatDictionary::expand(LogLine& line, const char* arguments, size_t size) const
+{
+	uint64_t format_id = line.header.format_id;
+	line.header.format_id = 0;
+	line.header.flags &= ~LogHeader::FLAG_FORMATTED;
+
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	auto it = _formats.find(format_id);
+	if (it == _formats.end()) {
+		snprintf(line.content, sizeof(line.content), "(unknown format %016llx)", static_cast<unsigned long long>(format_id));
+		return false;
+	}
+	LogFormat::expand(it->second.c_str(), arguments, size, line.content, sizeof(line.content));
+	return true;
+}
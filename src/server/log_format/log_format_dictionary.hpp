@@ -0,0 +1,37 @@
+#ifndef __BN3MONKEY_LOG_FORMAT_DICTIONARY__
+#define __BN3MONKEY_LOG_FORMAT_DICTIONARY__
+
+#include <simple_log_protocol.hpp>
+#include <simple_log_format.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Bn3Monkey
+{
+    // Format strings defined by clients (LogHeader::FLAG_FORMAT_DEFINITION), shared by every connection.
+    // A format id is the hash of its string, so clients using the same string agree on it.
+    class LogFormatDictionary
+    {
+    public:
+        // formats kept at most, so that clients cannot grow the dictionary without bound
+        static constexpr size_t MAX_FORMATS = 16384;
+
+        // Returns false if format_id is not the hash of format or the dictionary is full.
+        // The first definition of an id is kept.
+        bool define(uint64_t format_id, const char* format, size_t size);
+
+        // Turns the content of a FLAG_FORMATTED line (arguments) into text.
+        // Returns false if format_id was never defined, leaving a note in the content instead.
+        bool expand(LogLine& line, const char* arguments, size_t size) const;
+
+    private:
+        mutable std::shared_mutex _mutex;
+        std::unordered_map<uint64_t, std::string> _formats;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_FORMAT_DICTIONARY__
@@ -0,0 +1,420 @@
+#include "log_epoll_server.hpp"
+#include "../log_metrics/log_metrics.hpp"
+
+#include <cstdio>
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Bn3Monkey;
+
+// 한 번의 epoll_wait로 받는 이벤트 수
+static constexpr size_t MAX_EVENTS = 256;
+// 가장 큰 프레임(LogLine)이 충분히 들어가는 크기
+static constexpr size_t MIN_BUFFER_SIZE = 64 * 1024;
+// fd가 모자라서 연결을 받지 못할 때 다시 받아 보기까지 기다리는 시간
+static constexpr std::chrono::milliseconds ACCEPT_BACKOFF{ 100 };
+
+struct Bn3Monkey::LogEpollServer::Connection
+{
+	int fd{ -1 };
+	char ip[INET6_ADDRSTRLEN]{ 0 };
+	int port{ 0 };
+	std::unique_ptr<char[]> buffer;
+	// received bytes not yet handed to the handler (the beginning of a frame)
+	size_t size{ 0 };
+	// in Reactor::ready
+	bool is_ready{ false };
+	// searching for a header since the last rejected frame
+	bool is_resynchronizing{ false };
+};
+
+struct Bn3Monkey::LogEpollServer::Reactor
+{
+	int epoll{ -1 };
+	int listener{ -1 };
+	int wakeup{ -1 };
+	// descriptor given up to accept and close a connection when the process has none left (EMFILE, ENFILE).
+	// Otherwise the level-triggered listener would keep reporting the connection that cannot be accepted.
+	int reserve{ -1 };
+	// without a reserve the listener is left out of epoll until then
+	std::chrono::steady_clock::time_point accept_paused_until{};
+	bool is_accept_paused{ false };
+	std::thread thread;
+	std::unordered_map<int, std::unique_ptr<Connection>> connections;
+	// connections that used up reads_per_event with data possibly left in the socket.
+	// Edge-triggered epoll does not report them again.
+	std::vector<Connection*> ready;
+};
+
+static int listen(uint32_t port)
+{
+	int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sock < 0)
+		return -1;
+
+	// 리액터마다 같은 포트를 열고 커널이 새 연결을 나눠 준다
+	int on = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(static_cast<uint16_t>(port));
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(sock, SOMAXCONN) != 0) {
+		::close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+static void pin(std::thread& thread, size_t core)
+{
+	size_t cores = std::thread::hardware_concurrency();
+	if (cores == 0)
+		return;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core % cores, &set);
+	pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+}
+
+Bn3Monkey::LogEpollServer::LogEpollServer(uint32_t port, const LogEpollServerConfiguration& configuration) : _port(port), _configuration(configuration)
+{
+	if (_configuration.reactor_count == 0)
+		_configuration.reactor_count = 1;
+	if (_configuration.buffer_size < MIN_BUFFER_SIZE)
+		_configuration.buffer_size = MIN_BUFFER_SIZE;
+	if (_configuration.reads_per_event == 0)
+		_configuration.reads_per_event = 1;
+}
+
+Bn3Monkey::LogEpollServer::~LogEpollServer()
+{
+	close();
+}
+
+bool Bn3Monkey::LogEpollServer::open(SocketRequestHandler* handler, LogFrameSynchronizer* synchronizer)
+{
+	close();
+	_handler = handler;
+	_synchronizer = synchronizer;
+	_header_size = handler->getHeaderSize();
+
+	for (size_t i = 0; i < _configuration.reactor_count; i++) {
+		auto reactor = std::make_unique<Reactor>();
+		reactor->epoll = epoll_create1(EPOLL_CLOEXEC);
+		reactor->listener = listen(_port);
+		reactor->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		reactor->reserve = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+		_reactors.push_back(std::move(reactor));
+
+		auto& created = *_reactors.back();
+		if (created.epoll < 0 || created.listener < 0 || created.wakeup < 0) {
+			printf("[[SYSTEM]] Cannot listen on port %u (%s)\n", _port, strerror(errno));
+			close();
+			return false;
+		}
+
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.ptr = &created.listener;
+		epoll_ctl(created.epoll, EPOLL_CTL_ADD, created.listener, &event);
+		event.data.ptr = &created.wakeup;
+		epoll_ctl(created.epoll, EPOLL_CTL_ADD, created.wakeup, &event);
+	}
+
+	_is_running = true;
+	for (size_t i = 0; i < _reactors.size(); i++) {
+		auto& reactor = *_reactors[i];
+		reactor.thread = std::thread{ [&]() { run(reactor); } };
+		if (_configuration.is_pinned)
+			pin(reactor.thread, _configuration.first_core + i);
+	}
+	return true;
+}
+
+void Bn3Monkey::LogEpollServer::close()
+{
+	_is_running = false;
+	for (auto& reactor : _reactors) {
+		if (reactor->wakeup >= 0) {
+			uint64_t value = 1;
+			(void)write(reactor->wakeup, &value, sizeof(value));
+		}
+		if (reactor->thread.joinable())
+			reactor->thread.join();
+	}
+
+	for (auto& reactor : _reactors) {
+		while (!reactor->connections.empty())
+			disconnect(*reactor, reactor->connections.begin()->second.get());
+		if (reactor->listener >= 0)
+			::close(reactor->listener);
+		if (reactor->wakeup >= 0)
+			::close(reactor->wakeup);
+		if (reactor->reserve >= 0)
+			::close(reactor->reserve);
+		if (reactor->epoll >= 0)
+			::close(reactor->epoll);
+	}
+	_reactors.clear();
+}
+
+void Bn3Monkey::LogEpollServer::run(Reactor& reactor)
+{
+	epoll_event events[MAX_EVENTS];
+	std::vector<Connection*> ready;
+
+	while (_is_running.load(std::memory_order_relaxed)) {
+		// 읽다 만 연결이 있으면 기다리지 않는다
+		int timeout = -1;
+		if (!reactor.ready.empty())
+			timeout = 0;
+		else if (reactor.is_accept_paused)
+			timeout = static_cast<int>(ACCEPT_BACKOFF.count());
+		int count = epoll_wait(reactor.epoll, events, static_cast<int>(MAX_EVENTS), timeout);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+			printf("[[SYSTEM]] epoll_wait failed (%s)\n", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < count; i++) {
+			void* source = events[i].data.ptr;
+			if (source == &reactor.wakeup)
+				continue;
+			if (source == &reactor.listener) {
+				accept(reactor);
+				continue;
+			}
+
+			auto* connection = static_cast<Connection*>(source);
+			if (!receive(reactor, *connection))
+				disconnect(reactor, connection);
+		}
+
+		ready.swap(reactor.ready);
+		for (size_t i = 0; i < ready.size(); i++) {
+			// disconnect()가 목록에서 지운 연결은 nullptr로 남는다
+			auto* connection = ready[i];
+			if (connection == nullptr)
+				continue;
+			connection->is_ready = false;
+			if (!receive(reactor, *connection))
+				disconnect(reactor, connection);
+		}
+		ready.clear();
+
+		if (reactor.is_accept_paused && std::chrono::steady_clock::now() >= reactor.accept_paused_until) {
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.ptr = &reactor.listener;
+			if (epoll_ctl(reactor.epoll, EPOLL_CTL_ADD, reactor.listener, &event) == 0)
+				reactor.is_accept_paused = false;
+		}
+	}
+}
+
+void Bn3Monkey::LogEpollServer::accept(Reactor& reactor)
+{
+	while (true) {
+		sockaddr_storage address{};
+		socklen_t address_size = sizeof(address);
+		int sock = accept4(reactor.listener, reinterpret_cast<sockaddr*>(&address), &address_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (sock < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno == EMFILE || errno == ENFILE)
+				reject(reactor);
+			break;
+		}
+
+		auto connection = std::make_unique<Connection>();
+		connection->fd = sock;
+		if (address.ss_family == AF_INET6) {
+			auto* ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+			inet_ntop(AF_INET6, &ipv6->sin6_addr, connection->ip, sizeof(connection->ip));
+			connection->port = ntohs(ipv6->sin6_port);
+		}
+		else {
+			auto* ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+			inet_ntop(AF_INET, &ipv4->sin_addr, connection->ip, sizeof(connection->ip));
+			connection->port = ntohs(ipv4->sin_port);
+		}
+		// 쓰이지 않은 페이지는 메모리를 차지하지 않으므로 조용한 연결은 거의 비용이 없다
+		connection->buffer.reset(new char[_configuration.buffer_size]);
+
+		epoll_event event{};
+		event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = connection.get();
+		if (epoll_ctl(reactor.epoll, EPOLL_CTL_ADD, sock, &event) != 0) {
+			::close(sock);
+			continue;
+		}
+
+		_handler->onClientConnected(connection->ip, connection->port);
+		reactor.connections.emplace(sock, std::move(connection));
+	}
+}
+
+void Bn3Monkey::LogEpollServer::reject(Reactor& reactor)
+{
+	// 남겨 둔 fd를 잠시 내놓고 기다리는 연결을 받아서 바로 닫는다
+	while (reactor.reserve >= 0) {
+		::close(reactor.reserve);
+		int sock = accept4(reactor.listener, nullptr, nullptr, SOCK_CLOEXEC);
+		int error = errno;
+		if (sock >= 0) {
+			::close(sock);
+			LogMetrics::add(LogMetrics::Counter::CONNECTIONS_REJECTED);
+		}
+		reactor.reserve = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+		if (sock < 0 && error != EINTR && error != ECONNABORTED) {
+			if (error == EAGAIN || error == EWOULDBLOCK)
+				return;
+			break;
+		}
+	}
+
+	// 남겨 둔 fd가 없으면 listener를 잠시 빼 두어 epoll_wait가 계속 깨어나지 않게 한다
+	if (epoll_ctl(reactor.epoll, EPOLL_CTL_DEL, reactor.listener, nullptr) == 0) {
+		reactor.is_accept_paused = true;
+		reactor.accept_paused_until = std::chrono::steady_clock::now() + ACCEPT_BACKOFF;
+	}
+	printf("[[SYSTEM]] Out of file descriptors, accepting again in %lld ms\n", static_cast<long long>(ACCEPT_BACKOFF.count()));
+}
+
+bool Bn3Monkey::LogEpollServer::receive(Reactor& reactor, Connection& connection)
+{
+	for (size_t i = 0; i < _configuration.reads_per_event; i++) {
+		// 버퍼에는 항상 한 프레임보다 큰 여유가 남는다. 가득 찼다면 프레임이 잘못된 것이다.
+		if (connection.size == _configuration.buffer_size)
+			return false;
+
+		ssize_t result = recv(connection.fd, connection.buffer.get() + connection.size, _configuration.buffer_size - connection.size, 0);
+		if (result > 0) {
+			connection.size += static_cast<size_t>(result);
+			parse(connection);
+			continue;
+		}
+		if (result == 0)
+			return false;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return true;
+		if (errno == EINTR)
+			continue;
+		return false;
+	}
+
+	// 바쁜 연결 하나가 리액터를 독차지하지 않도록 나머지는 다른 연결을 처리한 뒤에 읽는다
+	if (!connection.is_ready) {
+		connection.is_ready = true;
+		reactor.ready.push_back(&connection);
+	}
+	return true;
+}
+
+void Bn3Monkey::LogEpollServer::parse(Connection& connection)
+{
+	const char* data = connection.buffer.get();
+	size_t offset = 0;
+	while (connection.size - offset >= _header_size) {
+		const char* header = data + offset;
+		if (_synchronizer && !_synchronizer->isFrameHeader(header)) {
+			offset = resynchronize(connection, offset);
+			continue;
+		}
+		size_t payload_size = _handler->getPayloadSize(header);
+		if (connection.size - offset - _header_size < payload_size)
+			break;
+
+		if (!_synchronizer) {
+			_handler->onProcessedWithoutResponse(header, header + _header_size, payload_size);
+		}
+		else if (!_synchronizer->onFrame(header, header + _header_size, payload_size)) {
+			// 길이가 잘못되었을 수 있으므로 프레임 안에서부터 다시 찾는다
+			offset = resynchronize(connection, offset);
+			continue;
+		}
+		connection.is_resynchronizing = false;
+		offset += _header_size + payload_size;
+	}
+
+	// 잘린 프레임은 버퍼 앞으로 옮겨 다음 recv에 이어 붙인다
+	if (offset > 0) {
+		memmove(connection.buffer.get(), data + offset, connection.size - offset);
+		connection.size -= offset;
+	}
+}
+
+size_t Bn3Monkey::LogEpollServer::resynchronize(Connection& connection, size_t offset)
+{
+	if (!connection.is_resynchronizing) {
+		connection.is_resynchronizing = true;
+		LogMetrics::add(LogMetrics::Counter::RESYNCHRONIZATIONS);
+	}
+
+	const char* data = connection.buffer.get() + offset + 1;
+	size_t skipped = 1 + _synchronizer->findFrameHeader(data, connection.size - offset - 1);
+	LogMetrics::add(LogMetrics::Counter::SKIPPED_BYTES, skipped);
+	return offset + skipped;
+}
+
+void Bn3Monkey::LogEpollServer::disconnect(Reactor& reactor, Connection* connection)
+{
+	if (connection->is_ready) {
+		for (auto& ready : reactor.ready) {
+			if (ready == connection)
+				ready = nullptr;
+		}
+	}
+
+	epoll_ctl(reactor.epoll, EPOLL_CTL_DEL, connection->fd, nullptr);
+	::close(connection->fd);
+	_handler->onClientDisconnected(connection->ip, connection->port);
+	reactor.connections.erase(connection->fd);
+}
+
+#else
+
+using namespace Bn3Monkey;
+
+struct Bn3Monkey::LogEpollServer::Connection {};
+struct Bn3Monkey::LogEpollServer::Reactor {};
+
+Bn3Monkey::LogEpollServer::LogEpollServer(uint32_t port, const LogEpollServerConfiguration& configuration) : _port(port), _configuration(configuration)
+{
+}
+
+Bn3Monkey::LogEpollServer::~LogEpollServer()
+{
+}
+
+bool Bn3Monkey::LogEpollServer::open(SocketRequestHandler* handler, LogFrameSynchronizer* synchronizer)
+{
+	printf("[[SYSTEM]] epoll ingestion is only available on Linux\n");
+	return false;
+}
+
+void Bn3Monkey::LogEpollServer::close()
+{
+}
+
+#endif // __linux__
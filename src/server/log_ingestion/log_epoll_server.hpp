@@ -0,0 +1,90 @@
+#ifndef __BN3MONKEY_LOG_EPOLL_SERVER__
+#define __BN3MONKEY_LOG_EPOLL_SERVER__
+
+#include <SecuritySocket.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    struct LogEpollServerConfiguration
+    {
+        // threads running an event loop. Each one accepts and reads its own connections.
+        size_t reactor_count{ 2 };
+        // reactor i runs on core (first_core + i) % cores.
+        // Off by default, pinned reactors compete with whatever else the host runs on those cores.
+        bool is_pinned{ false };
+        size_t first_core{ 0 };
+        // receive buffer of a connection. Memory is only touched by connections that actually send this much at once.
+        size_t buffer_size{ 256 * 1024 };
+        // a readable connection gets at most this many recv calls before the others are served
+        size_t reads_per_event{ 8 };
+    };
+
+    // Optional frame checks of a protocol, so that LogEpollServer can find the frames of a stream again
+    // after a damaged or misaligned one instead of cutting the connection.
+    class LogFrameSynchronizer
+    {
+    public:
+        virtual ~LogFrameSynchronizer() = default;
+        // Whether header (getHeaderSize() bytes) can start a frame. Checked before waiting for its payload.
+        virtual bool isFrameHeader(const char* header) = 0;
+        // Offset of the first byte of data that can start a header (also a partial one at the end), size if none
+        virtual size_t findFrameHeader(const char* data, size_t size) = 0;
+        // Handles a complete frame in place of onProcessedWithoutResponse.
+        // Returns false if the frame was rejected, then the next header is searched from its second byte.
+        virtual bool onFrame(const char* header, const char* payload, size_t payload_size) = 0;
+    };
+
+    // Linux ingestion backend replacing SocketRequestServer for many, mostly idle, connections.
+    // Every reactor listens on the port with SO_REUSEPORT, so the kernel spreads new connections over the reactors,
+    // and reads its connections edge-triggered into one buffer per connection. Frames are cut out of the buffer
+    // in place with the getHeaderSize/getPayloadSize of the handler, so a single recv hands over as many logs as arrived.
+    // Only onProcessedWithoutResponse and the connection callbacks of the handler are used.
+    // With a synchronizer, frames go through it and a connection that loses its framing skips to the next header.
+    // open() fails on other platforms.
+    class LogEpollServer
+    {
+    public:
+        LogEpollServer(uint32_t port, const LogEpollServerConfiguration& configuration = LogEpollServerConfiguration{});
+        ~LogEpollServer();
+
+        LogEpollServer(const LogEpollServer&) = delete;
+        LogEpollServer& operator=(const LogEpollServer&) = delete;
+
+        bool open(SocketRequestHandler* handler, LogFrameSynchronizer* synchronizer = nullptr);
+        void close();
+
+        inline operator bool() const { return _is_running.load(std::memory_order_relaxed); }
+
+    private:
+        struct Connection;
+        struct Reactor;
+
+        void run(Reactor& reactor);
+        void accept(Reactor& reactor);
+        // Gets rid of pending connections that cannot be accepted for lack of file descriptors
+        void reject(Reactor& reactor);
+        // Returns false if the connection has to be closed
+        bool receive(Reactor& reactor, Connection& connection);
+        void parse(Connection& connection);
+        // Offset of the next possible header after the frame at offset was rejected
+        size_t resynchronize(Connection& connection, size_t offset);
+        void disconnect(Reactor& reactor, Connection* connection);
+
+        uint32_t _port;
+        LogEpollServerConfiguration _configuration;
+        SocketRequestHandler* _handler{ nullptr };
+        LogFrameSynchronizer* _synchronizer{ nullptr };
+        size_t _header_size{ 0 };
+
+        std::vector<std::unique_ptr<Reactor>> _reactors;
+        std::atomic<bool> _is_running{ false };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_EPOLL_SERVER__
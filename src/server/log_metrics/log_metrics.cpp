@@ -0,0 +1,341 @@
+#include "log_metrics.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace Bn3Monkey;
+
+struct Bn3Monkey::LogMetrics::Client
+{
+	std::string signature;
+	std::atomic<uint64_t> lines{ 0 };
+	std::atomic<uint64_t> bytes{ 0 };
+};
+
+struct Bn3Monkey::LogMetrics::Registry
+{
+	std::mutex mutex;
+	// blocks of running threads, the retired one holds what exited threads counted
+	std::vector<std::unique_ptr<Block>> blocks;
+	Block retired;
+	std::vector<std::unique_ptr<Block>> free_blocks;
+	std::unordered_map<std::string, std::unique_ptr<Client>> clients;
+	std::unique_ptr<Client> other_clients;
+};
+
+namespace
+{
+	struct Description
+	{
+		const char* name;
+		const char* help;
+	};
+
+	const Description counter_descriptions[] = {
+		{ "slog_lines_received_total", "Log lines received from clients" },
+		{ "slog_bytes_received_total", "Bytes of log frames received from clients" },
+		{ "slog_invalid_records_total", "Frames rejected as invalid" },
+		{ "slog_corrupted_records_total", "Frames rejected because their checksum did not match" },
+		{ "slog_resynchronizations_total", "Times a connection lost its framing and searched for the next header" },
+		{ "slog_skipped_bytes_total", "Bytes skipped while searching for the next header" },
+		{ "slog_format_definitions_total", "SLOG format definitions received" },
+		{ "slog_connections_opened_total", "Client connections accepted" },
+		{ "slog_connections_closed_total", "Client connections closed" },
+		{ "slog_connections_rejected_total", "Client connections closed on accept for lack of file descriptors" },
+		{ "slog_lines_written_total", "Log lines handed to the pools" },
+		{ "slog_lines_dropped_total", "Log lines dropped because a writer was full" },
+		{ "slog_bytes_written_total", "Bytes of records written to segments" },
+		{ "slog_commits_total", "Commits of written ranges to the storage" },
+		{ "slog_segments_opened_total", "Segments opened by the pools" },
+	};
+	static_assert(sizeof(counter_descriptions) / sizeof(counter_descriptions[0]) == static_cast<size_t>(LogMetrics::Counter::COUNT), "Every counter needs a description");
+
+	const Description histogram_descriptions[] = {
+		{ "slog_batch_write_seconds", "Time to write one drained batch into a pool" },
+		{ "slog_commit_seconds", "Time to commit the written ranges (msync)" },
+		{ "slog_rotation_seconds", "Time to close a segment and open the next one" },
+	};
+	static_assert(sizeof(histogram_descriptions) / sizeof(histogram_descriptions[0]) == static_cast<size_t>(LogMetrics::Histogram::COUNT), "Every histogram needs a description");
+
+	const double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+	// Length of the valid UTF-8 sequence at data, 0 if it is not one
+	size_t getUtf8Length(const uint8_t* data, size_t size)
+	{
+		static const uint32_t minimum[] = { 0, 0, 0x80, 0x800, 0x10000 };
+
+		uint8_t c = data[0];
+		if (c < 0x80)
+			return 1;
+
+		size_t length = 0;
+		uint32_t code = 0;
+		if ((c & 0xE0) == 0xC0) {
+			length = 2;
+			code = c & 0x1F;
+		}
+		else if ((c & 0xF0) == 0xE0) {
+			length = 3;
+			code = c & 0x0F;
+		}
+		else if ((c & 0xF8) == 0xF0) {
+			length = 4;
+			code = c & 0x07;
+		}
+		if (length == 0 || length > size)
+			return 0;
+
+		for (size_t i = 1; i < length; i++) {
+			if ((data[i] & 0xC0) != 0x80)
+				return 0;
+			code = (code << 6) | (data[i] & 0x3F);
+		}
+		// overlong, surrogate or out of range
+		if (code < minimum[length] || (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF)
+			return 0;
+		return length;
+	}
+
+	// Label value of the Prometheus text format. Signatures are bytes from clients,
+	// so control characters and bytes that are not UTF-8 are written as the text \xNN.
+	void appendEscaped(std::string& output, const std::string& value)
+	{
+		auto* data = reinterpret_cast<const uint8_t*>(value.data());
+		size_t size = value.size();
+		for (size_t i = 0; i < size;) {
+			uint8_t c = data[i];
+			size_t length = getUtf8Length(data + i, size - i);
+			if (c == '\\' || c == '"') {
+				output += '\\';
+				output += static_cast<char>(c);
+			}
+			else if (c == '\n') {
+				output += "\\n";
+			}
+			else if (length == 0 || c < 0x20 || c == 0x7F) {
+				char text[8];
+				snprintf(text, sizeof(text), "\\\\x%02x", c);
+				output += text;
+				length = 1;
+			}
+			else {
+				output.append(value, i, length);
+			}
+			i += length;
+		}
+	}
+}
+
+uint64_t Bn3Monkey::LogLatencyHistogram::collect(std::vector<uint64_t>& counts) const
+{
+	counts.resize(BUCKET_COUNT, 0);
+	for (size_t i = 0; i < BUCKET_COUNT; i++)
+		counts[i] += _counts[i].load(std::memory_order_relaxed);
+	return _sum.load(std::memory_order_relaxed);
+}
+
+void Bn3Monkey::LogLatencyHistogram::absorb(LogLatencyHistogram& other)
+{
+	for (size_t i = 0; i < BUCKET_COUNT; i++) {
+		_counts[i].store(_counts[i].load(std::memory_order_relaxed) + other._counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		other._counts[i].store(0, std::memory_order_relaxed);
+	}
+	_sum.store(_sum.load(std::memory_order_relaxed) + other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	other._sum.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Bn3Monkey::LogLatencyHistogram::getUpperBound(size_t index)
+{
+	if (index < SUB_BUCKETS)
+		return index;
+	size_t shift = index / SUB_BUCKETS - 1;
+	uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+	return lower + ((uint64_t{ 1 } << shift) - 1);
+}
+
+Bn3Monkey::LogMetrics::Registry& Bn3Monkey::LogMetrics::getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+Bn3Monkey::LogMetrics::Block* Bn3Monkey::LogMetrics::createBlock()
+{
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	if (!registry.free_blocks.empty()) {
+		registry.blocks.push_back(std::move(registry.free_blocks.back()));
+		registry.free_blocks.pop_back();
+	}
+	else {
+		registry.blocks.emplace_back(new Block());
+	}
+	return registry.blocks.back().get();
+}
+
+void Bn3Monkey::LogMetrics::retireBlock(Block* block)
+{
+	// 끝난 스레드의 값은 retired에 더하고 블록은 다음 스레드가 쓴다
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); i++) {
+		auto& count = registry.retired.counters[i];
+		count.store(count.load(std::memory_order_relaxed) + block->counters[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		block->counters[i].store(0, std::memory_order_relaxed);
+	}
+	for (size_t i = 0; i < static_cast<size_t>(Histogram::COUNT); i++)
+		registry.retired.histograms[i].absorb(block->histograms[i]);
+	block->client = nullptr;
+	block->client_signature_size = 0;
+
+	for (auto it = registry.blocks.begin(); it != registry.blocks.end(); ++it) {
+		if (it->get() == block) {
+			registry.free_blocks.push_back(std::move(*it));
+			registry.blocks.erase(it);
+			break;
+		}
+	}
+}
+
+Bn3Monkey::LogMetrics::Client* Bn3Monkey::LogMetrics::findClient(const char* signature, size_t size)
+{
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	std::string key{ signature, size };
+	auto it = registry.clients.find(key);
+	if (it != registry.clients.end())
+		return it->second.get();
+
+	if (registry.clients.size() >= MAX_CLIENTS) {
+		if (!registry.other_clients)
+			registry.other_clients.reset(new Client());
+		return registry.other_clients.get();
+	}
+
+	auto* client = new Client();
+	client->signature = key;
+	registry.clients.emplace(std::move(key), std::unique_ptr<Client>(client));
+	return client;
+}
+
+void Bn3Monkey::LogMetrics::addClient(const char* signature, size_t bytes)
+{
+	auto& block = getLocalBlock();
+	size_t size = strnlen(signature, LogHeader::SIGNATURE_SIZE);
+
+	// 한 연결은 대개 같은 signature로 계속 보내므로 마지막으로 찾은 것만 기억해 둔다
+	if (!block.client || block.client_signature_size != size || memcmp(block.client_signature, signature, size) != 0) {
+		block.client = findClient(signature, size);
+		memcpy(block.client_signature, signature, size);
+		block.client_signature_size = size;
+	}
+	block.client->lines.fetch_add(1, std::memory_order_relaxed);
+	block.client->bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint64_t Bn3Monkey::LogMetrics::get(Counter counter)
+{
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	uint64_t ret = registry.retired.counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+	for (auto& block : registry.blocks)
+		ret += block->counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+	return ret;
+}
+
+void Bn3Monkey::LogMetrics::render(std::string& output)
+{
+	auto& registry = getRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (size_t i = 0; i < static_cast<size_t>(Counter::COUNT); i++) {
+		uint64_t value = registry.retired.counters[i].load(std::memory_order_relaxed);
+		for (auto& block : registry.blocks)
+			value += block->counters[i].load(std::memory_order_relaxed);
+
+		auto& description = counter_descriptions[i];
+		renderHeader(output, description.name, "counter", description.help);
+		renderValue(output, description.name, static_cast<double>(value));
+	}
+
+	char buffer[256];
+	std::vector<uint64_t> counts;
+	for (size_t i = 0; i < static_cast<size_t>(Histogram::COUNT); i++) {
+		counts.assign(LogLatencyHistogram::BUCKET_COUNT, 0);
+		uint64_t sum = registry.retired.histograms[i].collect(counts);
+		for (auto& block : registry.blocks)
+			sum += block->histograms[i].collect(counts);
+		uint64_t total = 0;
+		for (auto count : counts)
+			total += count;
+
+		auto& description = histogram_descriptions[i];
+		renderHeader(output, description.name, "summary", description.help);
+
+		size_t bucket = 0;
+		uint64_t seen = 0;
+		for (double quantile : quantiles) {
+			uint64_t target = static_cast<uint64_t>(quantile * total + 0.5);
+			if (target == 0)
+				target = 1;
+			while (bucket < counts.size() && seen + counts[bucket] < target)
+				seen += counts[bucket++];
+			double value = total == 0 || bucket >= counts.size() ? 0.0 : LogLatencyHistogram::getUpperBound(bucket) / 1e9;
+			snprintf(buffer, sizeof(buffer), "%s{quantile=\"%g\"} %.9g\n", description.name, quantile, value);
+			output += buffer;
+		}
+		snprintf(buffer, sizeof(buffer), "%s_sum %.9g\n%s_count %" PRIu64 "\n", description.name, sum / 1e9, description.name, total);
+		output += buffer;
+	}
+
+	// 클라이언트별 초당 개수는 Prometheus에서 rate()로 구한다
+	renderHeader(output, "slog_client_lines_total", "counter", "Log lines received per client signature");
+	for (auto& item : registry.clients) {
+		output += "slog_client_lines_total{signature=\"";
+		appendEscaped(output, item.second->signature);
+		snprintf(buffer, sizeof(buffer), "\"} %" PRIu64 "\n", item.second->lines.load(std::memory_order_relaxed));
+		output += buffer;
+	}
+	if (registry.other_clients) {
+		snprintf(buffer, sizeof(buffer), "slog_client_lines_total{signature=\"(other)\"} %" PRIu64 "\n", registry.other_clients->lines.load(std::memory_order_relaxed));
+		output += buffer;
+	}
+
+	renderHeader(output, "slog_client_bytes_total", "counter", "Bytes of log frames received per client signature");
+	for (auto& item : registry.clients) {
+		output += "slog_client_bytes_total{signature=\"";
+		appendEscaped(output, item.second->signature);
+		snprintf(buffer, sizeof(buffer), "\"} %" PRIu64 "\n", item.second->bytes.load(std::memory_order_relaxed));
+		output += buffer;
+	}
+	if (registry.other_clients) {
+		snprintf(buffer, sizeof(buffer), "slog_client_bytes_total{signature=\"(other)\"} %" PRIu64 "\n", registry.other_clients->bytes.load(std::memory_order_relaxed));
+		output += buffer;
+	}
+}
+
+void Bn3Monkey::LogMetrics::renderHeader(std::string& output, const char* name, const char* type, const char* help)
+{
+	output += "# HELP ";
+	output += name;
+	output += ' ';
+	output += help;
+	output += "\n# TYPE ";
+	output += name;
+	output += ' ';
+	output += type;
+	output += '\n';
+}
+
+void Bn3Monkey::LogMetrics::renderValue(std::string& output, const char* name, double value)
+{
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "%s %.17g\n", name, value);
+	output += buffer;
+}
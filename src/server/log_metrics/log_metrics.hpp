@@ -0,0 +1,160 @@
+#ifndef __BN3MONKEY_LOG_METRICS__
+#define __BN3MONKEY_LOG_METRICS__
+
+#include <simple_log_protocol.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Bn3Monkey
+{
+    // Log-linear histogram of nanoseconds : 32 sub-buckets per power of two (~3% precision).
+    // Recorded by one thread and read by any.
+    class LogLatencyHistogram
+    {
+    public:
+        static constexpr size_t SUB_BUCKET_BITS = 5;
+        static constexpr size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        inline void record(uint64_t value) {
+            auto& count = _counts[getIndex(value)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            _sum.store(_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        // Adds the counts into counts (BUCKET_COUNT) and returns the sum of the recorded values
+        uint64_t collect(std::vector<uint64_t>& counts) const;
+        // Moves what other recorded into this one. Neither may be recorded meanwhile.
+        void absorb(LogLatencyHistogram& other);
+
+        static inline size_t getIndex(uint64_t value) {
+            if (value < SUB_BUCKETS)
+                return static_cast<size_t>(value);
+#if defined(_MSC_VER)
+            unsigned long msb;
+            _BitScanReverse64(&msb, value);
+#else
+            size_t msb = 63 - __builtin_clzll(value);
+#endif
+            size_t shift = msb - SUB_BUCKET_BITS;
+            return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+        }
+        // Largest value counted in the bucket
+        static uint64_t getUpperBound(size_t index);
+
+    private:
+        std::atomic<uint64_t> _counts[BUCKET_COUNT]{};
+        std::atomic<uint64_t> _sum{ 0 };
+    };
+
+    // Process-wide counters and latency histograms of the server.
+    // Every thread updates its own block without atomic read-modify-writes or shared cache lines,
+    // the blocks are only summed up when the metrics are rendered.
+    class LogMetrics
+    {
+    public:
+        enum class Counter : uint8_t
+        {
+            LINES_RECEIVED,
+            BYTES_RECEIVED,
+            // frames rejected by LogLine::isValid
+            INVALID_RECORDS,
+            // frames rejected by LogLine::isIntact
+            CORRUPTED_RECORDS,
+            // times a connection lost its framing and searched for the next header, and the bytes skipped doing so
+            RESYNCHRONIZATIONS,
+            SKIPPED_BYTES,
+            FORMAT_DEFINITIONS,
+            CONNECTIONS_OPENED,
+            CONNECTIONS_CLOSED,
+            // connections closed right after accept because the process ran out of file descriptors
+            CONNECTIONS_REJECTED,
+            LINES_WRITTEN,
+            LINES_DROPPED,
+            BYTES_WRITTEN,
+            COMMITS,
+            SEGMENTS_OPENED,
+            COUNT,
+        };
+
+        enum class Histogram : uint8_t
+        {
+            // LogPool::writeBatch of one drained arena
+            BATCH_WRITE,
+            // msync (or the DIRECT writer's commit) of the dirty ranges
+            COMMIT,
+            // closing a segment and swapping in the next one
+            ROTATION,
+            COUNT,
+        };
+
+        // distinct signatures counted one by one, the others are counted together
+        static constexpr size_t MAX_CLIENTS = 1024;
+
+        static inline void add(Counter counter, uint64_t value = 1) {
+            auto& count = getLocalBlock().counters[static_cast<size_t>(counter)];
+            count.store(count.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+        static inline void record(Histogram histogram, uint64_t nanoseconds) {
+            getLocalBlock().histograms[static_cast<size_t>(histogram)].record(nanoseconds);
+        }
+        // Counts a line of the client with signature (at most LogHeader::SIGNATURE_SIZE bytes)
+        static void addClient(const char* signature, size_t bytes);
+
+        static inline uint64_t now() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static uint64_t get(Counter counter);
+        // Appends every metric in the Prometheus text format (version 0.0.4)
+        static void render(std::string& output);
+
+        // Prometheus text helpers for metrics kept elsewhere (e.g. gauges of a server)
+        static void renderHeader(std::string& output, const char* name, const char* type, const char* help);
+        static void renderValue(std::string& output, const char* name, double value);
+
+    private:
+        struct Client;
+        struct Registry;
+
+        struct Block
+        {
+            std::atomic<uint64_t> counters[static_cast<size_t>(Counter::COUNT)]{};
+            LogLatencyHistogram histograms[static_cast<size_t>(Histogram::COUNT)];
+
+            // the client this thread counted last
+            Client* client{ nullptr };
+            char client_signature[LogHeader::SIGNATURE_SIZE]{ 0 };
+            size_t client_signature_size{ 0 };
+        };
+
+        // Hands the block of a thread back when the thread exits
+        struct LocalBlock
+        {
+            LocalBlock() : block(createBlock()) {}
+            ~LocalBlock() { retireBlock(block); }
+            Block* block;
+        };
+
+        static inline Block& getLocalBlock() {
+            thread_local LocalBlock local;
+            return *local.block;
+        }
+        static Block* createBlock();
+        // Folds the counts of an exited thread into the retired totals, so that the totals do not go backwards,
+        // and keeps the block for the next thread
+        static void retireBlock(Block* block);
+        static Client* findClient(const char* signature, size_t size);
+        static Registry& getRegistry();
+    };
+}
+
+#endif // __BN3MONKEY_LOG_METRICS__
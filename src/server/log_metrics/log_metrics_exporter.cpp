@@ -0,0 +1,207 @@
+#include "log_metrics_exporter.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace Bn3Monkey;
+
+// 요청을 기다리다가 종료를 확인하는 주기
+static constexpr int POLL_INTERVAL_MS = 200;
+
+Bn3Monkey::LogMetricsExporter::LogMetricsExporter(const LogMetricsConfiguration& configuration, Render render) :
+	_configuration(configuration),
+	_render(std::move(render))
+{
+	if (!_configuration.file.empty()) {
+		_file_thread = std::thread{ [&]() { runFile(); } };
+	}
+
+	if (_configuration.http_port != 0) {
+#if defined(_WIN32)
+		printf("[[SYSTEM]] The metrics endpoint is not available on Windows\n");
+#else
+		int sock = socket(AF_INET, SOCK_STREAM, 0);
+		int on = 1;
+		setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		// 메트릭은 같은 머신의 수집기만 읽는다
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(static_cast<uint16_t>(_configuration.http_port));
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (sock < 0 || bind(sock, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(sock, 16) != 0) {
+			printf("[[SYSTEM]] Cannot serve metrics on port %u (%s)\n", _configuration.http_port, strerror(errno));
+			if (sock >= 0)
+				::close(sock);
+			return;
+		}
+		_listener = sock;
+		_http_thread = std::thread{ [&]() { runHttp(); } };
+#endif // _WIN32
+	}
+}
+
+Bn3Monkey::LogMetricsExporter::~LogMetricsExporter()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_running = false;
+		_cv.notify_all();
+	}
+	if (_file_thread.joinable())
+		_file_thread.join();
+	if (_http_thread.joinable())
+		_http_thread.join();
+
+#if !defined(_WIN32)
+	if (_listener >= 0)
+		::close(_listener);
+#endif // _WIN32
+}
+
+void Bn3Monkey::LogMetricsExporter::runFile()
+{
+	while (true) {
+		writeFile();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_cv.wait_for(lock, _configuration.file_interval, [&]() { return !_is_running; }))
+			break;
+	}
+	// 종료 시점의 값을 남긴다
+	writeFile();
+}
+
+bool Bn3Monkey::LogMetricsExporter::writeFile()
+{
+	std::string text;
+	_render(text);
+
+	// 읽는 쪽이 쓰다 만 파일을 보지 않도록 임시 파일에 쓰고 바꿔 넣는다
+	std::string temporary_path = _configuration.file + ".tmp";
+	FILE* file = fopen(temporary_path.c_str(), "wb");
+	if (!file)
+		return false;
+	bool is_written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	is_written = fclose(file) == 0 && is_written;
+	if (!is_written)
+		return false;
+
+	std::error_code error;
+	std::filesystem::rename(temporary_path, _configuration.file, error);
+	return !error;
+}
+
+#if defined(_WIN32)
+
+void Bn3Monkey::LogMetricsExporter::runHttp()
+{
+}
+
+void Bn3Monkey::LogMetricsExporter::respond(int client)
+{
+}
+
+#else
+
+void Bn3Monkey::LogMetricsExporter::runHttp()
+{
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_is_running)
+				break;
+		}
+
+		pollfd listener{ _listener, POLLIN, 0 };
+		if (poll(&listener, 1, POLL_INTERVAL_MS) <= 0)
+			continue;
+
+		int client = accept(_listener, nullptr, nullptr);
+		if (client < 0)
+			continue;
+		respond(client);
+		::close(client);
+	}
+}
+
+void Bn3Monkey::LogMetricsExporter::respond(int client)
+{
+	// 요청 줄만 보면 되므로 헤더 끝까지 읽지 않는다
+	char request[1024]{ 0 };
+	size_t size = 0;
+	while (size < sizeof(request) - 1 && !memchr(request, '\n', size)) {
+		pollfd readable{ client, POLLIN, 0 };
+		if (poll(&readable, 1, POLL_INTERVAL_MS * 5) <= 0)
+			return;
+		ssize_t result = recv(client, request + size, sizeof(request) - 1 - size, 0);
+		if (result <= 0)
+			return;
+		size += static_cast<size_t>(result);
+	}
+
+	std::string body;
+	const char* status = "200 OK";
+	// "/metricsfoo" 같은 다른 경로는 받지 않는다
+	bool is_metrics = strncmp(request, "GET /metrics", 12) == 0 && (request[12] == ' ' || request[12] == '?');
+	if (strncmp(request, "GET / ", 6) == 0 || is_metrics) {
+		_render(body);
+	}
+	else {
+		status = "404 Not Found";
+		body = "Not Found\n";
+	}
+
+	char header[256];
+	int header_size = snprintf(header, sizeof(header),
+		"HTTP/1.0 %s\r\n"
+		"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+		"Content-Length: %zu\r\n"
+		"Connection: close\r\n"
+		"\r\n", status, body.size());
+
+	std::string response{ header, static_cast<size_t>(header_size) };
+	response += body;
+	// 읽지 않는 수집기가 종료를 막지 않도록 보낼 수 있을 때만 보내고, 오래 막히면 끊는다
+	int flags = MSG_DONTWAIT;
+#if defined(MSG_NOSIGNAL)
+	flags |= MSG_NOSIGNAL;
+#endif
+	size_t sent = 0;
+	int waited_ms = 0;
+	while (sent < response.size() && waited_ms < POLL_INTERVAL_MS * 5) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_is_running)
+				return;
+		}
+		pollfd writable{ client, POLLOUT, 0 };
+		int ready = poll(&writable, 1, POLL_INTERVAL_MS);
+		if (ready < 0)
+			return;
+		if (ready == 0) {
+			waited_ms += POLL_INTERVAL_MS;
+			continue;
+		}
+
+		ssize_t result = send(client, response.data() + sent, response.size() - sent, flags);
+		if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			continue;
+		if (result <= 0)
+			return;
+		sent += static_cast<size_t>(result);
+		waited_ms = 0;
+	}
+}
+
+#endif // _WIN32
@@ -0,0 +1,58 @@
+#ifndef __BN3MONKEY_LOG_METRICS_EXPORTER__
+#define __BN3MONKEY_LOG_METRICS_EXPORTER__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    struct LogMetricsConfiguration
+    {
+        // rewrite this file with the metrics every file_interval (empty : no file)
+        std::string file;
+        std::chrono::milliseconds file_interval{ 10000 };
+        // serve the metrics at http://127.0.0.1:<http_port>/metrics (0 : no endpoint, POSIX only)
+        uint32_t http_port{ 0 };
+    };
+
+    // Publishes the Prometheus text a render callback produces, either as a file (for a node exporter
+    // textfile collector or a plain cat) or on a local HTTP endpoint that a Prometheus server can scrape.
+    // The text is only rendered when the file is due or a request came in.
+    class LogMetricsExporter
+    {
+    public:
+        using Render = std::function<void(std::string& output)>;
+
+        LogMetricsExporter(const LogMetricsConfiguration& configuration, Render render);
+        ~LogMetricsExporter();
+
+        LogMetricsExporter(const LogMetricsExporter&) = delete;
+        LogMetricsExporter& operator=(const LogMetricsExporter&) = delete;
+
+        inline bool isServing() const { return _listener >= 0; }
+
+    private:
+        void runFile();
+        void runHttp();
+        bool writeFile();
+        void respond(int client);
+
+        LogMetricsConfiguration _configuration;
+        Render _render;
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _is_running{ true };
+
+        int _listener{ -1 };
+        std::thread _file_thread;
+        std::thread _http_thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_METRICS_EXPORTER__
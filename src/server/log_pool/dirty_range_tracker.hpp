@@ -0,0 +1,75 @@
+#ifndef __BN3MONKEY_DIRTY_RANGE_TRACKER__
+#define __BN3MONKEY_DIRTY_RANGE_TRACKER__
+
+#include <cstddef>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Byte ranges of a mapped segment that were written but not committed yet.
+    // Ranges are widened to page boundaries (msync only accepts page-aligned addresses)
+    // and overlapping or adjacent ranges are merged, so each flush needs as few commits as possible.
+    class DirtyRangeTracker
+    {
+    public:
+        struct Span {
+            size_t offset;
+            size_t length;
+        };
+
+        explicit DirtyRangeTracker(size_t page_size) : _page_size(page_size ? page_size : 1) {}
+
+        void mark(size_t offset, size_t length)
+        {
+            if (length == 0)
+                return;
+
+            size_t begin = offset / _page_size * _page_size;
+            size_t end = (offset + length + _page_size - 1) / _page_size * _page_size;
+
+            // 로그는 뒤로만 붙으므로 대부분 마지막 구간과 합쳐진다
+            auto it = _spans.end();
+            while (it != _spans.begin() && (it - 1)->offset > begin)
+                --it;
+
+            if (it != _spans.begin() && (it - 1)->offset + (it - 1)->length >= begin) {
+                --it;
+            }
+            else {
+                it = _spans.insert(it, Span{ begin, 0 });
+            }
+
+            size_t merged_end = it->offset + it->length > end ? it->offset + it->length : end;
+            auto next = it + 1;
+            while (next != _spans.end() && next->offset <= merged_end) {
+                if (next->offset + next->length > merged_end)
+                    merged_end = next->offset + next->length;
+                ++next;
+            }
+            it->length = merged_end - it->offset;
+            _spans.erase(it + 1, next);
+        }
+
+        // Moves every pending span into spans, sorted by offset
+        void take(std::vector<Span>& spans)
+        {
+            spans.clear();
+            spans.swap(_spans);
+        }
+
+        inline void clear() { _spans.clear(); }
+        inline bool empty() const { return _spans.empty(); }
+        inline size_t pendingBytes() const {
+            size_t ret = 0;
+            for (auto& span : _spans)
+                ret += span.length;
+            return ret;
+        }
+
+    private:
+        size_t _page_size;
+        std::vector<Span> _spans;
+    };
+}
+
+#endif // __BN3MONKEY_DIRTY_RANGE_TRACKER__
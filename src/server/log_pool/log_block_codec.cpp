@@ -0,0 +1,189 @@
+#include "log_block_codec.hpp"
+
+#include <cstring>
+#include <vector>
+
+#if defined(SIMPLE_LOG_SERVER_USE_LZ4)
+#include <lz4.h>
+#endif
+
+using namespace Bn3Monkey;
+
+#if !defined(SIMPLE_LOG_SERVER_USE_LZ4)
+namespace
+{
+	// LZ4 block format
+	//   sequence : token | literal length+ | literals | offset (2, LE) | match length+
+	//   token    : literal length (high 4 bits) | match length - 4 (low 4 bits), 15 means more bytes follow
+	// The last sequence has literals only, the last match starts at least 12 bytes before the end
+	// and the last 5 bytes are always literals.
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t LAST_LITERALS = 5;
+	constexpr size_t MATCH_FIND_LIMIT = 12;
+	constexpr size_t MAX_OFFSET = 65535;
+	constexpr uint32_t HASH_BITS = 12;
+
+	inline uint32_t read32(const char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t hash(uint32_t value)
+	{
+		return (value * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	inline bool writeLength(char*& op, const char* end, size_t length)
+	{
+		while (length >= 255) {
+			if (op >= end)
+				return false;
+			*op++ = static_cast<char>(255);
+			length -= 255;
+		}
+		if (op >= end)
+			return false;
+		*op++ = static_cast<char>(length);
+		return true;
+	}
+
+	inline bool writeLiterals(char*& op, const char* end, const char* literals, size_t length, uint8_t match_token)
+	{
+		if (op >= end)
+			return false;
+		char* token = op++;
+		*token = static_cast<char>(((length >= 15 ? 15 : length) << 4) | match_token);
+		if (length >= 15 && !writeLength(op, end, length - 15))
+			return false;
+		if (static_cast<size_t>(end - op) < length)
+			return false;
+		memcpy(op, literals, length);
+		op += length;
+		return true;
+	}
+
+	inline bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+	{
+		uint8_t value;
+		do {
+			if (ip >= end)
+				return false;
+			value = *ip++;
+			length += value;
+		} while (value == 255);
+		return true;
+	}
+}
+#endif
+
+size_t Bn3Monkey::LogBlockCodec::compress(const char* src, size_t size, char* dest, size_t capacity)
+{
+#if defined(SIMPLE_LOG_SERVER_USE_LZ4)
+	int ret = LZ4_compress_default(src, dest, static_cast<int>(size), static_cast<int>(capacity));
+	return ret > 0 ? static_cast<size_t>(ret) : 0;
+#else
+	char* op = dest;
+	const char* op_end = dest + capacity;
+	size_t anchor = 0;
+
+	if (size > MATCH_FIND_LIMIT) {
+		// 위치 + 1을 저장해서 0을 빈 칸으로 쓴다
+		std::vector<uint32_t> table(1u << HASH_BITS, 0);
+		const size_t match_limit = size - MATCH_FIND_LIMIT;
+		const size_t match_end = size - LAST_LITERALS;
+
+		size_t ip = 0;
+		while (ip < match_limit) {
+			uint32_t sequence = read32(src + ip);
+			uint32_t& slot = table[hash(sequence)];
+			size_t ref = slot;
+			slot = static_cast<uint32_t>(ip + 1);
+
+			if (ref == 0 || ip - (ref - 1) > MAX_OFFSET || read32(src + ref - 1) != sequence) {
+				ip++;
+				continue;
+			}
+			ref -= 1;
+
+			size_t length = MIN_MATCH;
+			while (ip + length < match_end && src[ref + length] == src[ip + length])
+				length++;
+
+			size_t match_length = length - MIN_MATCH;
+			if (!writeLiterals(op, op_end, src + anchor, ip - anchor, static_cast<uint8_t>(match_length >= 15 ? 15 : match_length)))
+				return 0;
+			if (op_end - op < 2)
+				return 0;
+			size_t offset = ip - ref;
+			*op++ = static_cast<char>(offset & 0xFF);
+			*op++ = static_cast<char>(offset >> 8);
+			if (match_length >= 15 && !writeLength(op, op_end, match_length - 15))
+				return 0;
+
+			ip += length;
+			anchor = ip;
+		}
+	}
+
+	if (!writeLiterals(op, op_end, src + anchor, size - anchor, 0))
+		return 0;
+	return static_cast<size_t>(op - dest);
+#endif
+}
+
+bool Bn3Monkey::LogBlockCodec::decompress(const char* src, size_t size, char* dest, size_t raw_size)
+{
+#if defined(SIMPLE_LOG_SERVER_USE_LZ4)
+	int ret = LZ4_decompress_safe(src, dest, static_cast<int>(size), static_cast<int>(raw_size));
+	return ret >= 0 && static_cast<size_t>(ret) == raw_size;
+#else
+	const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+	const uint8_t* ip_end = ip + size;
+	size_t op = 0;
+
+	while (ip < ip_end) {
+		uint8_t token = *ip++;
+
+		size_t literal_length = token >> 4;
+		if (literal_length == 15 && !readLength(ip, ip_end, literal_length))
+			return false;
+		if (static_cast<size_t>(ip_end - ip) < literal_length || raw_size - op < literal_length)
+			return false;
+		memcpy(dest + op, ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		// 마지막 sequence에는 match가 없다
+		if (ip == ip_end)
+			break;
+
+		if (ip_end - ip < 2)
+			return false;
+		size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > op)
+			return false;
+
+		size_t match_length = token & 0x0F;
+		if (match_length == 15 && !readLength(ip, ip_end, match_length))
+			return false;
+		match_length += MIN_MATCH;
+		if (raw_size - op < match_length)
+			return false;
+
+		// 겹치는 복사는 앞에서부터 한 바이트씩 해야 반복 패턴이 된다
+		const char* match = dest + op - offset;
+		if (offset >= match_length) {
+			memcpy(dest + op, match, match_length);
+		}
+		else {
+			for (size_t i = 0; i < match_length; i++)
+				dest[op + i] = match[i];
+		}
+		op += match_length;
+	}
+	return op == raw_size;
+#endif
+}
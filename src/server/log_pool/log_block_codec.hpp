@@ -0,0 +1,25 @@
+#ifndef __BN3MONKEY_LOG_BLOCK_CODEC__
+#define __BN3MONKEY_LOG_BLOCK_CODEC__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Bn3Monkey
+{
+    // LZ4 block format compression of segment blocks.
+    // Uses the system liblz4 when it is built with SIMPLE_LOG_SERVER_USE_LZ4, otherwise a built-in codec
+    // that writes and reads the same format, so files are interchangeable between the two.
+    class LogBlockCodec
+    {
+    public:
+        // Largest compressed size of size bytes
+        static constexpr size_t getCompressBound(size_t size) { return size + size / 255 + 16; }
+
+        // Returns the compressed size, or 0 if it does not fit in capacity
+        static size_t compress(const char* src, size_t size, char* dest, size_t capacity);
+        // Returns false unless src is a valid block that decompresses to exactly raw_size bytes
+        static bool decompress(const char* src, size_t size, char* dest, size_t raw_size);
+    };
+}
+
+#endif // __BN3MONKEY_LOG_BLOCK_CODEC__
@@ -0,0 +1,250 @@
+#if defined(__linux__)
+
+#include "log_direct_segment_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Bn3Monkey;
+
+Bn3Monkey::LogDirectSegmentWriter::LogDirectSegmentWriter(const char* path, size_t size, size_t buffer_size, size_t buffer_count) :
+	_buffer_size((buffer_size < 2 * ALIGNMENT ? 2 * ALIGNMENT : buffer_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT)
+{
+	open(path, O_CREAT | O_EXCL, size, buffer_count, 0);
+}
+
+Bn3Monkey::LogDirectSegmentWriter::LogDirectSegmentWriter(const char* path, size_t size, size_t buffer_size, size_t buffer_count, size_t used_size) :
+	_buffer_size((buffer_size < 2 * ALIGNMENT ? 2 * ALIGNMENT : buffer_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT)
+{
+	open(path, 0, size, buffer_count, used_size);
+}
+
+void Bn3Monkey::LogDirectSegmentWriter::open(const char* path, int flags, size_t size, size_t buffer_count, size_t used_size)
+{
+	if (size == 0) {
+		_code = MemoryMappedFile::Code::CREATED_FILE_NEED_NON_ZERO_SIZE;
+		return;
+	}
+
+	_fd = ::open(path, O_RDWR | O_CLOEXEC | flags, 0644);
+	if (_fd < 0) {
+		_code = errno == EEXIST ? MemoryMappedFile::Code::FILE_ALREADY_EXISTS : MemoryMappedFile::Code::CANNOT_OPEN_FILE;
+		return;
+	}
+	// 블록을 미리 잡아 두면 fdatasync가 메타데이터까지 쓰지 않아도 된다
+	if (posix_fallocate(_fd, 0, static_cast<off_t>(size)) != 0)
+		(void)ftruncate(_fd, static_cast<off_t>(size));
+
+	_buffers.resize(buffer_count < 2 ? 2 : buffer_count);
+	for (auto& buffer : _buffers) {
+		void* data = nullptr;
+		if (posix_memalign(&data, ALIGNMENT, _buffer_size) != 0) {
+			stop(0);
+			_code = MemoryMappedFile::Code::CANNOT_MAP_FILE;
+			return;
+		}
+		buffer.data = static_cast<char*>(data);
+	}
+
+	// 이어 쓰는 세그먼트는 덜 찬 마지막 블록을 읽어 두고 그 블록부터 다시 쓴다
+	if (used_size > 0) {
+		auto& buffer = _buffers[_current];
+		buffer.offset = used_size / ALIGNMENT * ALIGNMENT;
+		size_t tail = used_size - buffer.offset;
+		if (tail > 0 && pread(_fd, buffer.data, tail, static_cast<off_t>(buffer.offset)) != static_cast<ssize_t>(tail)) {
+			stop(used_size);
+			_code = MemoryMappedFile::Code::CANNOT_OPEN_FILE;
+			return;
+		}
+		_end = used_size;
+		_sealed_end = used_size;
+	}
+
+	// O_DIRECT를 지원하지 않는 파일 시스템(tmpfs 등)에서는 page cache를 거쳐서 쓴다
+	int status = fcntl(_fd, F_GETFL);
+	if (status >= 0)
+		fcntl(_fd, F_SETFL, status | O_DIRECT);
+
+	_size = size;
+	_code = MemoryMappedFile::Code::SUCCESS;
+	_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::LogDirectSegmentWriter::~LogDirectSegmentWriter()
+{
+	// 잘라내지 않고 쓴 것만 마저 내보낸다
+	if (_code == MemoryMappedFile::Code::SUCCESS)
+		release(_size);
+	stop(_size);
+}
+
+char* Bn3Monkey::LogDirectSegmentWriter::reserve(size_t offset, size_t size)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (offset + size > _buffers[_current].offset + _buffer_size)
+		seal(lock, false);
+	_is_reserved = true;
+	return _buffers[_current].data + (offset - _buffers[_current].offset);
+}
+
+void Bn3Monkey::LogDirectSegmentWriter::written(size_t offset, size_t size)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_end = offset + size;
+	_is_reserved = false;
+	if (_is_seal_requested) {
+		bool is_synced = _is_sync_requested;
+		_is_seal_requested = false;
+		_is_sync_requested = false;
+		seal(lock, is_synced);
+	}
+}
+
+bool Bn3Monkey::LogDirectSegmentWriter::commit(size_t, size_t, Sync sync)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if (error() != MemoryMappedFile::Code::SUCCESS)
+		return false;
+
+	const bool is_synced = sync == Sync::SYNCHRONOUS;
+	uint64_t ticket = 0;
+	if (_is_reserved) {
+		// 다른 스레드가 쓰고 있는 버퍼는 written()에서 넘긴다
+		_is_seal_requested = true;
+		_is_sync_requested = _is_sync_requested || is_synced;
+		_cv.wait(lock, [&]() { return !_is_seal_requested; });
+		ticket = _next_ticket;
+	}
+	else {
+		ticket = seal(lock, is_synced);
+	}
+
+	if (is_synced)
+		_cv.wait(lock, [&]() { return _completed_ticket >= ticket; });
+	return !_is_failed;
+}
+
+bool Bn3Monkey::LogDirectSegmentWriter::release(size_t used_size)
+{
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_code != MemoryMappedFile::Code::SUCCESS)
+			return false;
+		if (!_is_failed) {
+			uint64_t ticket = seal(lock, true);
+			_cv.wait(lock, [&]() { return _completed_ticket >= ticket; });
+		}
+	}
+	bool ret = !_is_failed;
+	stop(used_size);
+	return ret;
+}
+
+uint64_t Bn3Monkey::LogDirectSegmentWriter::seal(std::unique_lock<std::mutex>& lock, bool is_synced)
+{
+	// 다음 버퍼가 아직 쓰이는 중이면 I/O 스레드를 기다린다. 기다리는 동안 다른 스레드가 먼저 넘겼을 수 있다.
+	_cv.wait(lock, [&]() { return !_buffers[(_current + 1) % _buffers.size()].is_busy; });
+	if (_end == _sealed_end)
+		return is_synced ? requestSync() : _next_ticket;
+
+	auto& buffer = _buffers[_current];
+	size_t used = _end - buffer.offset;
+	size_t aligned = (used + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	memset(buffer.data + used, 0, aligned - used);
+
+	// 덜 찬 마지막 블록은 다음 버퍼로 옮겨서 이어 쓰고, 다 차면 다시 쓴다
+	size_t next = (_current + 1) % _buffers.size();
+	size_t tail = _end / ALIGNMENT * ALIGNMENT;
+	memcpy(_buffers[next].data, buffer.data + (tail - buffer.offset), _end - tail);
+	_buffers[next].offset = tail;
+
+	buffer.is_busy = true;
+	_requests.push_back(Request{ _current, aligned, is_synced, ++_next_ticket });
+	_current = next;
+	_sealed_end = _end;
+	_cv.notify_all();
+	return _next_ticket;
+}
+
+uint64_t Bn3Monkey::LogDirectSegmentWriter::requestSync()
+{
+	_requests.push_back(Request{ _buffers.size(), 0, true, ++_next_ticket });
+	_cv.notify_all();
+	return _next_ticket;
+}
+
+void Bn3Monkey::LogDirectSegmentWriter::run()
+{
+	while (true) {
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&]() { return !_requests.empty() || !_is_running; });
+			if (_requests.empty())
+				break;
+			request = _requests.front();
+		}
+
+		// 한 번 실패하면 빈 곳 뒤에 이어 쓰지 않고 남은 요청은 끝난 것으로만 처리한다
+		bool is_failed = _is_failed.load(std::memory_order_relaxed);
+		if (!is_failed && request.buffer < _buffers.size()) {
+			auto& buffer = _buffers[request.buffer];
+			size_t written = 0;
+			while (written < request.size) {
+				ssize_t result = pwrite(_fd, buffer.data + written, request.size - written, static_cast<off_t>(buffer.offset + written));
+				if (result < 0 && errno == EINTR)
+					continue;
+				if (result <= 0) {
+					printf("[[SYSTEM]] Cannot write a segment (%s)\n", result < 0 ? strerror(errno) : "short write");
+					is_failed = true;
+					break;
+				}
+				written += static_cast<size_t>(result);
+			}
+		}
+		if (!is_failed && request.is_synced && fdatasync(_fd) != 0) {
+			printf("[[SYSTEM]] Cannot sync a segment (%s)\n", strerror(errno));
+			is_failed = true;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (is_failed)
+				_is_failed.store(true, std::memory_order_relaxed);
+			_requests.pop_front();
+			if (request.buffer < _buffers.size())
+				_buffers[request.buffer].is_busy = false;
+			_completed_ticket = request.ticket;
+			_cv.notify_all();
+		}
+	}
+}
+
+void Bn3Monkey::LogDirectSegmentWriter::stop(size_t used_size)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_running = false;
+		_cv.notify_all();
+	}
+	if (_thread.joinable())
+		_thread.join();
+
+	if (_fd >= 0) {
+		// 블록 단위로 쓴 꼬리도 함께 잘라낸다
+		(void)ftruncate(_fd, static_cast<off_t>(used_size));
+		::close(_fd);
+		_fd = -1;
+	}
+	for (auto& buffer : _buffers) {
+		free(buffer.data);
+		buffer.data = nullptr;
+	}
+	_code = MemoryMappedFile::Code::CLOSED;
+}
+
+#endif // __linux__
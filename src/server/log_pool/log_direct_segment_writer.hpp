@@ -0,0 +1,99 @@
+#ifndef __BN3MONKEY_LOG_DIRECT_SEGMENT_WRITER__
+#define __BN3MONKEY_LOG_DIRECT_SEGMENT_WRITER__
+
+#include "log_segment_writer.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Segment writer without page cache faults or kernel write-back (Linux only).
+    // Records are encoded into a ring of aligned buffers. A commit, or a full buffer, hands the current buffer to an
+    // I/O thread that writes it with O_DIRECT (and fdatasync for synchronous commits) while the writing thread
+    // goes on in the next buffer, so writes and syncs are submitted without waiting for the storage.
+    // The last, partially filled block is carried over into the next buffer and written again once it grows.
+    // If the file system does not support O_DIRECT, the same aligned writes go through the page cache.
+    // A failed or short write, or a failed fdatasync, fails the segment : nothing more is written
+    // and commit() and release() return false.
+    class LogDirectSegmentWriter : public LogSegmentWriter
+    {
+    public:
+        static constexpr size_t ALIGNMENT = 4096;
+
+        // Creates a new segment
+        LogDirectSegmentWriter(const char* path, size_t size, size_t buffer_size, size_t buffer_count);
+        // Reopens an existing segment to append after its first used_size bytes
+        LogDirectSegmentWriter(const char* path, size_t size, size_t buffer_size, size_t buffer_count, size_t used_size);
+        ~LogDirectSegmentWriter() override;
+
+        MemoryMappedFile::Code error() const override {
+            return _is_failed.load(std::memory_order_relaxed) ? MemoryMappedFile::Code::CANNOT_WRITE_FILE : _code;
+        }
+        size_t size() const override { return _size; }
+        size_t getMaxReserve() const override { return _buffer_size - ALIGNMENT; }
+
+        char* reserve(size_t offset, size_t size) override;
+        void written(size_t offset, size_t size) override;
+        bool commit(size_t offset, size_t length, Sync sync) override;
+        bool release(size_t used_size) override;
+
+    private:
+        void open(const char* path, int flags, size_t size, size_t buffer_count, size_t used_size);
+
+        struct Buffer
+        {
+            char* data{ nullptr };
+            // file offset of data[0], a multiple of ALIGNMENT
+            size_t offset{ 0 };
+            bool is_busy{ false };
+        };
+        struct Request
+        {
+            // buffer to write or buffers.size() for an fdatasync only
+            size_t buffer;
+            size_t size;
+            bool is_synced;
+            uint64_t ticket;
+        };
+
+        void run();
+        // Queues the written part of the current buffer and continues in the next one. Called with _mutex held.
+        uint64_t seal(std::unique_lock<std::mutex>& lock, bool is_synced);
+        uint64_t requestSync();
+        // Stops the I/O thread and closes the file cut down to used_size bytes
+        void stop(size_t used_size);
+
+        MemoryMappedFile::Code _code{ MemoryMappedFile::Code::CLOSED };
+        int _fd{ -1 };
+        size_t _size{ 0 };
+        size_t _buffer_size;
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::vector<Buffer> _buffers;
+        size_t _current{ 0 };
+        // end of the records reported by written()
+        size_t _end{ 0 };
+        // end of the records handed to the I/O thread
+        size_t _sealed_end{ 0 };
+        // the writing thread is encoding into the current buffer, so a commit from another thread has to wait for written()
+        bool _is_reserved{ false };
+        bool _is_seal_requested{ false };
+        bool _is_sync_requested{ false };
+
+        std::deque<Request> _requests;
+        uint64_t _next_ticket{ 0 };
+        uint64_t _completed_ticket{ 0 };
+        // set by the I/O thread
+        std::atomic<bool> _is_failed{ false };
+        bool _is_running{ true };
+        std::thread _thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_DIRECT_SEGMENT_WRITER__
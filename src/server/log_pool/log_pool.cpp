@@ -0,0 +1,319 @@
+#include "log_pool.hpp"
+#include "../log_metrics/log_metrics.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace Bn3Monkey;
+
+static LogSegmentWriterConfiguration createWriterConfiguration(const LogPoolConfiguration& configuration)
+{
+	LogSegmentWriterConfiguration ret;
+	ret.type = configuration.segment_writer;
+	ret.segment_size = std::max(configuration.max_bytes_per_file, LogRecord::MAX_SIZE + LogSegmentFooter::SIZE);
+	ret.is_populated = configuration.is_populated;
+	ret.buffer_size = std::max(configuration.direct_buffer_size, LogRecord::MAX_SIZE * 2);
+	ret.buffer_count = configuration.direct_buffer_count;
+	return ret;
+}
+
+Bn3Monkey::LogPool::LogPool(const LogPoolConfiguration& configuration) :
+	_configuration(configuration),
+	_next_commit_line(configuration.interval_lines_of_commit),
+	_current_lines(0),
+	_current_offset(0),
+	_allocator(createWriterConfiguration(configuration), configuration.directory),
+	_index(configuration.index_block_records)
+{
+	if (_configuration.max_bytes_per_file < LogRecord::MAX_SIZE + LogSegmentFooter::SIZE)
+		_configuration.max_bytes_per_file = LogRecord::MAX_SIZE + LogSegmentFooter::SIZE;
+
+	if (_configuration.is_recovered)
+		recover();
+	_allocator.start();
+	if (!isOpened())
+		rotate();
+	_is_initialized = isOpened();
+
+	if (_configuration.durability == Durability::GROUP_COMMIT) {
+		_group_committer = std::thread{ [&]() { runGroupCommit(); } };
+	}
+}
+
+Bn3Monkey::LogPool::~LogPool()
+{
+	if (_group_committer.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(_dirty_mutex);
+			_is_running = false;
+			_dirty_cv.notify_one();
+		}
+		_group_committer.join();
+	}
+
+	// 마지막으로 남은 구간을 커밋하고, 남은 공간은 잘라내서 실제로 쓴 만큼만 디스크에 남긴다
+	commitDirtyRange(MemoryMappedFile::Sync::SYNCHRONOUS);
+	close();
+}
+
+bool Bn3Monkey::LogPool::write(const LogLine& line)
+{
+	return writeBatch(&line, 1) == 1;
+}
+
+size_t Bn3Monkey::LogPool::writeBatch(const LogLine* lines, size_t count)
+{
+	size_t ret = 0;
+	if (!isOpened()) {
+		// 이전 파일 생성이 실패했거나 저장 장치 오류로 멈춘 세그먼트라면 새 세그먼트로 바꾼다
+		rotate();
+	}
+
+	while (count > 0 && isOpened()) {
+		// 남은 공간에 최대 크기의 레코드가 몇 개 들어가는지로 한 번에 쓸 개수를 정한다. 푸터 자리는 남겨 둔다.
+		size_t room = std::min(_current_segment->size() - LogSegmentFooter::SIZE - _current_offset, _current_segment->getMaxReserve());
+		size_t available = room / LogRecord::MAX_SIZE;
+		size_t n = count < available ? count : available;
+
+		size_t prev_offset = _current_offset;
+		_current_offset = append(lines, n, _current_offset);
+		_current_lines += n;
+		LogMetrics::add(LogMetrics::Counter::BYTES_WRITTEN, _current_offset - prev_offset);
+		synchronize(_current_lines, prev_offset, _current_offset);
+		if (!isOpened() || !hasCapacity()) {
+			rotate();
+		}
+
+		lines += n;
+		count -= n;
+		ret += n;
+	}
+
+	if (count > 0) {
+		if (!_is_dropping)
+			printf("[[SYSTEM]] Cannot open a segment in %s, logs are dropped until one can be opened\n", _configuration.directory.empty() ? "." : _configuration.directory.c_str());
+		_is_dropping = true;
+	}
+	else if (_is_dropping && ret > 0) {
+		printf("[[SYSTEM]] Writing logs again in %s\n", _current_path.c_str());
+		_is_dropping = false;
+	}
+	return ret;
+}
+
+size_t Bn3Monkey::LogPool::append(const LogLine* lines, size_t count, size_t current_offset)
+{
+	char* dest = _current_segment->reserve(current_offset, count * LogRecord::MAX_SIZE);
+	char* begin = dest;
+	for (size_t i = 0; i < count; i++) {
+		size_t size = LogRecord::encode(dest, lines[i]);
+		if (_configuration.is_indexed)
+			_index.add(current_offset + (dest - begin), LogRecord(dest));
+		dest += size;
+	}
+	_current_segment->written(current_offset, dest - begin);
+	return current_offset + (dest - begin);
+}
+
+void Bn3Monkey::LogPool::synchronize(size_t current_lines, size_t prev_offset, size_t current_offset)
+{
+	if (_configuration.durability == Durability::GROUP_COMMIT) {
+		// 커밋은 group committer가 하고 여기서는 범위만 넘겨준다
+		std::lock_guard<std::mutex> lock(_dirty_mutex);
+		_dirty.mark(prev_offset, current_offset - prev_offset);
+		if (_dirty.pendingBytes() >= _configuration.group_commit_bytes)
+			_dirty_cv.notify_one();
+		return;
+	}
+
+	_dirty.mark(prev_offset, current_offset - prev_offset);
+	if (current_lines >= _next_commit_line) {
+		commitDirtyRange(getCommitSync());
+		_next_commit_line = current_lines + _configuration.interval_lines_of_commit;
+	}
+}
+
+MemoryMappedFile::Sync Bn3Monkey::LogPool::getCommitSync() const
+{
+	return _configuration.durability == Durability::ASYNC ? MemoryMappedFile::Sync::ASYNCHRONOUS : MemoryMappedFile::Sync::SYNCHRONOUS;
+}
+
+void Bn3Monkey::LogPool::runGroupCommit()
+{
+	while (_is_running) {
+		{
+			std::unique_lock<std::mutex> lock(_dirty_mutex);
+			_dirty_cv.wait_for(lock, _configuration.group_commit_interval, [&]() {
+				return !_is_running || _dirty.pendingBytes() >= _configuration.group_commit_bytes;
+			});
+		}
+		commitDirtyRange(MemoryMappedFile::Sync::SYNCHRONOUS);
+	}
+}
+
+void Bn3Monkey::LogPool::commitDirtyRange(MemoryMappedFile::Sync sync)
+{
+	std::lock_guard<std::mutex> file_lock(_file_mutex);
+
+	std::vector<DirtyRangeTracker::Span> spans;
+	{
+		std::lock_guard<std::mutex> lock(_dirty_mutex);
+		_dirty.take(spans);
+	}
+
+	if (!isOpened() || spans.empty())
+		return;
+	uint64_t begin = LogMetrics::now();
+	for (auto& span : spans) {
+		// 실패한 세그먼트는 쓰는 스레드가 다음 쓰기에서 바꾼다
+		if (!_current_segment->commit(span.offset, span.length, sync))
+			break;
+	}
+	LogMetrics::record(LogMetrics::Histogram::COMMIT, LogMetrics::now() - begin);
+	LogMetrics::add(LogMetrics::Counter::COMMITS);
+}
+
+bool Bn3Monkey::LogPool::hasCapacity()
+{
+	return _current_offset + LogRecord::MAX_SIZE + LogSegmentFooter::SIZE <= _current_segment->size();
+}
+
+void Bn3Monkey::LogPool::rotate()
+{
+	uint64_t begin = LogMetrics::now();
+	// 아직 커밋되지 않은 마지막 구간은 이전 파일을 닫기 전에 커밋한다
+	commitDirtyRange(getCommitSync());
+
+	std::lock_guard<std::mutex> file_lock(_file_mutex);
+	close();
+
+	_next_commit_line = _configuration.interval_lines_of_commit;
+
+	_current_lines = 0;
+	_current_offset = 0;
+	// 미리 만들어 둔 다음 파일로 바꾸기만 한다
+	_current_segment = _allocator.acquire(_current_path);
+	if (isOpened())
+		LogMetrics::add(LogMetrics::Counter::SEGMENTS_OPENED);
+	LogMetrics::record(LogMetrics::Histogram::ROTATION, LogMetrics::now() - begin);
+}
+
+void Bn3Monkey::LogPool::close()
+{
+	if (!_current_segment)
+		return;
+
+	if (!isOpened()) {
+		// 저장 장치 오류로 멈춘 세그먼트는 푸터 없이 닫고, 다음 시작 때 복구에 맡긴다
+		if (_current_segment->error() == MemoryMappedFile::Code::CANNOT_WRITE_FILE) {
+			printf("[[SYSTEM]] Cannot write %s, continuing in a new segment\n", _current_path.c_str());
+			_current_segment->release(_current_offset);
+			_index.clear();
+		}
+		_current_segment.reset();
+		return;
+	}
+
+	// 마지막 레코드 뒤에 푸터를 쓰고 레코드와 함께 저장한 뒤에 잘라낸다
+	char* footer = _current_segment->reserve(_current_offset, LogSegmentFooter::SIZE);
+	LogSegmentFooter::encode(footer, _current_lines, _current_offset);
+	_current_segment->written(_current_offset, LogSegmentFooter::SIZE);
+	size_t page = MemoryMappedFile::getPageSize();
+	size_t begin = _current_offset / page * page;
+	bool is_written = _current_segment->commit(begin, _current_offset + LogSegmentFooter::SIZE - begin, getCommitSync());
+
+	is_written = _current_segment->release(_current_offset + LogSegmentFooter::SIZE) && is_written;
+	_current_segment.reset();
+	if (!is_written) {
+		printf("[[SYSTEM]] Cannot write %s, it is recovered on the next start\n", _current_path.c_str());
+		_index.clear();
+		return;
+	}
+	if (_configuration.is_indexed) {
+		_index.save(LogSegmentIndexBuilder::getPath(_current_path).c_str());
+		_index.clear();
+	}
+	if (_configuration.is_compressed && _current_offset > 0)
+		_compactor.push(_current_path);
+}
+
+void Bn3Monkey::LogPool::recover()
+{
+	std::vector<std::string> segments = LogSegmentRecovery::listSegments(_configuration.directory);
+	LogSegmentWriterConfiguration writer_configuration = createWriterConfiguration(_configuration);
+
+	// 가장 최근 세그먼트부터 본다. 이어 쓸 수 있는 것은 레코드가 있는 가장 최근 세그먼트 하나뿐이다.
+	bool is_resumable = true;
+	for (size_t i = segments.size(); i-- > 0;) {
+		const std::string& path = segments[i];
+		std::string index_path = LogSegmentIndexBuilder::getPath(path);
+		std::error_code error;
+
+		// 인덱스는 세그먼트를 닫은 뒤에 쓰인다. 읽을 수 없는 인덱스는 없는 것으로 보고 다시 만든다.
+		uint64_t records_size = 0;
+		uint8_t flags = 0;
+		bool has_index = static_cast<bool>(LogSegmentIndex{ index_path.c_str() });
+		std::remove((index_path + ".tmp").c_str());
+		bool is_closed = LogSegmentRecovery::isClosed(path, records_size, &flags);
+		if (has_index || is_closed) {
+			// 닫혔지만 인덱스 저장이나 압축 전에 멈춘 세그먼트
+			is_resumable = false;
+			if (!has_index && _configuration.is_indexed) {
+				LogSegmentIndexBuilder index{ _configuration.index_block_records };
+				LogSegmentRecovery::recover(path, &index);
+				index.save(index_path.c_str());
+			}
+			// 압축기가 거절한 깨진 세그먼트는 시작할 때마다 다시 넘기지 않는다
+			if (_configuration.is_compressed && !(flags & LogSegmentFooter::FLAG_DAMAGED) && std::filesystem::file_size(path, error) > LogSegmentFooter::SIZE)
+				_compactor.push(path);
+			continue;
+		}
+
+		uint64_t begin = LogMetrics::now();
+		LogSegmentIndexBuilder index{ _configuration.index_block_records };
+		LogSegmentScan scan = LogSegmentRecovery::recover(path, _configuration.is_indexed ? &index : nullptr);
+		if (scan.record_count == 0) {
+			if (scan.written_size == 0) {
+				// 쓰이기 전에 멈춘 예비 세그먼트
+				std::remove(path.c_str());
+			}
+			else {
+				// 읽을 수 있는 레코드는 없지만 내용이 있으므로 지우지 않고 옮겨 둔다
+				std::string corrupt_path = path + LogSegmentRecovery::CORRUPT_EXTENSION;
+				if (std::rename(path.c_str(), corrupt_path.c_str()) == 0)
+					printf("[[SYSTEM]] %s has no intact record, it is moved to %s\n", path.c_str(), corrupt_path.c_str());
+				else
+					printf("[[SYSTEM]] %s has no intact record, it is left as it is\n", path.c_str());
+			}
+			continue;
+		}
+
+		// 깨진 레코드가 섞였거나 레코드 뒤에 바이트가 남은 세그먼트는 이어 쓰지 않고 닫는다
+		if (is_resumable && scan.isClean() && scan.records_size + LogRecord::MAX_SIZE + LogSegmentFooter::SIZE <= writer_configuration.segment_size) {
+			_current_segment = LogSegmentWriter::open(path.c_str(), writer_configuration, scan.records_size);
+			if (isOpened()) {
+				_current_path = path;
+				_current_offset = scan.records_size;
+				_current_lines = scan.record_count;
+				_next_commit_line = _current_lines + _configuration.interval_lines_of_commit;
+				_index = std::move(index);
+				is_resumable = false;
+				LogMetrics::add(LogMetrics::Counter::SEGMENTS_OPENED);
+				printf("[[SYSTEM]] Resumed %s after %zu records (%.1f ms)\n", path.c_str(), scan.record_count, (LogMetrics::now() - begin) / 1e6);
+				continue;
+			}
+			_current_segment.reset();
+		}
+		is_resumable = false;
+
+		LogSegmentRecovery::close(path, scan);
+		if (_configuration.is_indexed)
+			index.save(index_path.c_str());
+		// 깨진 레코드의 바이트를 남긴 세그먼트는 압축하지 않는다
+		if (_configuration.is_compressed && scan.isClean())
+			_compactor.push(path);
+		printf("[[SYSTEM]] Recovered %s with %zu records (%.1f ms)\n", path.c_str(), scan.record_count, (LogMetrics::now() - begin) / 1e6);
+		if (!scan.isClean())
+			printf("[[SYSTEM]] %s skipped %zu damaged bytes and kept %zu bytes behind its records\n", path.c_str(), scan.skipped_size, scan.written_size - scan.records_size);
+	}
+}
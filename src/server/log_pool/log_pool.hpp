@@ -0,0 +1,116 @@
+#ifndef __BN3MONKEY_LOG_POOL__
+#define __BN3MONKEY_LOG_POOL__
+
+#include <simple_log_protocol.hpp>
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+#include "log_record.hpp"
+#include "dirty_range_tracker.hpp"
+#include "log_segment_allocator.hpp"
+#include "log_segment_index.hpp"
+#include "log_segment_compactor.hpp"
+#include "log_segment_recovery.hpp"
+#include "log_segment_writer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    enum class Durability : uint8_t
+    {
+        // msync(MS_SYNC) every interval_lines_of_commit lines on the writing thread
+        SYNC,
+        // msync(MS_ASYNC) every interval_lines_of_commit lines. Write-back is left to the kernel.
+        ASYNC,
+        // a background thread flushes what was written every group_commit_interval
+        // or as soon as group_commit_bytes are pending, whichever comes first
+        GROUP_COMMIT,
+    };
+
+    struct LogPoolConfiguration
+    {
+        // where segments are created (empty : the working directory)
+        std::string directory;
+        size_t max_bytes_per_file{ 4 * 1024 * 1024 };
+        size_t interval_lines_of_commit{ 64 };
+        Durability durability{ Durability::SYNC };
+        std::chrono::milliseconds group_commit_interval{ 50 };
+        size_t group_commit_bytes{ 1024 * 1024 };
+        // fault the pages of the next segment in while it is pre-allocated
+        bool is_populated{ false };
+        // write <segment>.idx next to each segment when it is closed
+        bool is_indexed{ true };
+        size_t index_block_records{ 256 };
+        // replace each closed segment with its compressed file (<segment>z) on a background thread
+        bool is_compressed{ true };
+        // how records reach the storage (see LogSegmentWriter). DIRECT falls back to MEMORY_MAPPED outside Linux.
+        LogSegmentWriterType segment_writer{ LogSegmentWriterType::MEMORY_MAPPED };
+        // DIRECT only : buffers in flight to the I/O thread. One buffer is also the most a batch can write at once.
+        size_t direct_buffer_size{ 1024 * 1024 };
+        size_t direct_buffer_count{ 4 };
+        // scan the segments left in directory before the first one is opened (see LogSegmentRecovery).
+        // Segments the previous process did not close get their footer, and the newest one is appended to
+        // if it still has room.
+        bool is_recovered{ true };
+    };
+
+    class LogPool {
+    public:
+        LogPool(const LogPoolConfiguration& configuration = LogPoolConfiguration{});
+        ~LogPool();
+
+        inline operator bool() const { return _is_initialized; }
+        // Returns false if the line was dropped
+        bool write(const LogLine& line);
+        // Appends lines back to back with one capacity check and one commit check per batch.
+        // Returns how many of the first lines were written. The rest are dropped when no segment can be opened.
+        size_t writeBatch(const LogLine* lines, size_t count);
+
+    private:
+        bool _is_initialized{ false };
+        LogPoolConfiguration _configuration;
+
+        size_t _next_commit_line;
+
+        size_t _current_lines;
+        size_t _current_offset;
+        std::string _current_path;
+        std::unique_ptr<LogSegmentWriter> _current_segment;
+        // lines are being dropped for lack of a segment (reported once per failure)
+        bool _is_dropping{ false };
+        LogSegmentAllocator _allocator;
+        LogSegmentIndexBuilder _index;
+        LogSegmentCompactor _compactor;
+
+        // written but not committed ranges of _current_segment
+        DirtyRangeTracker _dirty{ MemoryMappedFile::getPageSize() };
+
+        // GROUP_COMMIT only.
+        // _file_mutex keeps the committer off a file that is being rotated,
+        // _dirty_mutex guards _dirty between the writer and the committer.
+        std::mutex _file_mutex;
+        std::mutex _dirty_mutex;
+        std::condition_variable _dirty_cv;
+        std::atomic<bool> _is_running{ true };
+        std::thread _group_committer;
+
+        inline bool isOpened() const { return _current_segment && *_current_segment; }
+        void recover();
+        void rotate();
+        void close();
+        size_t append(const LogLine* lines, size_t count, size_t current_offset);
+        void synchronize(size_t current_lines, size_t prev_offset, size_t current_offset);
+        MemoryMappedFile::Sync getCommitSync() const;
+        bool hasCapacity();
+
+        void runGroupCommit();
+        void commitDirtyRange(MemoryMappedFile::Sync sync);
+    };
+}
+
+#endif // __BN3MONKEY_LOG_POOL__
@@ -0,0 +1,272 @@
+#ifndef __BN3MONKEY_LOG_RECORD__
+#define __BN3MONKEY_LOG_RECORD__
+
+#include <simple_log_protocol.hpp>
+#include <simple_log_checksum.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace Bn3Monkey
+{
+    // On-disk layout of a single log in a LogPool segment
+    //
+    // | LogRecordHeader | signature | tag | content | '\n' |
+    //
+    // Only the real lengths of signature, tag and content are stored,
+    // so a record of a short log is a few dozen bytes instead of a full LogLine.
+    // The trailing newline keeps the text part of a segment readable in a pager.
+    // A segment closed by its LogPool ends with a LogSegmentFooter after the last record.
+    PACK_START
+    struct LogRecordHeader
+    {
+        static constexpr size_t SIZE = 32;
+        static constexpr char MAGIC[] {'S', 'R'};
+
+        static constexpr size_t MAGIC_SIZE = sizeof(MAGIC); // 2
+
+        char magic[MAGIC_SIZE] {0};
+        // whole record including header and trailing newline
+        uint16_t size {0};
+        uint16_t content_size {0};
+        uint8_t signature_size {0};
+        uint8_t tag_size {0};
+        LogColor color {0};
+        // CRC32C of the whole record except this field.
+        // 0 : not checked (records written before checksums, and the rare record whose checksum is 0)
+        uint32_t checksum {0};
+        // nanoseconds since the Unix epoch, as sent by the client
+        uint64_t timestamp {0};
+        uint64_t sequence {0};
+    };
+    PACK_END
+
+    static_assert(sizeof(LogRecordHeader) == LogRecordHeader::SIZE, "Log Record Header should be 32");
+
+    // Marks a segment as closed : written at the end of the file, normally right after the last record.
+    // A recovered segment keeps the bytes of its damaged records, so there can be some between the records and it.
+    // Readers stop at it like at the end of the records. Its magic never starts a record.
+    PACK_START
+    struct LogSegmentFooter
+    {
+        static constexpr size_t SIZE = 32;
+        static constexpr char MAGIC[] {'S', 'F'};
+        static constexpr uint8_t VERSION = 1;
+        // the segment holds damaged records, so the compactor leaves it as it is
+        static constexpr uint8_t FLAG_DAMAGED = 1 << 0;
+
+        char magic[LogRecordHeader::MAGIC_SIZE] {0};
+        uint8_t version {0};
+        uint8_t reserved {0};
+        // CRC32C of the bytes after this field
+        uint32_t checksum {0};
+        uint64_t record_count {0};
+        // end of the last intact record : where the footer starts, unless damaged bytes were kept before it
+        uint64_t records_size {0};
+        uint8_t flags {0};
+        char reserved_2[7] {0};
+
+        static inline void encode(char* dest, uint64_t record_count, uint64_t records_size, uint8_t flags = 0) {
+            LogSegmentFooter footer;
+            memcpy(footer.magic, MAGIC, sizeof(footer.magic));
+            footer.version = VERSION;
+            footer.record_count = record_count;
+            footer.records_size = records_size;
+            footer.flags = flags;
+            footer.checksum = footer.computeChecksum();
+            memcpy(dest, &footer, sizeof(footer));
+        }
+
+        // Whether a valid footer is stored at data, offset bytes into its segment
+        static inline bool isValid(const char* data, uint64_t offset) {
+            LogSegmentFooter footer;
+            memcpy(&footer, data, sizeof(footer));
+            return memcmp(footer.magic, MAGIC, sizeof(footer.magic)) == 0
+                && footer.records_size <= offset
+                && footer.checksum == footer.computeChecksum();
+        }
+        // records_size of a valid footer stored at data
+        static inline uint64_t getRecordsSize(const char* data) {
+            uint64_t ret;
+            memcpy(&ret, data + offsetof(LogSegmentFooter, records_size), sizeof(ret));
+            return ret;
+        }
+        // flags of a valid footer stored at data
+        static inline uint8_t getFlags(const char* data) {
+            return static_cast<uint8_t>(data[offsetof(LogSegmentFooter, flags)]);
+        }
+
+        inline uint32_t computeChecksum() const {
+            return LogChecksum::compute(&record_count, SIZE - offsetof(LogSegmentFooter, record_count));
+        }
+    };
+    PACK_END
+
+    static_assert(sizeof(LogSegmentFooter) == LogSegmentFooter::SIZE, "Log Segment Footer should be 32");
+
+    class LogRecord
+    {
+    public:
+        static constexpr size_t MAX_SIZE = sizeof(LogRecordHeader) + LogHeader::SIGNATURE_SIZE + LogHeader::TAG_SIZE + LogLine::CONTENT_SIZE + 1;
+        static_assert(MAX_SIZE <= UINT16_MAX, "Log Record should fit in uint16_t");
+
+        // Size of the record that encode() will produce for the line
+        static inline size_t getEncodedSize(const LogLine& line) {
+            return sizeof(LogRecordHeader)
+                + strnlen(line.header.signature, LogHeader::SIGNATURE_SIZE)
+                + strnlen(line.header.tag, LogHeader::TAG_SIZE)
+                + strnlen(line.content, LogLine::CONTENT_SIZE)
+                + 1;
+        }
+
+        // Writes the record of the line to dest, which must have MAX_SIZE bytes available.
+        // Returns the number of bytes written.
+        static inline size_t encode(char* dest, const LogLine& line) {
+            LogRecordHeader header;
+            memcpy(header.magic, LogRecordHeader::MAGIC, sizeof(header.magic));
+            header.signature_size = static_cast<uint8_t>(strnlen(line.header.signature, LogHeader::SIGNATURE_SIZE));
+            header.tag_size = static_cast<uint8_t>(strnlen(line.header.tag, LogHeader::TAG_SIZE));
+            header.color = line.header.color;
+            header.timestamp = line.header.timestamp;
+            header.sequence = line.header.sequence;
+
+            char* body = dest + sizeof(LogRecordHeader);
+            memcpy(body, line.header.signature, header.signature_size);
+            body += header.signature_size;
+            memcpy(body, line.header.tag, header.tag_size);
+            body += header.tag_size;
+            header.content_size = static_cast<uint16_t>(copyContent(body, line.content, LogLine::CONTENT_SIZE));
+            body += header.content_size;
+            *body++ = '\n';
+
+            header.size = static_cast<uint16_t>(body - dest);
+            memcpy(dest, &header, sizeof(header));
+            header.checksum = computeChecksum(dest);
+            memcpy(dest + offsetof(LogRecordHeader, checksum), &header.checksum, sizeof(header.checksum));
+            return header.size;
+        }
+
+        // CRC32C of the record stored at data (whose size field is set), skipping its checksum field
+        static inline uint32_t computeChecksum(const char* data) {
+            constexpr size_t CHECKSUM_OFFSET = offsetof(LogRecordHeader, checksum);
+            constexpr size_t CHECKSUM_END = CHECKSUM_OFFSET + sizeof(uint32_t);
+            uint16_t size;
+            memcpy(&size, data + offsetof(LogRecordHeader, size), sizeof(size));
+            uint32_t ret = LogChecksum::compute(data, CHECKSUM_OFFSET);
+            return LogChecksum::compute(data + CHECKSUM_END, size - CHECKSUM_END, ret);
+        }
+
+        LogRecord() = default;
+        // View over a record stored at data. Nothing is copied.
+        explicit LogRecord(const char* data) : _data(data) {}
+
+        // Checks whether a complete record starts at _data within the remaining bytes
+        inline bool isValid(size_t remaining) const {
+            if (remaining < sizeof(LogRecordHeader))
+                return false;
+            if (memcmp(_data, LogRecordHeader::MAGIC, LogRecordHeader::MAGIC_SIZE) != 0)
+                return false;
+            auto& h = header();
+            if (h.size > remaining)
+                return false;
+            return h.size == sizeof(LogRecordHeader) + h.signature_size + h.tag_size + h.content_size + 1;
+        }
+        // Whether the bytes of a valid record are the ones that were encoded (see LogRecordHeader::checksum)
+        inline bool isIntact() const {
+            uint32_t checksum = header().checksum;
+            return checksum == 0 || checksum == computeChecksum(_data);
+        }
+
+        // Offset of the first record at or after offset that is valid and matches its checksum, or size if there is none.
+        // Gets past a damaged record : records without a checksum are not taken, as they cannot be told from stray bytes.
+        static inline size_t findIntact(const char* data, size_t offset, size_t size) {
+            while (offset + sizeof(LogRecordHeader) <= size) {
+                auto* found = static_cast<const char*>(memchr(data + offset, LogRecordHeader::MAGIC[0], size - sizeof(LogRecordHeader) + 1 - offset));
+                if (!found)
+                    break;
+                offset = static_cast<size_t>(found - data);
+                LogRecord record{ found };
+                if (record.isValid(size - offset) && record.header().checksum != 0 && record.isIntact())
+                    return offset;
+                offset++;
+            }
+            return size;
+        }
+
+        inline const LogRecordHeader& header() const { return *reinterpret_cast<const LogRecordHeader*>(_data); }
+        inline size_t size() const { return header().size; }
+        inline const char* data() const { return _data; }
+
+        inline const char* signature() const { return _data + sizeof(LogRecordHeader); }
+        inline size_t signatureSize() const { return header().signature_size; }
+        inline const char* tag() const { return signature() + signatureSize(); }
+        inline size_t tagSize() const { return header().tag_size; }
+        inline const char* content() const { return tag() + tagSize(); }
+        inline size_t contentSize() const { return header().content_size; }
+
+        // Human-readable rendering of the record, in the same shape as the console output.
+        // Returns the number of characters that would have been written (like snprintf).
+        inline size_t render(char* buffer, size_t size) const {
+            char date[LogTimestamp::TEXT_SIZE + 1];
+            LogTimestamp::format(header().timestamp, date);
+            int ret = snprintf(buffer, size, "%s %.*s %.*s | %.*s\n",
+                date,
+                static_cast<int>(signatureSize()), signature(),
+                static_cast<int>(tagSize()), tag(),
+                static_cast<int>(contentSize()), content());
+            return ret < 0 ? 0 : static_cast<size_t>(ret);
+        }
+
+    private:
+        // Copies src up to its first NUL (at most size bytes) in one pass and returns the copied length.
+        // Line breaks become spaces so that one record stays one line in the segment.
+        // Whole 16-byte blocks are stored, so dest may be written up to size bytes even for a short content.
+        // What follows the NUL in the last block is stored as zeros, never as bytes of the sender.
+        static inline size_t copyContent(char* dest, const char* src, size_t size) {
+            size_t i = 0;
+#if defined(__x86_64__) || defined(_M_X64)
+            // 16 - n 위치에서 읽으면 앞의 n 바이트만 남기는 마스크가 된다
+            alignas(16) static const char KEEP[32] = {
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            };
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i newline = _mm_set1_epi8('\n');
+            const __m128i space = _mm_set1_epi8(' ');
+            for (; i + 16 <= size; i += 16) {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                uint32_t nul = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)));
+                __m128i is_newline = _mm_cmpeq_epi8(block, newline);
+                block = _mm_or_si128(_mm_andnot_si128(is_newline, block), _mm_and_si128(is_newline, space));
+                if (nul) {
+#if defined(_MSC_VER)
+                    unsigned long index;
+                    _BitScanForward(&index, nul);
+#else
+                    size_t index = static_cast<size_t>(__builtin_ctz(nul));
+#endif
+                    block = _mm_and_si128(block, _mm_loadu_si128(reinterpret_cast<const __m128i*>(KEEP + 16 - index)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), block);
+                    return i + index;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), block);
+            }
+#endif
+            for (; i < size && src[i] != '\0'; i++)
+                dest[i] = src[i] == '\n' ? ' ' : src[i];
+            return i;
+        }
+
+        const char* _data{ nullptr };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_RECORD__
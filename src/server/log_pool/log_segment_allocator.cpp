@@ -0,0 +1,128 @@
+#include "log_segment_allocator.hpp"
+#include "log_segment_compactor.hpp"
+
+#include <cstdio>
+
+using namespace Bn3Monkey;
+
+Bn3Monkey::LogSegmentAllocator::LogSegmentAllocator(const LogSegmentWriterConfiguration& configuration, const std::string& directory) :
+	_configuration(configuration),
+	_directory(directory)
+{
+	if (!_directory.empty() && _directory.back() != '/')
+		_directory += '/';
+}
+
+void Bn3Monkey::LogSegmentAllocator::start()
+{
+	if (!_thread.joinable())
+		_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::LogSegmentAllocator::~LogSegmentAllocator()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_running = false;
+		_cv.notify_all();
+	}
+	if (_thread.joinable())
+		_thread.join();
+
+	// 쓰이지 않은 예비 파일은 남기지 않는다
+	if (_is_ready && _next_segment) {
+		_next_segment->release(0);
+		std::remove(_next_path.c_str());
+	}
+}
+
+std::unique_ptr<LogSegmentWriter> Bn3Monkey::LogSegmentAllocator::acquire(std::string& path)
+{
+	start();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_cv.wait(lock, [&]() { return _is_ready || !_is_running; });
+	if (!_is_ready)
+		return nullptr;
+
+	std::unique_ptr<LogSegmentWriter> ret = std::move(_next_segment);
+	path = std::move(_next_path);
+	_is_ready = false;
+	_cv.notify_all();
+	return ret;
+}
+
+void Bn3Monkey::LogSegmentAllocator::run()
+{
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&]() { return !_is_ready || !_is_running; });
+			if (!_is_running)
+				break;
+		}
+
+		std::string path;
+		std::unique_ptr<LogSegmentWriter> segment = create(path);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_next_segment = std::move(segment);
+			_next_path = std::move(path);
+			_is_ready = true;
+			_cv.notify_all();
+		}
+	}
+}
+
+std::unique_ptr<LogSegmentWriter> Bn3Monkey::LogSegmentAllocator::create(std::string& path)
+{
+	char buffer[64]{ 0 };
+	std::string segment_path;
+
+	std::time_t now = std::time(nullptr);
+	if (now != _last_second) {
+		_last_second = now;
+		_sequence = 0;
+	}
+
+	std::tm tm{};
+#ifdef _WIN32
+	localtime_s(&tm, &now);
+#else
+	localtime_r(&now, &tm);
+#endif
+
+	// 같은 이름의 파일이 이미 있으면 (같은 초에 재시작한 경우 등) 다음 번호를 쓴다
+	for (uint32_t attempt = 0; attempt < 10000; attempt++) {
+		// 파일명: log_YYYYMMDD_HHMMSS_NNNN.slog
+		std::snprintf(
+			buffer,
+			sizeof(buffer),
+			"log_%04d%02d%02d_%02d%02d%02d_%04u.slog",
+			tm.tm_year + 1900,
+			tm.tm_mon + 1,
+			tm.tm_mday,
+			tm.tm_hour,
+			tm.tm_min,
+			tm.tm_sec,
+			_sequence++
+		);
+
+		segment_path = _directory + buffer;
+
+		// 압축된 세그먼트는 원본이 지워져 있으므로 따로 확인한다
+		std::string compressed_path = LogSegmentCompactor::getCompressedPath(segment_path);
+		if (FILE* compressed = std::fopen(compressed_path.c_str(), "rb")) {
+			std::fclose(compressed);
+			continue;
+		}
+
+		auto segment = LogSegmentWriter::create(segment_path.c_str(), _configuration);
+		if (segment->error() != MemoryMappedFile::Code::FILE_ALREADY_EXISTS) {
+			path = std::move(segment_path);
+			return segment;
+		}
+	}
+	return nullptr;
+}
@@ -0,0 +1,58 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_ALLOCATOR__
+#define __BN3MONKEY_LOG_SEGMENT_ALLOCATOR__
+
+#include "log_segment_writer.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    // Keeps the next LogPool segment created, allocated and mapped on a background thread,
+    // so that rotation only swaps in a ready file.
+    //
+    // Segments are named log_YYYYMMDD_HHMMSS_NNNN.slog. NNNN counts segments within the same second,
+    // so names are unique and sort in creation order.
+    // They are created in directory, or in the working directory if it is empty.
+    // Nothing is created before start() or the first acquire(), so the owner can look at the directory first.
+    class LogSegmentAllocator
+    {
+    public:
+        LogSegmentAllocator(const LogSegmentWriterConfiguration& configuration, const std::string& directory = "");
+        ~LogSegmentAllocator();
+
+        LogSegmentAllocator(const LogSegmentAllocator&) = delete;
+        LogSegmentAllocator& operator=(const LogSegmentAllocator&) = delete;
+
+        // Starts preparing the first segment
+        void start();
+        // Takes the prepared segment and starts preparing the next one.
+        // Only waits if the previous one is not ready yet.
+        std::unique_ptr<LogSegmentWriter> acquire(std::string& path);
+
+    private:
+        void run();
+        std::unique_ptr<LogSegmentWriter> create(std::string& path);
+
+        LogSegmentWriterConfiguration _configuration;
+        std::string _directory;
+
+        std::time_t _last_second{ 0 };
+        uint32_t _sequence{ 0 };
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _is_ready{ false };
+        bool _is_running{ true };
+        std::unique_ptr<LogSegmentWriter> _next_segment;
+        std::string _next_path;
+        std::thread _thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_ALLOCATOR__
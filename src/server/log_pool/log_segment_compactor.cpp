@@ -0,0 +1,201 @@
+#include "log_segment_compactor.hpp"
+#include "log_block_codec.hpp"
+#include "log_record.hpp"
+#include "log_segment_recovery.hpp"
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+namespace
+{
+	// rename이 디스크에 남으려면 디렉터리도 sync해야 한다
+	bool syncDirectory(const std::string& path)
+	{
+#ifdef _WIN32
+		(void)path;
+		return true;
+#else
+		std::string directory = std::filesystem::path(path).parent_path().string();
+		int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd < 0)
+			return false;
+		bool ret = fsync(fd) == 0;
+		::close(fd);
+		return ret;
+#endif
+	}
+
+	// Whether nothing but a footer or zero bytes follows the records
+	bool isCleanEnd(const char* data, size_t size, size_t records_size)
+	{
+		if (size - records_size >= LogSegmentFooter::SIZE && LogSegmentFooter::isValid(data + records_size, records_size))
+			records_size += LogSegmentFooter::SIZE;
+		for (size_t i = records_size; i < size; i++) {
+			if (data[i] != 0)
+				return false;
+		}
+		return true;
+	}
+}
+
+Bn3Monkey::LogSegmentCompactor::LogSegmentCompactor()
+{
+	_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::LogSegmentCompactor::~LogSegmentCompactor()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_running = false;
+		_cv.notify_all();
+	}
+	if (_thread.joinable())
+		_thread.join();
+}
+
+void Bn3Monkey::LogSegmentCompactor::push(const std::string& segment_path)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_paths.push_back(segment_path);
+	_cv.notify_all();
+}
+
+void Bn3Monkey::LogSegmentCompactor::run()
+{
+	while (true) {
+		std::string path;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv.wait(lock, [&]() { return !_paths.empty() || !_is_running; });
+			// 종료할 때도 남은 세그먼트는 모두 압축한다
+			if (_paths.empty())
+				break;
+			path = std::move(_paths.front());
+			_paths.pop_front();
+		}
+		compact(path);
+	}
+}
+
+bool Bn3Monkey::LogSegmentCompactor::compact(const std::string& segment_path)
+{
+	std::vector<LogCompressedBlock> blocks;
+	std::string compressed_path = getCompressedPath(segment_path);
+	std::string temporary_path = compressed_path + ".tmp";
+
+	{
+		MemoryMappedFile segment{ segment_path.c_str(), MemoryMappedFile::Access::READONLY, 0, MemoryMappedFile::HINT_SEQUENTIAL };
+		if (!segment)
+			return false;
+
+		// 레코드 경계에서 블록을 자른다
+		size_t raw_size = 0;
+		size_t block_begin = 0;
+		while (raw_size < segment.size()) {
+			LogRecord record{ segment.data() + raw_size };
+			if (!record.isValid(segment.size() - raw_size) || !record.isIntact())
+				break;
+			if (raw_size > block_begin && raw_size + record.size() - block_begin > BLOCK_SIZE) {
+				LogCompressedBlock block;
+				block.raw_offset = block_begin;
+				block.raw_size = static_cast<uint32_t>(raw_size - block_begin);
+				blocks.push_back(block);
+				block_begin = raw_size;
+			}
+			raw_size += record.size();
+		}
+		if (raw_size > block_begin) {
+			LogCompressedBlock block;
+			block.raw_offset = block_begin;
+			block.raw_size = static_cast<uint32_t>(raw_size - block_begin);
+			blocks.push_back(block);
+		}
+
+		// 중간에 깨진 레코드가 있으면 뒤의 레코드를 잃지 않도록 원본을 그대로 둔다
+		if (!isCleanEnd(segment.data(), segment.size(), raw_size)) {
+			printf("[[SYSTEM]] %s has a damaged record at %zu, it is left uncompressed\n", segment_path.c_str(), raw_size);
+			// 다음 시작 때 다시 넘겨받지 않도록 푸터에 표시한다
+			LogSegmentRecovery::markDamaged(segment_path);
+			return false;
+		}
+
+		LogCompressedSegmentHeader header;
+		memcpy(header.magic, LogCompressedSegmentHeader::MAGIC, sizeof(header.magic));
+		header.version = LogCompressedSegmentHeader::VERSION;
+		header.codec = LogCompressedSegmentHeader::CODEC_LZ4_BLOCK;
+		header.block_count = static_cast<uint32_t>(blocks.size());
+		header.raw_size = raw_size;
+
+		FILE* file = fopen(temporary_path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool ret = fwrite(&header, sizeof(header), 1, file) == 1;
+		// 블록 표는 크기를 알고 난 뒤에 다시 쓴다
+		if (ret && !blocks.empty())
+			ret = fwrite(blocks.data(), sizeof(LogCompressedBlock), blocks.size(), file) == blocks.size();
+
+		uint64_t offset = sizeof(header) + sizeof(LogCompressedBlock) * blocks.size();
+		std::vector<char> buffer(LogBlockCodec::getCompressBound(BLOCK_SIZE + LogRecord::MAX_SIZE));
+		for (auto& block : blocks) {
+			if (!ret)
+				break;
+			const char* raw = segment.data() + block.raw_offset;
+			size_t size = LogBlockCodec::compress(raw, block.raw_size, buffer.data(), buffer.size());
+			const char* data = buffer.data();
+			if (size == 0 || size >= block.raw_size) {
+				size = block.raw_size;
+				data = raw;
+			}
+			block.offset = offset;
+			block.size = static_cast<uint32_t>(size);
+			offset += size;
+			ret = fwrite(data, 1, size, file) == size;
+		}
+
+		if (ret && !blocks.empty()) {
+			ret = fseek(file, sizeof(header), SEEK_SET) == 0
+				&& fwrite(blocks.data(), sizeof(LogCompressedBlock), blocks.size(), file) == blocks.size();
+		}
+		// 원본을 지우기 전에 압축한 파일이 디스크에 있어야 한다
+		if (ret)
+			ret = fflush(file) == 0;
+		if (ret) {
+#ifdef _WIN32
+			ret = _commit(_fileno(file)) == 0;
+#else
+			ret = fsync(fileno(file)) == 0;
+#endif
+		}
+		fclose(file);
+
+		if (!ret) {
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	if (std::rename(temporary_path.c_str(), compressed_path.c_str()) != 0) {
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+	// 압축한 파일의 이름이 디스크에 남기 전에는 원본을 지우지 않는다
+	if (!syncDirectory(compressed_path))
+		return false;
+	// 읽고 있는 곳이 있어서 지우지 못하면 (Windows) 원본이 남고, 조회는 원본을 쓴다
+	std::remove(segment_path.c_str());
+	return true;
+}
@@ -0,0 +1,87 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_COMPACTOR__
+#define __BN3MONKEY_LOG_SEGMENT_COMPACTOR__
+
+#include <simple_log_protocol.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    // Compressed segment (<segment>z, e.g. log_YYYYMMDD_HHMMSS_NNNN.slogz)
+    //
+    // | LogCompressedSegmentHeader | LogCompressedBlock[block_count] | block data ... |
+    //
+    // The segment is cut at record boundaries into blocks of about BLOCK_SIZE bytes, each compressed on its own.
+    // raw_offset is the offset in the original segment, so the sidecar index keeps working
+    // and a reader only decompresses the blocks it needs.
+    PACK_START
+    struct LogCompressedSegmentHeader
+    {
+        static constexpr char MAGIC[] {'S', 'L', 'Z', 'B'};
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t CODEC_LZ4_BLOCK = 1;
+
+        char magic[4] {0};
+        uint32_t version {0};
+        uint32_t codec {0};
+        uint32_t block_count {0};
+        uint64_t raw_size {0};
+    };
+
+    struct LogCompressedBlock
+    {
+        uint64_t raw_offset {0};
+        // from the start of the file
+        uint64_t offset {0};
+        uint32_t raw_size {0};
+        // size == raw_size : stored as it is
+        uint32_t size {0};
+    };
+    PACK_END
+
+    // Compresses closed segments on a background thread and replaces them with the compressed file
+    class LogSegmentCompactor
+    {
+    public:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+        static constexpr const char* EXTENSION = ".slogz";
+
+        static inline std::string getCompressedPath(const std::string& segment_path) { return segment_path + "z"; }
+        static inline bool isCompressedPath(const std::string& path) {
+            size_t size = strlen(EXTENSION);
+            return path.size() >= size && path.compare(path.size() - size, size, EXTENSION) == 0;
+        }
+        // Path of the original segment of a compressed one
+        static inline std::string getSegmentPath(const std::string& compressed_path) { return compressed_path.substr(0, compressed_path.size() - 1); }
+
+        LogSegmentCompactor();
+        // Compresses what is still queued before returning
+        ~LogSegmentCompactor();
+
+        LogSegmentCompactor(const LogSegmentCompactor&) = delete;
+        LogSegmentCompactor& operator=(const LogSegmentCompactor&) = delete;
+
+        void push(const std::string& segment_path);
+
+        // Writes the compressed file of the segment and removes the segment.
+        // A segment with a damaged record before its end is left as it is, so no record after the damage is lost.
+        static bool compact(const std::string& segment_path);
+
+    private:
+        void run();
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::deque<std::string> _paths;
+        bool _is_running{ true };
+        std::thread _thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_COMPACTOR__
@@ -0,0 +1,221 @@
+#include "log_segment_index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+void Bn3Monkey::LogSegmentIndexBuilder::add(size_t offset, const LogRecord& record)
+{
+	// 깨진 레코드를 건너뛴 자리에서는 블록을 새로 시작해 블록 안에 레코드가 이어지게 한다
+	if (_blocks.empty() || _blocks.back().record_count >= _block_records || offset != _segment_size) {
+		LogSegmentIndexBlock block;
+		block.offset = offset;
+		block.min_timestamp = UINT64_MAX;
+		_blocks.push_back(block);
+	}
+
+	auto& block = _blocks.back();
+	uint32_t block_id = static_cast<uint32_t>(_blocks.size() - 1);
+	uint64_t timestamp = record.header().timestamp;
+
+	block.record_count += 1;
+	block.size = static_cast<uint32_t>(offset + record.size() - block.offset);
+	block.min_timestamp = std::min(block.min_timestamp, timestamp);
+	block.max_timestamp = std::max(block.max_timestamp, timestamp);
+
+	addPosting(_tags, hash(record.tag(), record.tagSize()), block_id);
+	addPosting(_signatures, hash(record.signature(), record.signatureSize()), block_id);
+
+	_min_timestamp = std::min(_min_timestamp, timestamp);
+	_max_timestamp = std::max(_max_timestamp, timestamp);
+	_record_count += 1;
+	_segment_size = offset + record.size();
+}
+
+void Bn3Monkey::LogSegmentIndexBuilder::addPosting(std::unordered_map<uint64_t, PostingList>& lists, uint64_t hash, uint32_t block)
+{
+	auto& list = lists[hash];
+	if (list.last_block != block) {
+		list.last_block = block;
+		list.blocks.push_back(block);
+	}
+}
+
+bool Bn3Monkey::LogSegmentIndexBuilder::save(const char* path) const
+{
+	LogSegmentIndexHeader header;
+	memcpy(header.magic, LogSegmentIndexHeader::MAGIC, sizeof(header.magic));
+	header.version = LogSegmentIndexHeader::VERSION;
+	header.min_timestamp = _record_count ? _min_timestamp : 0;
+	header.max_timestamp = _max_timestamp;
+	header.record_count = _record_count;
+	header.segment_size = _segment_size;
+	header.block_count = static_cast<uint32_t>(_blocks.size());
+	header.tag_count = static_cast<uint32_t>(_tags.size());
+	header.signature_count = static_cast<uint32_t>(_signatures.size());
+
+	std::vector<LogSegmentIndexKey> keys;
+	std::vector<uint32_t> postings;
+	auto appendKeys = [&](const std::unordered_map<uint64_t, PostingList>& lists) {
+		size_t begin = keys.size();
+		for (auto& item : lists) {
+			LogSegmentIndexKey key;
+			key.hash = item.first;
+			key.posting_offset = static_cast<uint32_t>(postings.size());
+			key.posting_count = static_cast<uint32_t>(item.second.blocks.size());
+			postings.insert(postings.end(), item.second.blocks.begin(), item.second.blocks.end());
+			keys.push_back(key);
+		}
+		std::sort(keys.begin() + begin, keys.end(), [](const LogSegmentIndexKey& a, const LogSegmentIndexKey& b) { return a.hash < b.hash; });
+	};
+	appendKeys(_tags);
+	appendKeys(_signatures);
+	header.posting_count = static_cast<uint32_t>(postings.size());
+
+	// 다 쓰고 디스크에 내린 뒤에 이름을 바꿔서, 중간에 멈춰도 잘린 인덱스가 남지 않게 한다
+	std::string temporary_path = std::string(path) + ".tmp";
+	FILE* file = fopen(temporary_path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool ret = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (ret && !_blocks.empty())
+		ret = fwrite(_blocks.data(), sizeof(LogSegmentIndexBlock), _blocks.size(), file) == _blocks.size();
+	if (ret && !keys.empty())
+		ret = fwrite(keys.data(), sizeof(LogSegmentIndexKey), keys.size(), file) == keys.size();
+	if (ret && !postings.empty())
+		ret = fwrite(postings.data(), sizeof(uint32_t), postings.size(), file) == postings.size();
+	if (ret)
+		ret = fflush(file) == 0;
+	if (ret) {
+#ifdef _WIN32
+		ret = _commit(_fileno(file)) == 0;
+#else
+		ret = fsync(fileno(file)) == 0;
+#endif
+	}
+	fclose(file);
+
+	if (ret)
+		ret = std::rename(temporary_path.c_str(), path) == 0;
+	if (!ret)
+		std::remove(temporary_path.c_str());
+	return ret;
+}
+
+void Bn3Monkey::LogSegmentIndexBuilder::clear()
+{
+	_blocks.clear();
+	_tags.clear();
+	_signatures.clear();
+	_min_timestamp = UINT64_MAX;
+	_max_timestamp = 0;
+	_record_count = 0;
+	_segment_size = 0;
+}
+
+Bn3Monkey::LogSegmentIndex::LogSegmentIndex(const char* path) :
+	_file(path, MemoryMappedFile::Access::READONLY, 0)
+{
+	if (!_file || _file.size() < sizeof(LogSegmentIndexHeader))
+		return;
+
+	auto* header = reinterpret_cast<const LogSegmentIndexHeader*>(_file.data());
+	if (memcmp(header->magic, LogSegmentIndexHeader::MAGIC, sizeof(header->magic)) != 0 || header->version != LogSegmentIndexHeader::VERSION)
+		return;
+
+	size_t expected = sizeof(LogSegmentIndexHeader)
+		+ sizeof(LogSegmentIndexBlock) * header->block_count
+		+ sizeof(LogSegmentIndexKey) * (static_cast<size_t>(header->tag_count) + header->signature_count)
+		+ sizeof(uint32_t) * header->posting_count;
+	if (_file.size() < expected)
+		return;
+
+	const char* data = _file.data() + sizeof(LogSegmentIndexHeader);
+	_blocks = reinterpret_cast<const LogSegmentIndexBlock*>(data);
+	data += sizeof(LogSegmentIndexBlock) * header->block_count;
+	_tags = reinterpret_cast<const LogSegmentIndexKey*>(data);
+	data += sizeof(LogSegmentIndexKey) * header->tag_count;
+	_signatures = reinterpret_cast<const LogSegmentIndexKey*>(data);
+	data += sizeof(LogSegmentIndexKey) * header->signature_count;
+	_postings = reinterpret_cast<const uint32_t*>(data);
+
+	_prefix_max.resize(header->block_count);
+	_suffix_min.resize(header->block_count);
+	uint64_t running = 0;
+	for (uint32_t i = 0; i < header->block_count; i++) {
+		running = std::max(running, _blocks[i].max_timestamp);
+		_prefix_max[i] = running;
+	}
+	running = UINT64_MAX;
+	for (uint32_t i = header->block_count; i > 0; i--) {
+		running = std::min(running, _blocks[i - 1].min_timestamp);
+		_suffix_min[i - 1] = running;
+	}
+
+	_header = header;
+}
+
+void Bn3Monkey::LogSegmentIndex::find(uint64_t from, uint64_t to, const char* tag, const char* signature, std::vector<Range>& ranges) const
+{
+	ranges.clear();
+	if (!_header || _header->record_count == 0 || from > _header->max_timestamp || to < _header->min_timestamp)
+		return;
+
+	const LogSegmentIndexKey* tag_key = nullptr;
+	if (tag) {
+		tag_key = findKey(_tags, _header->tag_count, tag);
+		if (!tag_key)
+			return;
+	}
+	const LogSegmentIndexKey* signature_key = nullptr;
+	if (signature) {
+		signature_key = findKey(_signatures, _header->signature_count, signature);
+		if (!signature_key)
+			return;
+	}
+
+	// 첫 블록 : max가 from 이상이 되는 첫 위치, 마지막 블록 : min이 to 이하인 마지막 위치
+	size_t begin = std::lower_bound(_prefix_max.begin(), _prefix_max.end(), from) - _prefix_max.begin();
+	size_t end = std::upper_bound(_suffix_min.begin(), _suffix_min.end(), to) - _suffix_min.begin();
+
+	for (size_t i = begin; i < end; i++) {
+		auto& block = _blocks[i];
+		if (block.max_timestamp < from || block.min_timestamp > to)
+			continue;
+		if (tag_key && !contains(tag_key, static_cast<uint32_t>(i)))
+			continue;
+		if (signature_key && !contains(signature_key, static_cast<uint32_t>(i)))
+			continue;
+
+		if (!ranges.empty() && ranges.back().offset + ranges.back().size == block.offset)
+			ranges.back().size += block.size;
+		else
+			ranges.push_back(Range{ static_cast<size_t>(block.offset), block.size });
+	}
+}
+
+const LogSegmentIndexKey* Bn3Monkey::LogSegmentIndex::findKey(const LogSegmentIndexKey* keys, uint32_t count, const char* text) const
+{
+	uint64_t hash = LogSegmentIndexBuilder::hash(text, strlen(text));
+	auto* end = keys + count;
+	auto* it = std::lower_bound(keys, end, hash, [](const LogSegmentIndexKey& key, uint64_t value) { return key.hash < value; });
+	if (it == end || it->hash != hash)
+		return nullptr;
+	return it;
+}
+
+bool Bn3Monkey::LogSegmentIndex::contains(const LogSegmentIndexKey* key, uint32_t block) const
+{
+	auto* begin = _postings + key->posting_offset;
+	auto* end = begin + key->posting_count;
+	return std::binary_search(begin, end, block);
+}
@@ -0,0 +1,144 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_INDEX__
+#define __BN3MONKEY_LOG_SEGMENT_INDEX__
+
+#include <simple_log_protocol.hpp>
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+#include "log_record.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Sidecar index of a LogPool segment (<segment>.idx)
+    //
+    // | LogSegmentIndexHeader | LogSegmentIndexBlock[block_count] |
+    // | LogSegmentIndexKey[tag_count] | LogSegmentIndexKey[signature_count] | uint32_t postings[posting_count] |
+    //
+    // The segment is cut into blocks of a fixed number of records. Each block keeps its byte range and time range,
+    // and each tag / signature keeps the sorted list of blocks it appears in (keys are sorted by hash).
+    PACK_START
+    struct LogSegmentIndexHeader
+    {
+        static constexpr char MAGIC[] {'S', 'I', 'D', 'X'};
+        static constexpr uint32_t VERSION = 1;
+
+        char magic[4] {0};
+        uint32_t version {0};
+        uint64_t min_timestamp {0};
+        uint64_t max_timestamp {0};
+        uint64_t record_count {0};
+        // bytes of the segment covered by the index
+        uint64_t segment_size {0};
+        uint32_t block_count {0};
+        uint32_t tag_count {0};
+        uint32_t signature_count {0};
+        uint32_t posting_count {0};
+    };
+
+    struct LogSegmentIndexBlock
+    {
+        uint64_t offset {0};
+        uint64_t min_timestamp {0};
+        uint64_t max_timestamp {0};
+        uint32_t record_count {0};
+        uint32_t size {0};
+    };
+
+    struct LogSegmentIndexKey
+    {
+        uint64_t hash {0};
+        uint32_t posting_offset {0};
+        uint32_t posting_count {0};
+    };
+    PACK_END
+
+    // Builds the index of the segment being written, record by record
+    class LogSegmentIndexBuilder
+    {
+    public:
+        static constexpr const char* EXTENSION = ".idx";
+        static inline std::string getPath(const std::string& segment_path) { return segment_path + EXTENSION; }
+
+        explicit LogSegmentIndexBuilder(size_t block_records = 256) : _block_records(block_records ? block_records : 1) {}
+
+        void add(size_t offset, const LogRecord& record);
+        // Writes <path>.tmp, syncs it and renames it to path, so path is either the whole index or absent
+        bool save(const char* path) const;
+        void clear();
+
+        inline uint64_t recordCount() const { return _record_count; }
+
+        // FNV-1a, used for tag and signature keys
+        static inline uint64_t hash(const char* data, size_t size) {
+            uint64_t ret = 14695981039346656037ull;
+            for (size_t i = 0; i < size; i++) {
+                ret ^= static_cast<uint8_t>(data[i]);
+                ret *= 1099511628211ull;
+            }
+            return ret;
+        }
+
+    private:
+        struct PostingList {
+            uint32_t last_block{ UINT32_MAX };
+            std::vector<uint32_t> blocks;
+        };
+        static void addPosting(std::unordered_map<uint64_t, PostingList>& lists, uint64_t hash, uint32_t block);
+
+        size_t _block_records;
+        std::vector<LogSegmentIndexBlock> _blocks;
+        std::unordered_map<uint64_t, PostingList> _tags;
+        std::unordered_map<uint64_t, PostingList> _signatures;
+
+        uint64_t _min_timestamp{ UINT64_MAX };
+        uint64_t _max_timestamp{ 0 };
+        uint64_t _record_count{ 0 };
+        uint64_t _segment_size{ 0 };
+    };
+
+    // Read-only view over a saved index, mapped in place
+    class LogSegmentIndex
+    {
+    public:
+        struct Range {
+            size_t offset;
+            size_t size;
+        };
+
+        LogSegmentIndex() = default;
+        explicit LogSegmentIndex(const char* path);
+
+        inline operator bool() const { return _header != nullptr; }
+
+        inline uint64_t minTimestamp() const { return _header->min_timestamp; }
+        inline uint64_t maxTimestamp() const { return _header->max_timestamp; }
+        inline uint64_t recordCount() const { return _header->record_count; }
+        inline uint64_t segmentSize() const { return _header->segment_size; }
+
+        // Byte ranges of the segment that can hold records within [from, to] with the given tag and signature
+        // (nullptr : any). Adjacent ranges are merged.
+        void find(uint64_t from, uint64_t to, const char* tag, const char* signature, std::vector<Range>& ranges) const;
+
+    private:
+        const LogSegmentIndexKey* findKey(const LogSegmentIndexKey* keys, uint32_t count, const char* text) const;
+        bool contains(const LogSegmentIndexKey* key, uint32_t block) const;
+
+        MemoryMappedFile _file;
+        const LogSegmentIndexHeader* _header{ nullptr };
+        const LogSegmentIndexBlock* _blocks{ nullptr };
+        const LogSegmentIndexKey* _tags{ nullptr };
+        const LogSegmentIndexKey* _signatures{ nullptr };
+        const uint32_t* _postings{ nullptr };
+
+        // running max of block max_timestamp and running min (from the end) of block min_timestamp.
+        // Both are monotonic, so the blocks of a time range are found by binary search
+        // even if logs of different clients arrive slightly out of order.
+        std::vector<uint64_t> _prefix_max;
+        std::vector<uint64_t> _suffix_min;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_INDEX__
@@ -0,0 +1,158 @@
+#include "log_segment_recovery.hpp"
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+std::vector<std::string> Bn3Monkey::LogSegmentRecovery::listSegments(const std::string& directory)
+{
+	std::vector<std::string> ret;
+	std::error_code error;
+	for (auto& entry : std::filesystem::directory_iterator(directory.empty() ? "." : directory, error)) {
+		auto& path = entry.path();
+		if (entry.is_regular_file(error) && path.extension() == ".slog" && path.filename().string().compare(0, 4, "log_") == 0)
+			ret.push_back(path.string());
+	}
+	// log_YYYYMMDD_HHMMSS_NNNN.slog 이므로 이름 순서가 생성 순서다
+	std::sort(ret.begin(), ret.end());
+	return ret;
+}
+
+bool Bn3Monkey::LogSegmentRecovery::isClosed(const std::string& path, uint64_t& records_size, uint8_t* flags)
+{
+	std::error_code error;
+	uint64_t size = std::filesystem::file_size(path, error);
+	if (error || size < LogSegmentFooter::SIZE)
+		return false;
+
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+	char footer[LogSegmentFooter::SIZE];
+	bool ret = fseek(file, static_cast<long>(size - LogSegmentFooter::SIZE), SEEK_SET) == 0
+		&& fread(footer, 1, sizeof(footer), file) == sizeof(footer)
+		&& LogSegmentFooter::isValid(footer, size - LogSegmentFooter::SIZE);
+	fclose(file);
+
+	if (ret) {
+		records_size = LogSegmentFooter::getRecordsSize(footer);
+		if (flags)
+			*flags = LogSegmentFooter::getFlags(footer);
+	}
+	return ret;
+}
+
+bool Bn3Monkey::LogSegmentRecovery::markDamaged(const std::string& path)
+{
+	std::error_code error;
+	uint64_t size = std::filesystem::file_size(path, error);
+	if (error || size < LogSegmentFooter::SIZE)
+		return false;
+
+	FILE* file = fopen(path.c_str(), "r+b");
+	if (!file)
+		return false;
+	// 푸터만 고쳐 쓴다. 레코드는 건드리지 않는다.
+	char data[LogSegmentFooter::SIZE];
+	long offset = static_cast<long>(size - LogSegmentFooter::SIZE);
+	bool ret = fseek(file, offset, SEEK_SET) == 0
+		&& fread(data, 1, sizeof(data), file) == sizeof(data)
+		&& LogSegmentFooter::isValid(data, size - LogSegmentFooter::SIZE);
+	if (ret && !(LogSegmentFooter::getFlags(data) & LogSegmentFooter::FLAG_DAMAGED)) {
+		LogSegmentFooter footer;
+		memcpy(&footer, data, sizeof(footer));
+		LogSegmentFooter::encode(data, footer.record_count, footer.records_size, footer.flags | LogSegmentFooter::FLAG_DAMAGED);
+		ret = fseek(file, offset, SEEK_SET) == 0
+			&& fwrite(data, 1, sizeof(data), file) == sizeof(data)
+			&& fflush(file) == 0;
+		if (ret) {
+#ifdef _WIN32
+			ret = _commit(_fileno(file)) == 0;
+#else
+			ret = fsync(fileno(file)) == 0;
+#endif
+		}
+	}
+	fclose(file);
+	return ret;
+}
+
+LogSegmentScan Bn3Monkey::LogSegmentRecovery::recover(const std::string& path, LogSegmentIndexBuilder* index)
+{
+	LogSegmentScan ret;
+	MemoryMappedFile file{ path.c_str(), MemoryMappedFile::Access::READONLY, 0, MemoryMappedFile::HINT_SEQUENTIAL };
+	if (!file)
+		return ret;
+
+	const char* data = file.data();
+	size_t size = file.size();
+	size_t offset = 0;
+	while (offset < size) {
+		LogRecord record{ data + offset };
+		if (record.isValid(size - offset) && record.isIntact()) {
+			if (index)
+				index->add(offset, record);
+			offset += record.size();
+			ret.records_size = offset;
+			ret.record_count++;
+			continue;
+		}
+
+		if (size - offset >= LogSegmentFooter::SIZE && LogSegmentFooter::isValid(data + offset, offset)) {
+			ret.is_closed = true;
+			break;
+		}
+
+		// 깨진 레코드나 쓰지 않은 영역이다. 뒤에 온전한 레코드가 있으면 거기서 이어 간다.
+		size_t next = LogRecord::findIntact(data, offset + 1, size);
+		if (next == size)
+			break;
+		ret.skipped_size += next - offset;
+		offset = next;
+	}
+
+	// 깨진 바이트를 남긴 채 닫힌 세그먼트는 파일 끝에 푸터가 있다
+	if (!ret.is_closed && size >= LogSegmentFooter::SIZE && LogSegmentFooter::isValid(data + size - LogSegmentFooter::SIZE, size - LogSegmentFooter::SIZE))
+		ret.is_closed = LogSegmentFooter::getRecordsSize(data + size - LogSegmentFooter::SIZE) == ret.records_size;
+
+	size_t end = size;
+	while (end > ret.records_size && data[end - 1] == 0)
+		end--;
+	ret.written_size = end;
+	return ret;
+}
+
+bool Bn3Monkey::LogSegmentRecovery::close(const std::string& path, const LogSegmentScan& scan)
+{
+	// 레코드 뒤의 0만 잘라 낸다. 깨진 레코드의 바이트는 푸터 앞에 남는다.
+	std::error_code error;
+	std::filesystem::resize_file(path, scan.written_size, error);
+	if (error)
+		return false;
+
+	FILE* file = fopen(path.c_str(), "ab");
+	if (!file)
+		return false;
+	char footer[LogSegmentFooter::SIZE];
+	LogSegmentFooter::encode(footer, scan.record_count, scan.records_size, scan.isClean() ? 0 : LogSegmentFooter::FLAG_DAMAGED);
+	bool ret = fwrite(footer, 1, sizeof(footer), file) == sizeof(footer) && fflush(file) == 0;
+	if (ret) {
+#ifdef _WIN32
+		ret = _commit(_fileno(file)) == 0;
+#else
+		ret = fsync(fileno(file)) == 0;
+#endif
+	}
+	fclose(file);
+	return ret;
+}
@@ -0,0 +1,56 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_RECOVERY__
+#define __BN3MONKEY_LOG_SEGMENT_RECOVERY__
+
+#include "log_record.hpp"
+#include "log_segment_index.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    struct LogSegmentScan
+    {
+        // the segment already ends with its footer
+        bool is_closed{ false };
+        // end of the last intact record. The segment is logically cut there, but no byte is removed.
+        size_t records_size{ 0 };
+        size_t record_count{ 0 };
+        // bytes of damaged records skipped before records_size
+        size_t skipped_size{ 0 };
+        // end of the last non-zero byte (0 : the file holds nothing but zeros)
+        size_t written_size{ 0 };
+
+        // Whether records can be appended at records_size without leaving anything behind them
+        inline bool isClean() const { return skipped_size == 0 && written_size <= records_size; }
+    };
+
+    // Startup scan of the segments a LogPool left behind.
+    // A segment without a footer was being written when the process died. Its pages may hold committed records,
+    // records that were written back by the kernel without a commit, a record cut in the middle and zero pages.
+    // The records are walked from the front and checked against their checksums. A damaged record is skipped
+    // by searching for the next record that matches its checksum, so that one bad record does not hide the rest.
+    class LogSegmentRecovery
+    {
+    public:
+        // A segment without any intact record but with some content is renamed to <segment>.corrupt
+        static constexpr const char* CORRUPT_EXTENSION = ".corrupt";
+
+        // Uncompressed segment files (.slog) of the directory, oldest first
+        static std::vector<std::string> listSegments(const std::string& directory);
+        // Whether the file ends with a valid footer, and where its records end (and the flags of the footer, if given).
+        // Only the end of the file is read.
+        static bool isClosed(const std::string& path, uint64_t& records_size, uint8_t* flags = nullptr);
+        // Sets LogSegmentFooter::FLAG_DAMAGED in the footer of a closed segment
+        static bool markDamaged(const std::string& path);
+
+        // Finds the intact records of a segment and adds them to index if given. The file is only read.
+        static LogSegmentScan recover(const std::string& path, LogSegmentIndexBuilder* index = nullptr);
+        // Cuts the zero tail of a recovered segment and appends the footer.
+        // The bytes of damaged records are kept in front of it, and the footer is marked damaged unless the scan is clean.
+        static bool close(const std::string& path, const LogSegmentScan& scan);
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_RECOVERY__
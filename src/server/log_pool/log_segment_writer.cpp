@@ -0,0 +1,23 @@
+#include "log_segment_writer.hpp"
+#include "log_direct_segment_writer.hpp"
+
+using namespace Bn3Monkey;
+
+std::unique_ptr<LogSegmentWriter> Bn3Monkey::LogSegmentWriter::create(const char* path, const LogSegmentWriterConfiguration& configuration)
+{
+#if defined(__linux__)
+	if (configuration.type == LogSegmentWriterType::DIRECT)
+		return std::make_unique<LogDirectSegmentWriter>(path, configuration.segment_size, configuration.buffer_size, configuration.buffer_count);
+#endif
+	// DIRECT가 없는 플랫폼에서는 mmap으로 쓴다
+	return std::make_unique<LogMappedSegmentWriter>(path, configuration.segment_size, configuration.is_populated);
+}
+
+std::unique_ptr<LogSegmentWriter> Bn3Monkey::LogSegmentWriter::open(const char* path, const LogSegmentWriterConfiguration& configuration, size_t used_size)
+{
+#if defined(__linux__)
+	if (configuration.type == LogSegmentWriterType::DIRECT)
+		return std::make_unique<LogDirectSegmentWriter>(path, configuration.segment_size, configuration.buffer_size, configuration.buffer_count, used_size);
+#endif
+	return std::make_unique<LogMappedSegmentWriter>(path, configuration.segment_size, configuration.is_populated, false);
+}
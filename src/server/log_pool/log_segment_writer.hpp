@@ -0,0 +1,100 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_WRITER__
+#define __BN3MONKEY_LOG_SEGMENT_WRITER__
+
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Bn3Monkey
+{
+    enum class LogSegmentWriterType : uint8_t
+    {
+        // records are encoded into a shared mapping of the segment and committed with msync
+        MEMORY_MAPPED,
+        // records are encoded into aligned buffers that an I/O thread writes with O_DIRECT (Linux only)
+        DIRECT,
+    };
+
+    struct LogSegmentWriterConfiguration
+    {
+        LogSegmentWriterType type{ LogSegmentWriterType::MEMORY_MAPPED };
+        size_t segment_size{ 4 * 1024 * 1024 };
+        // MEMORY_MAPPED : fault the pages in while the segment is pre-allocated
+        bool is_populated{ false };
+        // DIRECT : buffers in flight between the writing thread and the I/O thread
+        size_t buffer_size{ 1024 * 1024 };
+        size_t buffer_count{ 4 };
+    };
+
+    // How LogPool puts the records of a segment on the storage.
+    // Records are only appended. The writing thread encodes them into reserve()d memory and reports them with written(),
+    // commit() may be called from another thread (group commit) at any time.
+    // Once the storage fails, error() is CANNOT_WRITE_FILE and the segment takes no more records.
+    class LogSegmentWriter
+    {
+    public:
+        using Sync = MemoryMappedFile::Sync;
+
+        // Creates a new segment of configuration.segment_size bytes at path.
+        // Check error() : FILE_ALREADY_EXISTS if path is taken.
+        static std::unique_ptr<LogSegmentWriter> create(const char* path, const LogSegmentWriterConfiguration& configuration);
+        // Reopens an existing segment to append after its first used_size bytes (see LogSegmentRecovery).
+        // The file is grown back to configuration.segment_size.
+        static std::unique_ptr<LogSegmentWriter> open(const char* path, const LogSegmentWriterConfiguration& configuration, size_t used_size);
+
+        virtual ~LogSegmentWriter() = default;
+
+        inline operator bool() const { return error() == MemoryMappedFile::Code::SUCCESS; }
+        virtual MemoryMappedFile::Code error() const = 0;
+        virtual size_t size() const = 0;
+        // Most bytes a single reserve() can ask for
+        virtual size_t getMaxReserve() const = 0;
+
+        // Memory for the records at offset (the end of what was written so far). size bytes are contiguous.
+        virtual char* reserve(size_t offset, size_t size) = 0;
+        // The reserved memory holds size bytes of records now
+        virtual void written(size_t offset, size_t size) = 0;
+        // Puts what was written in [offset, offset + length) on the storage.
+        // Returns false if the storage failed, now or for an earlier write.
+        virtual bool commit(size_t offset, size_t length, Sync sync) = 0;
+        // Writes everything out, closes the segment and cuts it down to used_size bytes.
+        // Returns false if not everything written reached the storage.
+        virtual bool release(size_t used_size) = 0;
+    };
+
+    class LogMappedSegmentWriter : public LogSegmentWriter
+    {
+    public:
+        LogMappedSegmentWriter(const char* path, size_t size, bool is_populated, bool is_created = true) :
+            _file(path, is_created ? MemoryMappedFile::Access::READWRITE_WITH_CREATE_NEW : MemoryMappedFile::Access::READWRITE_WITH_OPEN, size,
+                MemoryMappedFile::HINT_PREALLOCATE | (is_populated ? MemoryMappedFile::HINT_POPULATE : MemoryMappedFile::HINT_NONE))
+        {
+        }
+
+        MemoryMappedFile::Code error() const override {
+            return _is_failed.load(std::memory_order_relaxed) ? MemoryMappedFile::Code::CANNOT_WRITE_FILE : _file.error();
+        }
+        size_t size() const override { return _file.size(); }
+        size_t getMaxReserve() const override { return _file.size(); }
+
+        char* reserve(size_t offset, size_t) override { return _file.data() + offset; }
+        void written(size_t, size_t) override {}
+        bool commit(size_t offset, size_t length, Sync sync) override {
+            if (!_file.commit(offset, length, sync))
+                _is_failed.store(true, std::memory_order_relaxed);
+            return !_is_failed.load(std::memory_order_relaxed);
+        }
+        bool release(size_t used_size) override {
+            _file.release(used_size);
+            return !_is_failed.load(std::memory_order_relaxed);
+        }
+
+    private:
+        MemoryMappedFile _file;
+        std::atomic<bool> _is_failed{ false };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_WRITER__
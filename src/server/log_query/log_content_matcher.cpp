@@ -0,0 +1,172 @@
+#include "log_content_matcher.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BN3MONKEY_LOG_MATCHER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BN3MONKEY_TARGET_AVX2
+#else
+#define BN3MONKEY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace Bn3Monkey;
+
+namespace
+{
+	inline uint32_t countTrailingZeros(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	bool findScalar(const char* text, size_t size, const char* pattern, size_t pattern_size)
+	{
+		if (pattern_size > size)
+			return false;
+
+		const char* end = text + size - pattern_size + 1;
+		const char* current = text;
+		while (current < end) {
+			current = static_cast<const char*>(memchr(current, pattern[0], end - current));
+			if (!current)
+				return false;
+			if (memcmp(current + 1, pattern + 1, pattern_size - 1) == 0)
+				return true;
+			current++;
+		}
+		return false;
+	}
+
+#if defined(BN3MONKEY_LOG_MATCHER_X86)
+	bool findSSE2(const char* text, size_t size, const char* pattern, size_t pattern_size)
+	{
+		if (pattern_size > size)
+			return false;
+		if (pattern_size == 1)
+			return memchr(text, pattern[0], size) != nullptr;
+
+		const __m128i first = _mm_set1_epi8(pattern[0]);
+		const __m128i last = _mm_set1_epi8(pattern[pattern_size - 1]);
+
+		size_t i = 0;
+		// 두 번의 load가 모두 text 안에 있는 동안만 벡터로 비교한다
+		for (; i + pattern_size - 1 + 16 <= size; i += 16) {
+			__m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+			__m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + pattern_size - 1));
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+			while (mask) {
+				uint32_t bit = countTrailingZeros(mask);
+				if (memcmp(text + i + bit + 1, pattern + 1, pattern_size - 2) == 0)
+					return true;
+				mask &= mask - 1;
+			}
+		}
+		return findScalar(text + i, size - i, pattern, pattern_size);
+	}
+
+	BN3MONKEY_TARGET_AVX2 bool findAVX2(const char* text, size_t size, const char* pattern, size_t pattern_size)
+	{
+		if (pattern_size > size)
+			return false;
+		if (pattern_size == 1)
+			return memchr(text, pattern[0], size) != nullptr;
+
+		const __m256i first = _mm256_set1_epi8(pattern[0]);
+		const __m256i last = _mm256_set1_epi8(pattern[pattern_size - 1]);
+
+		size_t i = 0;
+		for (; i + pattern_size - 1 + 32 <= size; i += 32) {
+			__m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+			__m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + pattern_size - 1));
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+			while (mask) {
+				uint32_t bit = countTrailingZeros(mask);
+				if (memcmp(text + i + bit + 1, pattern + 1, pattern_size - 2) == 0)
+					return true;
+				mask &= mask - 1;
+			}
+		}
+		return findSSE2(text + i, size - i, pattern, pattern_size);
+	}
+
+	bool isAVX2Supported()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// OS가 YMM 레지스터를 저장해 주는지도 확인해야 한다
+		bool is_osxsave = (info[2] & (1 << 27)) != 0;
+		if (!is_osxsave || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+Bn3Monkey::LogContentMatcher::LogContentMatcher(std::vector<std::string> patterns, Implementation implementation) :
+	_patterns(std::move(patterns))
+{
+	// 빈 패턴은 모든 내용에 맞는다
+	_is_matching_all = std::any_of(_patterns.begin(), _patterns.end(), [](const std::string& pattern) { return pattern.empty(); });
+
+	// 지원하지 않는 명령어를 고르면 SIGILL이 나므로 CPU가 지원하는 것까지만 쓴다
+	if (implementation == Implementation::AUTO || implementation > getSupportedImplementation())
+		implementation = getSupportedImplementation();
+#if !defined(BN3MONKEY_LOG_MATCHER_X86)
+	implementation = Implementation::SCALAR;
+#endif
+	_implementation = implementation;
+
+	switch (implementation) {
+#if defined(BN3MONKEY_LOG_MATCHER_X86)
+	case Implementation::AVX2:
+		_find = findAVX2;
+		break;
+	case Implementation::SSE2:
+		_find = findSSE2;
+		break;
+#endif
+	default:
+		_implementation = Implementation::SCALAR;
+		_find = findScalar;
+		break;
+	}
+}
+
+bool Bn3Monkey::LogContentMatcher::matches(const char* text, size_t size) const
+{
+	if (_is_matching_all)
+		return true;
+	for (auto& pattern : _patterns) {
+		if (_find(text, size, pattern.data(), pattern.size()))
+			return true;
+	}
+	return false;
+}
+
+LogContentMatcher::Implementation Bn3Monkey::LogContentMatcher::getSupportedImplementation()
+{
+#if defined(BN3MONKEY_LOG_MATCHER_X86)
+	static const Implementation implementation = isAVX2Supported() ? Implementation::AVX2 : Implementation::SSE2;
+	return implementation;
+#else
+	return Implementation::SCALAR;
+#endif
+}
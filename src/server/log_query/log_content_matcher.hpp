@@ -0,0 +1,51 @@
+#ifndef __BN3MONKEY_LOG_CONTENT_MATCHER__
+#define __BN3MONKEY_LOG_CONTENT_MATCHER__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Substring search over log contents. A text matches if it contains any of the patterns,
+    // so an empty pattern matches every text.
+    //
+    // Candidates are found by comparing the first and the last byte of a pattern against a whole vector of
+    // positions at once, and only those are compared in full. The widest instruction set the CPU supports
+    // is picked at run time.
+    class LogContentMatcher
+    {
+    public:
+        enum class Implementation : uint8_t
+        {
+            AUTO,
+            SCALAR,
+            SSE2,
+            AVX2,
+        };
+
+        LogContentMatcher() = default;
+        // An implementation the CPU does not support falls back to getSupportedImplementation()
+        explicit LogContentMatcher(std::vector<std::string> patterns, Implementation implementation = Implementation::AUTO);
+
+        inline bool empty() const { return _patterns.empty(); }
+        inline const std::vector<std::string>& patterns() const { return _patterns; }
+        inline Implementation implementation() const { return _implementation; }
+
+        bool matches(const char* text, size_t size) const;
+
+        // Best implementation available on this CPU
+        static Implementation getSupportedImplementation();
+
+    private:
+        using Find = bool (*)(const char* text, size_t size, const char* pattern, size_t pattern_size);
+
+        std::vector<std::string> _patterns;
+        Implementation _implementation{ Implementation::SCALAR };
+        Find _find{ nullptr };
+        bool _is_matching_all{ false };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_CONTENT_MATCHER__
@@ -0,0 +1,396 @@
+#include "log_query.hpp"
+#include "../log_pool/log_segment_recovery.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+using namespace Bn3Monkey;
+
+std::vector<std::string> Bn3Monkey::LogQuery::listSegments(const char* directory)
+{
+	std::vector<std::string> ret;
+	std::error_code error;
+	for (auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		auto& path = entry.path();
+		if (entry.is_regular_file(error) && (path.extension() == ".slog" || path.extension() == LogSegmentCompactor::EXTENSION))
+			ret.push_back(path.string());
+	}
+	// log_YYYYMMDD_HHMMSS_NNNN.slog(z) 이므로 이름 순서가 생성 순서다
+	std::sort(ret.begin(), ret.end());
+
+	// 압축하는 중이라 원본과 압축 파일이 같이 있으면 원본을 읽는다
+	ret.erase(std::unique(ret.begin(), ret.end(), [](const std::string& a, const std::string& b) {
+		return getSegmentKey(a) == getSegmentKey(b);
+	}), ret.end());
+	return ret;
+}
+
+std::vector<std::string> Bn3Monkey::LogQuery::listStreams(const char* directory)
+{
+	std::vector<std::string> ret;
+	std::error_code error;
+	for (auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.is_directory(error) && entry.path().filename().string().compare(0, 6, "shard_") == 0)
+			ret.push_back(entry.path().string());
+	}
+	std::sort(ret.begin(), ret.end());
+
+	// shard로 나누기 전에 쓴 세그먼트도 함께 읽는다
+	if (ret.empty() || !listSegments(directory).empty())
+		ret.insert(ret.begin(), directory);
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::run(const char* directory, const LogQueryFilter& filter, const Callback& callback, size_t thread_count)
+{
+	auto streams = listStreams(directory);
+	if (streams.size() > 1)
+		return runMerged(streams, filter, callback);
+
+	auto segments = listSegments(directory);
+	if (thread_count > 1 && segments.size() > 1)
+		return runParallel(segments, filter, callback, thread_count);
+
+	size_t ret = 0;
+	bool is_stopped = false;
+	for (auto& path : segments) {
+		if (isFinished(path)) {
+			LogSegmentReader reader{ path };
+			ret += read(reader, filter, callback, is_stopped);
+		}
+		else {
+			LogSegmentFollower follower{ path };
+			ret += read(follower, filter, callback, is_stopped);
+		}
+		if (is_stopped)
+			break;
+	}
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::runMerged(const std::vector<std::string>& streams, const LogQueryFilter& filter, const Callback& callback)
+{
+	// Walks the segments of one stream in order, like the single stream case of run()
+	struct Cursor {
+		std::vector<std::string> segments;
+		size_t next_segment{ 0 };
+		std::unique_ptr<LogSegmentReader> reader;
+		std::unique_ptr<LogSegmentFollower> follower;
+	};
+	std::vector<Cursor> cursors(streams.size());
+	for (size_t i = 0; i < streams.size(); i++)
+		cursors[i].segments = listSegments(streams[i].c_str());
+
+	bool is_stopped = false;
+	return merge(streams.size(), [&](size_t i, LogRecord& record) {
+		auto& cursor = cursors[i];
+		while (true) {
+			if (cursor.reader && cursor.reader->next(record))
+				return true;
+			if (cursor.follower) {
+				while (cursor.follower->next(record)) {
+					if (filter.matches(record))
+						return true;
+				}
+			}
+
+			// 앞의 세그먼트에서 넘겨준 레코드는 이미 처리되었으므로 닫아도 된다
+			cursor.reader.reset();
+			cursor.follower.reset();
+			if (cursor.next_segment >= cursor.segments.size())
+				return false;
+
+			auto& path = cursor.segments[cursor.next_segment++];
+			if (isFinished(path)) {
+				cursor.reader = std::make_unique<LogSegmentReader>(path);
+				cursor.reader->seek(filter);
+			}
+			else {
+				cursor.follower = std::make_unique<LogSegmentFollower>(path);
+			}
+		}
+	}, callback, is_stopped);
+}
+
+size_t Bn3Monkey::LogQuery::merge(size_t stream_count, const std::function<bool(size_t, LogRecord&)>& next, const Callback& callback, bool& is_stopped)
+{
+	std::vector<LogRecord> heads(stream_count);
+	// 타임스탬프가 같으면 shard 순서대로 넘긴다
+	auto is_later = [&](size_t a, size_t b) {
+		uint64_t time_a = heads[a].header().timestamp;
+		uint64_t time_b = heads[b].header().timestamp;
+		return time_a != time_b ? time_a > time_b : a > b;
+	};
+	std::priority_queue<size_t, std::vector<size_t>, decltype(is_later)> queue{ is_later };
+	for (size_t i = 0; i < stream_count; i++) {
+		if (next(i, heads[i]))
+			queue.push(i);
+	}
+
+	size_t ret = 0;
+	while (!queue.empty()) {
+		size_t i = queue.top();
+		queue.pop();
+		ret++;
+		if (!callback(heads[i])) {
+			is_stopped = true;
+			break;
+		}
+		if (next(i, heads[i]))
+			queue.push(i);
+	}
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::runParallel(const std::vector<std::string>& segments, const LogQueryFilter& filter, const Callback& callback, size_t thread_count)
+{
+	// Records found by a worker point into its reader's mapping, so the reader is kept until they are handed out
+	struct Task {
+		std::unique_ptr<LogSegmentReader> reader;
+		std::vector<LogRecord> records;
+		bool is_done{ false };
+	};
+	std::vector<Task> tasks(segments.size());
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t next = 0;
+	size_t consumed = 0;
+	bool is_stopped = false;
+	// 결과를 넘겨주기 전에 매핑해 두는 세그먼트 수를 제한한다
+	const size_t window = thread_count * 2;
+
+	auto work = [&]() {
+		while (true) {
+			size_t index;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&]() { return is_stopped || next >= segments.size() || next < consumed + window; });
+				if (is_stopped || next >= segments.size())
+					return;
+				index = next++;
+			}
+
+			// 쓰고 있을 수 있는 세그먼트는 매핑하지 않고 순서가 왔을 때 따로 읽는다
+			std::unique_ptr<LogSegmentReader> reader;
+			std::vector<LogRecord> records;
+			if (isFinished(segments[index])) {
+				reader = std::make_unique<LogSegmentReader>(segments[index]);
+				reader->seek(filter);
+				LogRecord record;
+				while (reader->next(record))
+					records.push_back(record);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks[index].reader = std::move(reader);
+			tasks[index].records = std::move(records);
+			tasks[index].is_done = true;
+			cv.notify_all();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < std::min(thread_count, segments.size()); i++)
+		workers.emplace_back(work);
+
+	size_t ret = 0;
+	bool is_callback_stopped = false;
+	for (size_t i = 0; i < segments.size() && !is_callback_stopped; i++) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&]() { return tasks[i].is_done; });
+			task = std::move(tasks[i]);
+		}
+
+		if (task.reader) {
+			for (auto& record : task.records) {
+				ret++;
+				if (!callback(record)) {
+					is_callback_stopped = true;
+					break;
+				}
+			}
+		}
+		else {
+			LogSegmentFollower follower{ segments[i] };
+			ret += read(follower, filter, callback, is_callback_stopped);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		consumed = i + 1;
+		cv.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		is_stopped = true;
+		cv.notify_all();
+	}
+	for (auto& worker : workers)
+		worker.join();
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::follow(const char* directory, const LogQueryFilter& filter, const Callback& callback, const IdleCallback& on_idle, std::chrono::milliseconds interval)
+{
+	size_t ret = 0;
+	bool is_stopped = false;
+	std::map<std::string, FollowState> states;
+
+	while (!is_stopped) {
+		auto streams = listStreams(directory);
+		if (streams.size() == 1) {
+			ret += poll(streams[0].c_str(), states[streams[0]], filter, callback, is_stopped);
+		}
+		else {
+			// follower의 레코드는 다음 레코드를 읽으면 사라지므로 shard마다 새로 읽은 것을 복사해 두고 합친다
+			std::vector<std::vector<char>> records(streams.size());
+			std::vector<size_t> offsets(streams.size(), 0);
+			for (size_t i = 0; i < streams.size(); i++) {
+				bool is_shard_stopped = false;
+				poll(streams[i].c_str(), states[streams[i]], filter, [&](const LogRecord& record) {
+					records[i].insert(records[i].end(), record.data(), record.data() + record.size());
+					return true;
+				}, is_shard_stopped);
+			}
+			ret += merge(streams.size(), [&](size_t i, LogRecord& record) {
+				if (offsets[i] >= records[i].size())
+					return false;
+				record = LogRecord(records[i].data() + offsets[i]);
+				offsets[i] += record.size();
+				return true;
+			}, callback, is_stopped);
+		}
+
+		if (is_stopped || !on_idle())
+			break;
+		std::this_thread::sleep_for(interval);
+	}
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::poll(const char* directory, FollowState& state, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped)
+{
+	size_t ret = 0;
+	auto segments = listSegments(directory);
+	auto& last_closed = state.last_closed;
+	auto& follower = state.follower;
+
+	for (size_t i = 0; i < segments.size() && !is_stopped; i++) {
+		auto& path = segments[i];
+		std::string key = getSegmentKey(path);
+		if (!last_closed.empty() && key <= last_closed)
+			continue;
+
+		// 닫혔는지를 먼저 확인해야 그 사이에 쓰인 레코드까지 읽고 넘어간다.
+		// 따라가던 세그먼트가 그 사이에 압축되었어도 열어 둔 원본에서 마저 읽는다.
+		bool is_closed = isClosed(segments, i);
+		bool is_following = follower && *follower && getSegmentKey(follower->path()) == key;
+		if (is_following) {
+			ret += read(*follower, filter, callback, is_stopped);
+		}
+		else if (is_closed) {
+			LogSegmentReader reader{ path };
+			ret += read(reader, filter, callback, is_stopped);
+		}
+		else {
+			// 열지 못했으면 (그 사이에 압축된 경우 등) 다음 목록에서 다시 본다
+			follower = std::make_unique<LogSegmentFollower>(path);
+			ret += read(*follower, filter, callback, is_stopped);
+		}
+
+		if (!is_closed)
+			break;
+		last_closed = key;
+		if (is_following)
+			follower.reset();
+	}
+	return ret;
+}
+
+std::string Bn3Monkey::LogQuery::getSegmentKey(const std::string& path)
+{
+	return LogSegmentCompactor::isCompressedPath(path) ? LogSegmentCompactor::getSegmentPath(path) : path;
+}
+
+bool Bn3Monkey::LogQuery::isFinished(const std::string& path)
+{
+	// 쓰고 있는 세그먼트는 rotation에서 잘릴 수 있어 매핑하면 SIGBUS가 날 수 있다. 매핑하기 전에 파일 I/O로만 확인한다.
+	// 인덱스는 세그먼트를 닫은 뒤에 쓰이고, 목록을 만든 뒤에 압축되었으면 reader가 압축 파일을 연다.
+	if (LogSegmentCompactor::isCompressedPath(path))
+		return true;
+	std::error_code error;
+	if (std::filesystem::exists(LogSegmentIndexBuilder::getPath(path), error) || std::filesystem::exists(LogSegmentCompactor::getCompressedPath(path), error))
+		return true;
+	uint64_t records_size = 0;
+	return LogSegmentRecovery::isClosed(path, records_size);
+}
+
+bool Bn3Monkey::LogQuery::isClosed(const std::vector<std::string>& segments, size_t index)
+{
+	if (LogSegmentCompactor::isCompressedPath(segments[index]))
+		return true;
+
+	// LogPool은 세그먼트를 잘라낸 뒤에 인덱스를 쓴다
+	std::error_code error;
+	if (std::filesystem::exists(LogSegmentIndexBuilder::getPath(segments[index]), error))
+		return true;
+	uint64_t records_size = 0;
+	if (LogSegmentRecovery::isClosed(segments[index], records_size))
+		return true;
+
+	// 인덱스를 쓰지 않는 경우에는 뒤의 세그먼트에 레코드가 쓰이기 시작했는지로 판단한다.
+	// 다음 세그먼트는 미리 만들어지므로 파일이 있다는 것만으로는 알 수 없다.
+	for (size_t i = index + 1; i < segments.size(); i++) {
+		if (LogSegmentCompactor::isCompressedPath(segments[i]))
+			return true;
+		char magic[LogRecordHeader::MAGIC_SIZE]{ 0 };
+		FILE* file = fopen(segments[i].c_str(), "rb");
+		if (!file)
+			continue;
+		size_t size = fread(magic, 1, sizeof(magic), file);
+		fclose(file);
+		if (size == sizeof(magic) && memcmp(magic, LogRecordHeader::MAGIC, sizeof(magic)) == 0)
+			return true;
+	}
+	return false;
+}
+
+size_t Bn3Monkey::LogQuery::read(LogSegmentReader& reader, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped)
+{
+	size_t ret = 0;
+	reader.seek(filter);
+	LogRecord record;
+	while (reader.next(record)) {
+		ret++;
+		if (!callback(record)) {
+			is_stopped = true;
+			break;
+		}
+	}
+	return ret;
+}
+
+size_t Bn3Monkey::LogQuery::read(LogSegmentFollower& follower, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped)
+{
+	size_t ret = 0;
+	LogRecord record;
+	while (follower.next(record)) {
+		if (!filter.matches(record))
+			continue;
+		ret++;
+		if (!callback(record)) {
+			is_stopped = true;
+			break;
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,70 @@
+#ifndef __BN3MONKEY_LOG_QUERY__
+#define __BN3MONKEY_LOG_QUERY__
+
+#include <simple_log_protocol.hpp>
+#include "../log_pool/log_record.hpp"
+#include "log_segment_reader.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Searches the segments a LogPool left in a directory.
+    // Closed segments (compressed, or with a sidecar index) are mapped and narrowed down by the index,
+    // the others (e.g. the one still being written) are read as they are.
+    // The shard_NN subdirectories of a LogShardedWriter are read side by side and merged by timestamp.
+    class LogQuery
+    {
+    public:
+        // Return false to stop the query
+        using Callback = std::function<bool(const LogRecord&)>;
+        // Called whenever follow() has caught up with the writer. Return false to stop following.
+        using IdleCallback = std::function<bool()>;
+
+        // Segment files (.slog and .slogz) in the directory in the order they were created
+        static std::vector<std::string> listSegments(const char* directory);
+        // Directories holding segments : the directory itself, or its shard directories, or both
+        static std::vector<std::string> listStreams(const char* directory);
+
+        // Calls callback for each matching record and returns how many records matched.
+        // With more than one thread, closed segments are searched in parallel and handed to callback in order.
+        // Shards are merged by timestamp, each read on the calling thread.
+        static size_t run(const char* directory, const LogQueryFilter& filter, const Callback& callback, size_t thread_count = 1);
+        // Like run(), but keeps waiting for new records and new segments until callback or on_idle returns false
+        // Shards are merged by timestamp within each poll, so a shard whose writer lags behind can deliver a few older records late.
+        static size_t follow(const char* directory, const LogQueryFilter& filter, const Callback& callback, const IdleCallback& on_idle,
+            std::chrono::milliseconds interval = std::chrono::milliseconds{ 200 });
+
+    private:
+        // Where follow() left off in one directory
+        struct FollowState
+        {
+            // the last segment read to its end
+            std::string last_closed;
+            // the segment that may still be written
+            std::unique_ptr<LogSegmentFollower> follower;
+        };
+
+        // Hands the records of several streams to callback, always the earliest head first.
+        // next(i, record) gives the next record of stream i, which has to stay valid until next(i, ...) is called again.
+        static size_t merge(size_t stream_count, const std::function<bool(size_t, LogRecord&)>& next, const Callback& callback, bool& is_stopped);
+        static size_t runMerged(const std::vector<std::string>& streams, const LogQueryFilter& filter, const Callback& callback);
+        // Reads what was written to the directory since the last poll
+        static size_t poll(const char* directory, FollowState& state, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped);
+        static size_t runParallel(const std::vector<std::string>& segments, const LogQueryFilter& filter, const Callback& callback, size_t thread_count);
+        // Original segment path, the same for a segment and its compressed file
+        static std::string getSegmentKey(const std::string& path);
+        static bool isClosed(const std::vector<std::string>& segments, size_t index);
+        // Whether a segment is no longer written, so it can be read through its mapping. Only plain file I/O is used.
+        static bool isFinished(const std::string& path);
+        static size_t read(LogSegmentReader& reader, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped);
+        static size_t read(LogSegmentFollower& follower, const LogQueryFilter& filter, const Callback& callback, bool& is_stopped);
+    };
+}
+
+#endif // __BN3MONKEY_LOG_QUERY__
@@ -0,0 +1,203 @@
+#include "log_segment_reader.hpp"
+#include "../log_pool/log_block_codec.hpp"
+#include "../log_pool/log_segment_recovery.hpp"
+
+#include <algorithm>
+
+using namespace Bn3Monkey;
+
+Bn3Monkey::LogSegmentReader::LogSegmentReader(const std::string& path) :
+	_path(path),
+	_file(path.c_str(), MemoryMappedFile::Access::READONLY, 0, MemoryMappedFile::HINT_SEQUENTIAL)
+{
+	// 목록을 만든 뒤에 압축되어 원본이 지워졌을 수 있다
+	if (!_file && !LogSegmentCompactor::isCompressedPath(path)) {
+		_path = LogSegmentCompactor::getCompressedPath(path);
+		_file = MemoryMappedFile{ _path.c_str(), MemoryMappedFile::Access::READONLY, 0, MemoryMappedFile::HINT_SEQUENTIAL };
+	}
+
+	bool is_compressed = LogSegmentCompactor::isCompressedPath(_path);
+	_index = LogSegmentIndex{ LogSegmentIndexBuilder::getPath(is_compressed ? LogSegmentCompactor::getSegmentPath(_path) : _path).c_str() };
+
+	if (_file) {
+		if (is_compressed) {
+			openCompressed();
+		}
+		else {
+			_data = _file.data();
+			_size = _file.size();
+			// 닫힌 세그먼트는 푸터가 가리키는 곳에서 레코드가 끝난다. 그 뒤에는 깨진 레코드의 바이트가 남아 있을 수 있다.
+			// 매핑한 뒤에 파일이 잘렸을 수 있으므로 푸터는 매핑이 아니라 파일에서 읽는다.
+			uint64_t records_size = 0;
+			if (LogSegmentRecovery::isClosed(_path, records_size))
+				_size = std::min(_size, static_cast<size_t>(records_size));
+		}
+	}
+	seek(LogQueryFilter{});
+}
+
+void Bn3Monkey::LogSegmentReader::openCompressed()
+{
+	if (_file.size() < sizeof(LogCompressedSegmentHeader))
+		return;
+
+	auto* header = reinterpret_cast<const LogCompressedSegmentHeader*>(_file.data());
+	if (memcmp(header->magic, LogCompressedSegmentHeader::MAGIC, sizeof(header->magic)) != 0
+		|| header->version != LogCompressedSegmentHeader::VERSION
+		|| header->codec != LogCompressedSegmentHeader::CODEC_LZ4_BLOCK)
+		return;
+	if (_file.size() < sizeof(LogCompressedSegmentHeader) + sizeof(LogCompressedBlock) * header->block_count)
+		return;
+
+	_blocks = reinterpret_cast<const LogCompressedBlock*>(_file.data() + sizeof(LogCompressedSegmentHeader));
+	_block_count = header->block_count;
+	// 블록을 풀기 전의 자리는 0으로 남아 있어서 레코드로 읽히지 않는다
+	_raw.assign(header->raw_size, 0);
+	_is_loaded.assign(_block_count, false);
+	_data = _raw.data();
+	_size = _raw.size();
+}
+
+void Bn3Monkey::LogSegmentReader::seek(const LogQueryFilter& filter)
+{
+	_filter = filter;
+	_ranges.clear();
+	_range = 0;
+	_offset = 0;
+	_end = 0;
+
+	if (!_data)
+		return;
+
+	if (_index) {
+		_index.find(filter.from, filter.to,
+			filter.tag.empty() ? nullptr : filter.tag.c_str(),
+			filter.signature.empty() ? nullptr : filter.signature.c_str(),
+			_ranges);
+	}
+	else {
+		_ranges.push_back(LogSegmentIndex::Range{ 0, _size });
+	}
+
+	if (!_ranges.empty())
+		setRange(0);
+}
+
+bool Bn3Monkey::LogSegmentReader::next(LogRecord& record)
+{
+	while (_range < _ranges.size()) {
+		while (_offset < _end) {
+			LogRecord current{ _data + _offset };
+			// 깨진 레코드는 다음 온전한 레코드까지 건너뛴다. 아직 쓰이지 않은 영역이면 구간이 끝난다.
+			if (!current.isValid(_end - _offset) || !current.isIntact()) {
+				_offset = LogRecord::findIntact(_data, _offset + 1, _end);
+				continue;
+			}
+			_offset += current.size();
+			if (_filter.matches(current)) {
+				record = current;
+				return true;
+			}
+		}
+
+		_range++;
+		if (_range < _ranges.size())
+			setRange(_range);
+	}
+	return false;
+}
+
+void Bn3Monkey::LogSegmentReader::setRange(size_t range)
+{
+	_offset = std::min(_ranges[range].offset, _size);
+	_end = std::min(_ranges[range].offset + _ranges[range].size, _size);
+	if (_blocks)
+		load(_offset, _end);
+}
+
+void Bn3Monkey::LogSegmentReader::load(size_t offset, size_t end)
+{
+	// raw_offset 순서로 저장되어 있으므로 구간에 걸치는 첫 블록부터 푼다
+	auto* blocks_end = _blocks + _block_count;
+	auto* block = std::upper_bound(_blocks, blocks_end, offset, [](size_t value, const LogCompressedBlock& item) { return value < item.raw_offset; });
+	if (block != _blocks)
+		block--;
+
+	for (; block < blocks_end && block->raw_offset < end; block++) {
+		size_t index = static_cast<size_t>(block - _blocks);
+		if (_is_loaded[index])
+			continue;
+		_is_loaded[index] = true;
+
+		if (block->raw_offset + block->raw_size > _size || block->offset + block->size > _file.size())
+			continue;
+		const char* src = _file.data() + block->offset;
+		char* dest = _raw.data() + block->raw_offset;
+		if (block->size == block->raw_size) {
+			memcpy(dest, src, block->size);
+		}
+		else if (!LogBlockCodec::decompress(src, block->size, dest, block->raw_size)) {
+			// 깨진 블록은 0으로 두어 그 구간의 레코드를 건너뛴다
+			memset(dest, 0, block->raw_size);
+		}
+	}
+}
+
+Bn3Monkey::LogSegmentFollower::LogSegmentFollower(const std::string& path) :
+	_path(path),
+	_buffer(256 * LogRecord::MAX_SIZE)
+{
+	_file = fopen(path.c_str(), "rb");
+}
+
+Bn3Monkey::LogSegmentFollower::~LogSegmentFollower()
+{
+	if (_file)
+		fclose(_file);
+}
+
+bool Bn3Monkey::LogSegmentFollower::next(LogRecord& record)
+{
+	if (!_file)
+		return false;
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		while (_begin < _end) {
+			LogRecord current{ _buffer.data() + _begin };
+			if (!current.isValid(_end - _begin))
+				break;
+			if (!current.isIntact()) {
+				// 쓰는 중에 읽었을 수 있으므로 다시 읽어 본 뒤에도 맞지 않으면 다음 온전한 레코드로 넘어간다.
+				// 버퍼 안에 없으면 아직 다 쓰이지 않았을 다음 레코드를 건너뛰지 않도록 이 레코드만 넘긴다.
+				if (attempt == 0)
+					break;
+				size_t next = LogRecord::findIntact(_buffer.data(), _begin + 1, _end);
+				size_t skipped = (next < _end ? next : _begin + current.size()) - _begin;
+				_begin += skipped;
+				_offset += skipped;
+				continue;
+			}
+			_begin += current.size();
+			_offset += current.size();
+			record = current;
+			return true;
+		}
+		// 버퍼에 완전한 레코드가 없으면 파일에서 다시 읽어 본다
+		if (!fill())
+			return false;
+	}
+	return false;
+}
+
+bool Bn3Monkey::LogSegmentFollower::fill()
+{
+	// 읽지 않은 부분을 버리고 마지막으로 읽은 레코드 다음부터 다시 읽는다.
+	// 쓰고 있는 레코드는 다음에 읽을 때 완성되어 있다.
+	_begin = 0;
+	_end = 0;
+	if (fseek(_file, static_cast<long>(_offset), SEEK_SET) != 0)
+		return false;
+	clearerr(_file);
+	_end = fread(_buffer.data(), 1, _buffer.size(), _file);
+	return _end > 0;
+}
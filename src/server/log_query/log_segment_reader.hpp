@@ -0,0 +1,132 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_READER__
+#define __BN3MONKEY_LOG_SEGMENT_READER__
+
+#include <simple_log_protocol.hpp>
+#include "../memory_mapped_file/memory_mapped_file.hpp"
+#include "../log_pool/log_record.hpp"
+#include "../log_pool/log_segment_index.hpp"
+#include "../log_pool/log_segment_compactor.hpp"
+#include "log_content_matcher.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    struct LogQueryFilter
+    {
+        // nanoseconds since the Unix epoch, both inclusive
+        uint64_t from{ 0 };
+        uint64_t to{ UINT64_MAX };
+        // empty : any
+        std::string tag;
+        std::string signature;
+        bool is_color_filtered{ false };
+        LogColor color{ LogColor::Blue };
+        // contents containing any of its patterns (empty : any)
+        LogContentMatcher content;
+
+        inline bool matches(const LogRecord& record) const {
+            auto& header = record.header();
+            if (header.timestamp < from || header.timestamp > to)
+                return false;
+            if (is_color_filtered && header.color != color)
+                return false;
+            if (!tag.empty() && (tag.size() != record.tagSize() || memcmp(tag.data(), record.tag(), tag.size()) != 0))
+                return false;
+            if (!signature.empty() && (signature.size() != record.signatureSize() || memcmp(signature.data(), record.signature(), signature.size()) != 0))
+                return false;
+            if (!content.empty() && !content.matches(record.content(), record.contentSize()))
+                return false;
+            return true;
+        }
+    };
+
+    // Maps a finished segment read-only and walks its records in place.
+    // Records handed out by next() point into the mapping and stay valid while the reader lives.
+    // A compressed segment (.slogz) is read the same way : only the blocks holding the visited ranges
+    // are decompressed, into a buffer laid out like the original segment.
+    //
+    //   LogSegmentReader reader{ path };
+    //   reader.seek(filter);
+    //   LogRecord record;
+    //   while (reader.next(record)) { ... }
+    class LogSegmentReader
+    {
+    public:
+        explicit LogSegmentReader(const std::string& path);
+
+        inline operator bool() const { return _data != nullptr; }
+        inline const std::string& path() const { return _path; }
+        inline bool isIndexed() const { return static_cast<bool>(_index); }
+        inline bool isCompressed() const { return _blocks != nullptr; }
+        inline const LogSegmentIndex& index() const { return _index; }
+
+        // Restarts reading with the filter. With a sidecar index, only the blocks that can match are visited.
+        void seek(const LogQueryFilter& filter);
+        // Next record matching the filter. Returns false at the end of the segment.
+        bool next(LogRecord& record);
+
+    private:
+        void openCompressed();
+        void setRange(size_t range);
+        void load(size_t offset, size_t end);
+
+        std::string _path;
+        MemoryMappedFile _file;
+        LogSegmentIndex _index;
+
+        // bytes of the original segment
+        const char* _data{ nullptr };
+        size_t _size{ 0 };
+
+        // compressed segment only
+        const LogCompressedBlock* _blocks{ nullptr };
+        size_t _block_count{ 0 };
+        std::vector<char> _raw;
+        std::vector<bool> _is_loaded;
+
+        LogQueryFilter _filter;
+        std::vector<LogSegmentIndex::Range> _ranges;
+        size_t _range{ 0 };
+        size_t _offset{ 0 };
+        size_t _end{ 0 };
+    };
+
+    // Reads the segment a LogPool is still writing.
+    // The file can be cut down to its used size at any time by rotation, which would make a mapping fault,
+    // so it is read with plain file I/O and records are handed out from an internal buffer.
+    class LogSegmentFollower
+    {
+    public:
+        explicit LogSegmentFollower(const std::string& path);
+        ~LogSegmentFollower();
+
+        LogSegmentFollower(const LogSegmentFollower&) = delete;
+        LogSegmentFollower& operator=(const LogSegmentFollower&) = delete;
+
+        inline operator bool() const { return _file != nullptr; }
+        inline const std::string& path() const { return _path; }
+        // end of the last complete record read
+        inline size_t offset() const { return _offset; }
+
+        // Next complete record written so far. Returns false when the writer has not gone further yet.
+        // The record is valid until the next call.
+        bool next(LogRecord& record);
+
+    private:
+        bool fill();
+
+        std::string _path;
+        FILE* _file{ nullptr };
+        size_t _offset{ 0 };
+
+        std::vector<char> _buffer;
+        size_t _begin{ 0 };
+        size_t _end{ 0 };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_READER__
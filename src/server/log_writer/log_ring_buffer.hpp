@@ -0,0 +1,222 @@
+#ifndef __BN3MONKEY_LOG_RING_BUFFER__
+#define __BN3MONKEY_LOG_RING_BUFFER__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Bn3Monkey
+{
+    // What a producer does when the ring buffer is full
+    enum class OverflowPolicy : uint8_t
+    {
+        // wait until the consumer makes room
+        BLOCK,
+        // drop the item being pushed
+        DROP_NEWEST,
+        // drop the oldest queued item to make room
+        DROP_OLDEST,
+    };
+
+    // Bounded multi-producer ring buffer (Vyukov's sequence-per-cell queue).
+    // Pushing and popping are lock-free. The mutex and condition variables are
+    // only used to park a consumer on an empty buffer or a producer on a full one.
+    template<typename T>
+    class LogRingBuffer
+    {
+    public:
+        explicit LogRingBuffer(size_t capacity, OverflowPolicy policy = OverflowPolicy::BLOCK) : _policy(policy)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+
+            _mask = size - 1;
+            _cells.reset(new Cell[size]);
+            for (size_t i = 0; i < size; i++)
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        LogRingBuffer(const LogRingBuffer&) = delete;
+        LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+        // Returns false if the item was dropped or the buffer is closed
+        bool push(const T& item)
+        {
+            while (!_is_closed.load(std::memory_order_relaxed)) {
+                if (tryPush(item)) {
+                    wakeConsumer();
+                    return true;
+                }
+
+                switch (_policy) {
+                case OverflowPolicy::DROP_NEWEST:
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case OverflowPolicy::DROP_OLDEST: {
+                    T discarded;
+                    if (tryPop(discarded))
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+                case OverflowPolicy::BLOCK:
+                    waitNotFull();
+                    break;
+                }
+            }
+            return false;
+        }
+
+        // Non-blocking pop
+        bool pop(T& item)
+        {
+            if (!tryPop(item))
+                return false;
+            wakeProducer();
+            return true;
+        }
+
+        // Pops an item, waiting up to timeout for one to arrive
+        template<class Rep, class Period>
+        bool pop(T& item, const std::chrono::duration<Rep, Period>& timeout)
+        {
+            if (pop(item))
+                return true;
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _waiting_consumers.fetch_add(1, std::memory_order_seq_cst);
+                if (isEmpty() && !_is_closed.load(std::memory_order_relaxed))
+                    _not_empty.wait_for(lock, timeout);
+                _waiting_consumers.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return pop(item);
+        }
+
+        // Wakes every waiter. Pushes fail afterwards, queued items can still be popped.
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _is_closed.store(true);
+            _not_empty.notify_all();
+            _not_full.notify_all();
+        }
+
+        inline size_t capacity() const { return _mask + 1; }
+        inline size_t size() const {
+            size_t enqueue_pos = _enqueue_pos.load(std::memory_order_relaxed);
+            size_t dequeue_pos = _dequeue_pos.load(std::memory_order_relaxed);
+            return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+        }
+        inline uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        bool tryPush(const T& item)
+        {
+            size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = _cells[pos & _mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.data = item;
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = _enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool tryPop(T& item)
+        {
+            size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = _cells[pos & _mask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        item = cell.data;
+                        cell.sequence.store(pos + _mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    return false;
+                }
+                else {
+                    pos = _dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        inline bool isEmpty() const {
+            size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+            return _cells[pos & _mask].sequence.load(std::memory_order_acquire) != pos + 1;
+        }
+        inline bool isFull() const {
+            size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+            return _cells[pos & _mask].sequence.load(std::memory_order_acquire) != pos;
+        }
+
+        void waitNotFull()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _waiting_producers.fetch_add(1, std::memory_order_seq_cst);
+            if (isFull() && !_is_closed.load(std::memory_order_relaxed))
+                _not_full.wait_for(lock, std::chrono::milliseconds(10));
+            _waiting_producers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        inline void wakeConsumer()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_waiting_consumers.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _not_empty.notify_one();
+            }
+        }
+        inline void wakeProducer()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_waiting_producers.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _not_full.notify_all();
+            }
+        }
+
+        OverflowPolicy _policy;
+        std::unique_ptr<Cell[]> _cells;
+        size_t _mask{ 0 };
+
+        alignas(64) std::atomic<size_t> _enqueue_pos{ 0 };
+        alignas(64) std::atomic<size_t> _dequeue_pos{ 0 };
+
+        alignas(64) std::atomic<int32_t> _waiting_consumers{ 0 };
+        std::atomic<int32_t> _waiting_producers{ 0 };
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<bool> _is_closed{ false };
+
+        std::mutex _mutex;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_RING_BUFFER__
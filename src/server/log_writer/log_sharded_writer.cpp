@@ -0,0 +1,125 @@
+#include "log_sharded_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace Bn3Monkey;
+
+static std::atomic<uint64_t> next_sharded_writer_id{ 1 };
+
+static inline uint64_t hash(const char* data, size_t size)
+{
+	// FNV-1a
+	uint64_t ret = 14695981039346656037ull;
+	for (size_t i = 0; i < size && data[i] != '\0'; i++) {
+		ret ^= static_cast<uint8_t>(data[i]);
+		ret *= 1099511628211ull;
+	}
+	return ret;
+}
+
+Bn3Monkey::LogShardedWriter::LogShardedWriter(const LogShardConfiguration& shard_configuration, const LogPoolConfiguration& pool_configuration,
+	const LogWriterConfiguration& writer_configuration) :
+	_key(shard_configuration.key),
+	_id(next_sharded_writer_id.fetch_add(1))
+{
+	size_t shard_count = shard_configuration.shard_count == 0 ? 1 : shard_configuration.shard_count;
+	if (shard_count == 1) {
+		_shards.emplace_back(new Shard(pool_configuration, writer_configuration));
+		_is_initialized = _shards.back()->pool;
+		return;
+	}
+
+	_is_initialized = true;
+	for (size_t i = 0; i < shard_count; i++) {
+		LogPoolConfiguration configuration = pool_configuration;
+		configuration.directory = getShardDirectory(pool_configuration.directory, i);
+
+		std::error_code error;
+		std::filesystem::create_directories(configuration.directory, error);
+		if (error)
+			printf("[[SYSTEM]] Cannot create %s (%s)\n", configuration.directory.c_str(), error.message().c_str());
+
+		_shards.emplace_back(new Shard(configuration, writer_configuration));
+		_is_initialized = _is_initialized && _shards.back()->pool;
+	}
+}
+
+bool Bn3Monkey::LogShardedWriter::write(const LogLine& line)
+{
+	return _shards[getShardIndex(line.header)]->writer.write(line);
+}
+
+LogLine* Bn3Monkey::LogShardedWriter::reserve(const LogHeader& header, size_t& shard)
+{
+	shard = getShardIndex(header);
+	return _shards[shard]->writer.reserve();
+}
+
+size_t Bn3Monkey::LogShardedWriter::pending()
+{
+	size_t ret = 0;
+	for (auto& shard : _shards)
+		ret += shard->writer.pending();
+	return ret;
+}
+
+uint64_t Bn3Monkey::LogShardedWriter::dropped() const
+{
+	uint64_t ret = 0;
+	for (auto& shard : _shards)
+		ret += shard->writer.dropped();
+	return ret;
+}
+
+std::string Bn3Monkey::LogShardedWriter::getShardDirectory(const std::string& directory, size_t index)
+{
+	char name[32]{ 0 };
+	snprintf(name, sizeof(name), "shard_%02zu", index);
+
+	if (directory.empty())
+		return name;
+	if (directory.back() == '/')
+		return directory + name;
+	return directory + "/" + name;
+}
+
+size_t Bn3Monkey::LogShardedWriter::getShardIndex(const LogHeader& header)
+{
+	if (_shards.size() == 1)
+		return 0;
+
+	switch (_key) {
+	case LogShardKey::TAG:
+		return hash(header.tag, LogHeader::TAG_SIZE) % _shards.size();
+	case LogShardKey::SIGNATURE:
+		return hash(header.signature, LogHeader::SIGNATURE_SIZE) % _shards.size();
+	case LogShardKey::CONNECTION:
+	default:
+		break;
+	}
+
+	// 받는 스레드마다 처음 쓸 때 돌아가면서 shard를 정해 둔다.
+	// 스레드가 여러 writer에 쓰더라도 writer마다 같은 shard를 유지한다.
+	struct LocalShard {
+		uint64_t id;
+		size_t index;
+		std::weak_ptr<char> lifetime;
+	};
+	thread_local std::vector<LocalShard> local;
+
+	for (auto& entry : local) {
+		if (entry.id == _id)
+			return entry.index;
+	}
+
+	// 없어진 writer의 항목은 여기서 지운다
+	local.erase(std::remove_if(local.begin(), local.end(),
+		[](const LocalShard& entry) { return entry.lifetime.expired(); }),
+		local.end());
+
+	size_t index = _next_thread_shard.fetch_add(1, std::memory_order_relaxed) % _shards.size();
+	local.push_back(LocalShard{ _id, index, _lifetime });
+	return index;
+}
@@ -0,0 +1,85 @@
+#ifndef __BN3MONKEY_LOG_SHARDED_WRITER__
+#define __BN3MONKEY_LOG_SHARDED_WRITER__
+
+#include <simple_log_protocol.hpp>
+#include "../log_pool/log_pool.hpp"
+#include "log_writer.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    enum class LogShardKey : uint8_t
+    {
+        // lines with the same tag go to the same shard
+        TAG,
+        // lines with the same signature go to the same shard
+        SIGNATURE,
+        // lines go to the shard of the thread that received them.
+        // With LogIngestion::EPOLL a connection is read by one reactor, so its lines stay in one shard in the order they were sent.
+        CONNECTION,
+    };
+
+    struct LogShardConfiguration
+    {
+        // 1 : a single pool writing into pool.directory as before
+        size_t shard_count{ 1 };
+        LogShardKey key{ LogShardKey::TAG };
+    };
+
+    // Runs shard_count independent LogPool and LogWriter pairs, so lines are encoded, written and committed
+    // by as many writer threads into as many current segments.
+    // Shard i keeps its segments in <pool.directory>/shard_NN, LogQuery merges the shards back by timestamp.
+    // Lines are only ordered within a shard, so the key decides which lines keep their relative order.
+    class LogShardedWriter
+    {
+    public:
+        LogShardedWriter(const LogShardConfiguration& shard_configuration, const LogPoolConfiguration& pool_configuration,
+            const LogWriterConfiguration& writer_configuration = LogWriterConfiguration{});
+
+        LogShardedWriter(const LogShardedWriter&) = delete;
+        LogShardedWriter& operator=(const LogShardedWriter&) = delete;
+
+        inline operator bool() const { return _is_initialized; }
+        inline size_t size() const { return _shards.size(); }
+
+        // Called from socket workers. Returns false if the line was dropped.
+        bool write(const LogLine& line);
+        // Two-phase write (see LogWriter::reserve) into the shard of a line with header.
+        // The header is not copied into the slot. Pass shard to commit.
+        LogLine* reserve(const LogHeader& header, size_t& shard);
+        inline void commit(size_t shard) { _shards[shard]->writer.commit(); }
+
+        size_t pending();
+        uint64_t dropped() const;
+
+        // Directory of a shard under the directory the pools were configured with
+        static std::string getShardDirectory(const std::string& directory, size_t index);
+
+    private:
+        struct Shard
+        {
+            Shard(const LogPoolConfiguration& pool_configuration, const LogWriterConfiguration& writer_configuration) :
+                pool(pool_configuration), writer(pool, writer_configuration) {}
+
+            LogPool pool;
+            LogWriter writer;
+        };
+
+        size_t getShardIndex(const LogHeader& header);
+
+        bool _is_initialized{ false };
+        LogShardKey _key;
+        uint64_t _id;
+        // expires with the writer, so that the thread_local caches of getShardIndex can drop its entry
+        std::shared_ptr<char> _lifetime{ std::make_shared<char>(0) };
+        std::atomic<size_t> _next_thread_shard{ 0 };
+        std::vector<std::unique_ptr<Shard>> _shards;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SHARDED_WRITER__
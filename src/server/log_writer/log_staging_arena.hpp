@@ -0,0 +1,95 @@
+#ifndef __BN3MONKEY_LOG_STAGING_ARENA__
+#define __BN3MONKEY_LOG_STAGING_ARENA__
+
+#include <simple_log_protocol.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Bn3Monkey
+{
+    // Single-producer single-consumer ring of LogLines owned by one socket worker.
+    // The worker fills slots in place and the writer thread drains them as contiguous runs,
+    // so a whole run can be handed to LogPool::writeBatch without an intermediate copy.
+    class LogStagingArena
+    {
+    public:
+        explicit LogStagingArena(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            _mask = size - 1;
+            _lines.reset(new LogLine[size]);
+        }
+
+        LogStagingArena(const LogStagingArena&) = delete;
+        LogStagingArena& operator=(const LogStagingArena&) = delete;
+
+        // Producer : next free slot, or nullptr if the writer has not caught up yet.
+        inline LogLine* reserve()
+        {
+            if (_tail - _head.load(std::memory_order_acquire) > _mask)
+                return nullptr;
+            return &_lines[_tail & _mask];
+        }
+        // Producer : makes the reserved slot visible to the writer.
+        // Returns the number of lines staged since the last call that returned non-zero
+        // once it reaches batch_lines, so the caller knows when to wake the writer.
+        inline size_t commit(size_t batch_lines)
+        {
+            _tail += 1;
+            _staged.store(_tail, std::memory_order_release);
+
+            size_t unannounced = _tail - _announced;
+            if (unannounced < batch_lines)
+                return 0;
+            _announced = _tail;
+            return unannounced;
+        }
+
+        // Consumer : the oldest contiguous run of staged lines
+        inline const LogLine* peek(size_t& count) const
+        {
+            size_t head = _head.load(std::memory_order_relaxed);
+            size_t staged = _staged.load(std::memory_order_acquire);
+            size_t begin = head & _mask;
+            size_t contiguous = _mask + 1 - begin;
+
+            count = staged - head;
+            if (count > contiguous)
+                count = contiguous;
+            return &_lines[begin];
+        }
+        // Consumer : releases count lines returned by peek
+        inline void consume(size_t count)
+        {
+            _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        inline size_t pending() const {
+            return _staged.load(std::memory_order_relaxed) - _head.load(std::memory_order_relaxed);
+        }
+
+        // Either side is gone : the producer thread exited or the writer was destroyed.
+        // The producer detaches after its last commit, so a detached arena without pending lines can be freed.
+        inline void detach() { _is_detached.store(true, std::memory_order_release); }
+        inline bool isDetached() const { return _is_detached.load(std::memory_order_acquire); }
+
+    private:
+        std::unique_ptr<LogLine[]> _lines;
+        size_t _mask{ 0 };
+
+        // producer only
+        alignas(64) size_t _tail{ 0 };
+        size_t _announced{ 0 };
+        // written by the producer, read by the consumer
+        alignas(64) std::atomic<size_t> _staged{ 0 };
+        // written by the consumer, read by the producer
+        alignas(64) std::atomic<size_t> _head{ 0 };
+        std::atomic<bool> _is_detached{ false };
+    };
+}
+
+#endif // __BN3MONKEY_LOG_STAGING_ARENA__
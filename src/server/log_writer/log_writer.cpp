@@ -0,0 +1,200 @@
+#include "log_writer.hpp"
+#include "../log_metrics/log_metrics.hpp"
+
+#include <algorithm>
+
+using namespace Bn3Monkey;
+
+static std::atomic<uint64_t> next_writer_id{ 1 };
+
+Bn3Monkey::LogWriter::LogWriter(LogPool& pool, const LogWriterConfiguration& configuration) :
+	_pool(pool),
+	_configuration(configuration),
+	_id(next_writer_id.fetch_add(1))
+{
+	if (_configuration.batch_lines == 0)
+		_configuration.batch_lines = 1;
+	if (_configuration.arena_capacity < _configuration.batch_lines)
+		_configuration.arena_capacity = _configuration.batch_lines;
+
+	_thread = std::thread{ [&]() { run(); } };
+}
+
+Bn3Monkey::LogWriter::~LogWriter()
+{
+	_is_running = false;
+	wake();
+	if (_thread.joinable())
+		_thread.join();
+
+	// 워커 스레드의 캐시가 다음에 정리할 수 있도록 표시한다
+	std::lock_guard<std::mutex> lock(_arena_mutex);
+	for (auto& arena : _arenas)
+		arena->detach();
+}
+
+bool Bn3Monkey::LogWriter::write(const LogLine& line)
+{
+	LogLine* slot = reserve();
+	if (!slot)
+		return false;
+
+	memcpy(slot, &line, sizeof(LogLine));
+	commit();
+	return true;
+}
+
+LogLine* Bn3Monkey::LogWriter::reserve()
+{
+	auto* arena = getLocalArena();
+
+	LogLine* slot = arena->reserve();
+	while (!slot) {
+		if (_configuration.policy != OverflowPolicy::BLOCK || !_is_running) {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			LogMetrics::add(LogMetrics::Counter::LINES_DROPPED);
+			return nullptr;
+		}
+		wake();
+		std::this_thread::yield();
+		slot = arena->reserve();
+	}
+	return slot;
+}
+
+void Bn3Monkey::LogWriter::commit()
+{
+	if (getLocalArena()->commit(_configuration.batch_lines) > 0)
+		wake();
+}
+
+size_t Bn3Monkey::LogWriter::pending()
+{
+	std::lock_guard<std::mutex> lock(_arena_mutex);
+	size_t ret = 0;
+	for (auto& arena : _arenas)
+		ret += arena->pending();
+	return ret;
+}
+
+LogStagingArena* Bn3Monkey::LogWriter::getLocalArena()
+{
+	// 워커 스레드마다 writer별로 하나의 arena를 가진다.
+	// 스레드가 끝나면 arena를 detach해서 writer가 남은 로그를 쓰고 해제하게 한다.
+	struct LocalArenas {
+		std::vector<std::pair<uint64_t, std::shared_ptr<LogStagingArena>>> entries;
+		~LocalArenas() {
+			for (auto& entry : entries)
+				entry.second->detach();
+		}
+	};
+	thread_local LocalArenas local;
+
+	for (auto& entry : local.entries) {
+		if (entry.first == _id)
+			return entry.second.get();
+	}
+
+	// 없어진 writer의 arena는 여기서 놓는다
+	local.entries.erase(std::remove_if(local.entries.begin(), local.entries.end(),
+		[](const std::pair<uint64_t, std::shared_ptr<LogStagingArena>>& entry) { return entry.second->isDetached(); }),
+		local.entries.end());
+
+	std::shared_ptr<LogStagingArena> arena{ new LogStagingArena(_configuration.arena_capacity) };
+	{
+		std::lock_guard<std::mutex> lock(_arena_mutex);
+		_arenas.push_back(arena);
+		_arena_generation.fetch_add(1, std::memory_order_release);
+	}
+	local.entries.emplace_back(_id, arena);
+	return arena.get();
+}
+
+void Bn3Monkey::LogWriter::wake()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_is_woken = true;
+	_cv.notify_one();
+}
+
+void Bn3Monkey::LogWriter::run()
+{
+	std::vector<LogStagingArena*> arenas;
+	uint64_t generation = 0;
+
+	while (_is_running) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (!_is_woken)
+				_cv.wait_for(lock, _configuration.batch_interval);
+			_is_woken = false;
+		}
+
+		if (generation != _arena_generation.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock(_arena_mutex);
+			generation = _arena_generation.load(std::memory_order_relaxed);
+			arenas.clear();
+			for (auto& arena : _arenas)
+				arenas.push_back(arena.get());
+		}
+
+		while (drain(arenas));
+		collect(arenas);
+	}
+
+	// 종료 전에 arena에 남은 로그를 모두 기록한다
+	{
+		std::lock_guard<std::mutex> lock(_arena_mutex);
+		arenas.clear();
+		for (auto& arena : _arenas)
+			arenas.push_back(arena.get());
+	}
+	while (drain(arenas));
+}
+
+void Bn3Monkey::LogWriter::collect(std::vector<LogStagingArena*>& arenas)
+{
+	// 끝난 스레드의 arena는 다 쓴 뒤에 해제한다
+	bool has_detached = false;
+	for (auto* arena : arenas) {
+		if (arena->isDetached() && arena->pending() == 0) {
+			has_detached = true;
+			break;
+		}
+	}
+	if (!has_detached)
+		return;
+
+	std::lock_guard<std::mutex> lock(_arena_mutex);
+	_arenas.erase(std::remove_if(_arenas.begin(), _arenas.end(),
+		[](const std::shared_ptr<LogStagingArena>& arena) { return arena->isDetached() && arena->pending() == 0; }),
+		_arenas.end());
+	_arena_generation.fetch_add(1, std::memory_order_relaxed);
+
+	arenas.clear();
+	for (auto& arena : _arenas)
+		arenas.push_back(arena.get());
+}
+
+bool Bn3Monkey::LogWriter::drain(const std::vector<LogStagingArena*>& arenas)
+{
+	bool has_written = false;
+	for (auto* arena : arenas) {
+		size_t count = 0;
+		const LogLine* lines = arena->peek(count);
+		if (count > 0) {
+			uint64_t begin = LogMetrics::now();
+			size_t written = _pool.writeBatch(lines, count);
+			LogMetrics::record(LogMetrics::Histogram::BATCH_WRITE, LogMetrics::now() - begin);
+			LogMetrics::add(LogMetrics::Counter::LINES_WRITTEN, written);
+			// 세그먼트를 열지 못해 쓰지 못한 줄은 버린다
+			if (written < count)
+				LogMetrics::add(LogMetrics::Counter::LINES_DROPPED, count - written);
+			if (_configuration.on_written && written > 0)
+				_configuration.on_written(lines, written);
+			arena->consume(count);
+			has_written = true;
+		}
+	}
+	return has_written;
+}
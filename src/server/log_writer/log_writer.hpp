@@ -0,0 +1,86 @@
+#ifndef __BN3MONKEY_LOG_WRITER__
+#define __BN3MONKEY_LOG_WRITER__
+
+#include <simple_log_protocol.hpp>
+#include "../log_pool/log_pool.hpp"
+#include "log_ring_buffer.hpp"
+#include "log_staging_arena.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    struct LogWriterConfiguration
+    {
+        // lines a worker can stage before it has to wait for the writer (BLOCK) or drop (DROP_*)
+        size_t arena_capacity{ 2048 };
+        // a worker wakes the writer up every batch_lines lines
+        size_t batch_lines{ 256 };
+        // partial batches are picked up by the writer at least this often
+        std::chrono::microseconds batch_interval{ 1000 };
+        // staged lines cannot be taken back from the writer, so DROP_OLDEST behaves like DROP_NEWEST
+        OverflowPolicy policy{ OverflowPolicy::BLOCK };
+        // called on the writer thread after each batch was handed to the pool
+        std::function<void(const LogLine* lines, size_t count)> on_written;
+    };
+
+    // Moves LogPool writes off the socket workers.
+    // Every worker thread stages lines into its own LogStagingArena and a single writer thread
+    // drains the arenas into the LogPool in batches, so the pool is only ever touched by that thread.
+    class LogWriter
+    {
+    public:
+        LogWriter(LogPool& pool, const LogWriterConfiguration& configuration = LogWriterConfiguration{});
+        ~LogWriter();
+
+        LogWriter(const LogWriter&) = delete;
+        LogWriter& operator=(const LogWriter&) = delete;
+
+        // Called from socket workers. Returns false if the line was dropped.
+        bool write(const LogLine& line);
+        // Two-phase write for callers that build the line themselves :
+        // the next slot of the arena of this thread is filled in place and staged by commit(),
+        // so the line is not built elsewhere and copied in. nullptr if the line is dropped.
+        // The slot keeps what a previous line left in it, content has to be NUL-terminated.
+        LogLine* reserve();
+        // Stages the line of the last reserve() of this thread.
+        // The line stays readable by this thread until its next reserve().
+        void commit();
+
+        size_t pending();
+        inline uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        LogStagingArena* getLocalArena();
+        void wake();
+        void run();
+        bool drain(const std::vector<LogStagingArena*>& arenas);
+        void collect(std::vector<LogStagingArena*>& arenas);
+
+        LogPool& _pool;
+        LogWriterConfiguration _configuration;
+        uint64_t _id;
+
+        std::mutex _arena_mutex;
+        // shared with the thread_local caches of the workers, see getLocalArena
+        std::vector<std::shared_ptr<LogStagingArena>> _arenas;
+        std::atomic<uint64_t> _arena_generation{ 0 };
+
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        bool _is_woken{ false };
+
+        std::atomic<uint64_t> _dropped{ 0 };
+        std::atomic<bool> _is_running{ true };
+        std::thread _thread;
+    };
+}
+
+#endif // __BN3MONKEY_LOG_WRITER__
@@ -2,6 +2,7 @@
 #define __BN3MONKEY_MEMORY_MAPPED_FILE__
 
 #include <cstdint>
+#include <cstddef>
 
 namespace Bn3Monkey
 {
@@ -16,16 +17,38 @@ namespace Bn3Monkey
             FILE_SIZE_IS_ZERO = -0x1002,
             CREATED_FILE_NEED_NON_ZERO_SIZE = -0x1003,
             CANNOT_MAP_FILE = -0x1004,
+            FILE_ALREADY_EXISTS = -0x1005,
+            CANNOT_WRITE_FILE = -0x1006,
+        };
+        enum class Sync : uint8_t
+        {
+            // returns once the range is written to the storage
+            SYNCHRONOUS,
+            // schedules write-back of the range and returns immediately
+            ASYNCHRONOUS
         };
         enum class Access : uint8_t
         {
             READONLY,
             READWRITE_WITH_CREATE,
-            READWRITE_WITH_OPEN
+            READWRITE_WITH_OPEN,
+            // fails with FILE_ALREADY_EXISTS instead of reusing an existing file
+            READWRITE_WITH_CREATE_NEW
+        };
+        // Optional work done while opening, so that the first writes do not pay for it
+        enum Hint : uint32_t
+        {
+            HINT_NONE = 0,
+            // reserve the blocks of the file up front (fallocate)
+            HINT_PREALLOCATE = 1 << 0,
+            // fault every page of the mapping in (MAP_POPULATE, madvise(MADV_WILLNEED))
+            HINT_POPULATE = 1 << 1,
+            // the mapping is read front to back, so read-ahead can be aggressive (madvise(MADV_SEQUENTIAL))
+            HINT_SEQUENTIAL = 1 << 2,
         };
 
         MemoryMappedFile() noexcept = default;
-        MemoryMappedFile(const char* path, Access access, size_t size) noexcept;
+        MemoryMappedFile(const char* path, Access access, size_t size, uint32_t hints = HINT_NONE) noexcept;
 
         MemoryMappedFile(const MemoryMappedFile&) = delete;
         MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
@@ -39,7 +62,13 @@ namespace Bn3Monkey
         inline Code error() const { return _code; }
 
         void commitAll();
-        void commit(size_t offset, size_t length);
+        // Returns false if the range could not be written back
+        bool commit(size_t offset, size_t length, Sync sync = Sync::SYNCHRONOUS);
+        // Unmaps the file and cuts it down to used_size bytes
+        void release(size_t used_size);
+
+        // Granularity of commit addresses
+        static size_t getPageSize() noexcept;
 
         inline char* data() noexcept { return _data; }
         inline const char* data() const noexcept { return _data; }
@@ -47,12 +76,12 @@ namespace Bn3Monkey
 
     private:
 
-        void open(const char* path, Access access, size_t size);
+        void open(const char* path, Access access, size_t size, uint32_t hints);
         void close();
 
         Code _code{ Code::CLOSED };
         char* _data{ nullptr };
-        size_t _size;
+        size_t _size{ 0 };
 
 #if defined(_WIN32)
         void* _handle{ nullptr };
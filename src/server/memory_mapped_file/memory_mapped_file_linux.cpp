@@ -6,14 +6,15 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cerrno>
 
 using namespace Bn3Monkey;
 
-MemoryMappedFile::MemoryMappedFile(const char* path, Access access, size_t size)
+MemoryMappedFile::MemoryMappedFile(const char* path, Access access, size_t size, uint32_t hints) noexcept
 {
-	open(path, access, size);
+	open(path, access, size, hints);
 }
-MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other)
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
 {
 	close();
 
@@ -55,16 +56,33 @@ MemoryMappedFile::~MemoryMappedFile()
 	close();
 }
 
+size_t MemoryMappedFile::getPageSize() noexcept
+{
+	static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return page_size;
+}
+
 void MemoryMappedFile::commitAll()
 {
 	msync(_data, _size, MS_SYNC);
 }
-void MemoryMappedFile::commit(size_t offset, size_t size)
+bool MemoryMappedFile::commit(size_t offset, size_t size, Sync sync)
 {
-	msync(_data + offset, size, MS_SYNC);
+	return msync(_data + offset, size, sync == Sync::SYNCHRONOUS ? MS_SYNC : MS_ASYNC) == 0;
+}
+void MemoryMappedFile::release(size_t used_size)
+{
+	if (_data) {
+		munmap(_data, _size);
+		_data = nullptr;
+	}
+	if (_handle >= 0 && used_size < _size) {
+		ftruncate(_handle, static_cast<off_t>(used_size));
+	}
+	close();
 }
 
-void MemoryMappedFile::open(const char* path, Access access, size_t size)
+void MemoryMappedFile::open(const char* path, Access access, size_t size, uint32_t hints)
 {
 
 	do {
@@ -72,11 +90,13 @@ void MemoryMappedFile::open(const char* path, Access access, size_t size)
 		
 		int flags = access != Access::READONLY ? O_RDWR : O_RDONLY;
 		if (access == Access::READWRITE_WITH_CREATE)
-			flags != O_CREAT;
+			flags |= O_CREAT;
+		else if (access == Access::READWRITE_WITH_CREATE_NEW)
+			flags |= O_CREAT | O_EXCL;
 
-		_handle = ::open(path.c_str(), flags, 0644);
-		if (_handle < 0)
-			_code = Code::CANNOT_OPEN_FILE;
+		_handle = ::open(path, flags, 0644);
+		if (_handle < 0) {
+			_code = errno == EEXIST ? Code::FILE_ALREADY_EXISTS : Code::CANNOT_OPEN_FILE;
 			break;
 		}
 
@@ -86,7 +106,14 @@ void MemoryMappedFile::open(const char* path, Access access, size_t size)
 
 		if (access != Access::READONLY) {
 			if (size > 0) {
-				ftruncate(_fd, size);
+				if (ftruncate(_handle, static_cast<off_t>(size)) != 0) {
+					_code = Code::CANNOT_OPEN_FILE;
+					break;
+				}
+				if (hints & HINT_PREALLOCATE) {
+					// 실패해도 sparse file로 계속 쓸 수 있다
+					posix_fallocate(_handle, 0, static_cast<off_t>(size));
+				}
 				st.st_size = size;
 			}
 			else {
@@ -95,24 +122,36 @@ void MemoryMappedFile::open(const char* path, Access access, size_t size)
 			}
 		}
 
-		if (__size.QuadPart == 0)
+		if (st.st_size == 0)
 		{
 			_code = Code::FILE_SIZE_IS_ZERO;
 			break;
 		}
 
-		int prot = access != Access::READONLY;
-		_data = mmap(nullptr, st.st_size, prot, MAP_SHARED, _handle, 0);
-		if (_data == MAP_FAILED) {
+		int prot = access != Access::READONLY ? (PROT_READ | PROT_WRITE) : PROT_READ;
+		int map_flags = MAP_SHARED;
+		if (hints & HINT_POPULATE)
+			map_flags |= MAP_POPULATE;
+		void* data = mmap(nullptr, st.st_size, prot, map_flags, _handle, 0);
+		if (data == MAP_FAILED) {
 			_code = Code::CANNOT_MAP_FILE;
+			break;
 		}
+		if (hints & HINT_POPULATE)
+			madvise(data, st.st_size, MADV_WILLNEED);
+		if (hints & HINT_SEQUENTIAL)
+			madvise(data, st.st_size, MADV_SEQUENTIAL);
 
+		_data = static_cast<char*>(data);
 		_size = static_cast<size_t>(st.st_size);
 
 	} while (false);
 
 	if (_code != Code::SUCCESS) {
+		// 실패 원인은 close() 후에도 error()로 남긴다
+		Code code = _code;
 		close();
+		_code = code;
 	}
 }
 void MemoryMappedFile::close()
@@ -122,11 +161,11 @@ void MemoryMappedFile::close()
 		_data = nullptr;
 	}
 	if (_handle >= 0) {
-		close(_handle);
+		::close(_handle);
 		_handle = -1;
 	}
 	_code = Code::CLOSED;
 	_size = 0;
 }
 
-#endif // __linux__
\ No newline at end of file
+#endif // __linux__
@@ -6,9 +6,9 @@
 
 using namespace Bn3Monkey;
 
-MemoryMappedFile::MemoryMappedFile(const char* path, Access access, size_t size) noexcept
+MemoryMappedFile::MemoryMappedFile(const char* path, Access access, size_t size, uint32_t hints) noexcept
 {
-	open(path, access, size);
+	open(path, access, size, hints);
 }
 MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
 {
@@ -59,29 +59,71 @@ MemoryMappedFile::~MemoryMappedFile()
 	close();
 }
 
+size_t MemoryMappedFile::getPageSize() noexcept
+{
+	static const size_t page_size = []() {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return static_cast<size_t>(info.dwPageSize);
+	}();
+	return page_size;
+}
+
 void MemoryMappedFile::commitAll()
 {
 	FlushViewOfFile(_data, _size);
 	FlushFileBuffers((HANDLE)_handle);
 }
-void MemoryMappedFile::commit(size_t offset, size_t size)
+bool MemoryMappedFile::commit(size_t offset, size_t size, Sync sync)
 {
-	FlushViewOfFile(_data + offset, size);
-	FlushFileBuffers((HANDLE)_handle);
+	// FlushViewOfFile only starts the write-back. FlushFileBuffers waits for it.
+	if (!FlushViewOfFile(_data + offset, size))
+		return false;
+	if (sync == Sync::SYNCHRONOUS)
+		return FlushFileBuffers((HANDLE)_handle) != 0;
+	return true;
 }
 
-void MemoryMappedFile::open(const char* path, Access access, size_t size)
+void MemoryMappedFile::release(size_t used_size)
+{
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+		_data = nullptr;
+	}
+	if (_mapping != nullptr) {
+		CloseHandle(_mapping);
+		_mapping = nullptr;
+	}
+	if (_handle != nullptr && used_size < _size) {
+		LARGE_INTEGER __size{};
+		__size.QuadPart = used_size;
+		SetFilePointerEx(_handle, __size, nullptr, FILE_BEGIN);
+		SetEndOfFile(_handle);
+	}
+	close();
+}
+
+void MemoryMappedFile::open(const char* path, Access access, size_t size, uint32_t hints)
 {
 
 	do {
 		_code = Code::SUCCESS;
 		DWORD _access = access == Access::READONLY ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE);
-		DWORD _create = access == Access::READWRITE_WITH_CREATE ? OPEN_ALWAYS : OPEN_EXISTING;
+		DWORD _create = OPEN_EXISTING;
+		if (access == Access::READWRITE_WITH_CREATE)
+			_create = OPEN_ALWAYS;
+		else if (access == Access::READWRITE_WITH_CREATE_NEW)
+			_create = CREATE_NEW;
+
+		DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+		if (hints & HINT_SEQUENTIAL)
+			attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
 
-		_handle = CreateFileA(path, _access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, _create, FILE_ATTRIBUTE_NORMAL, nullptr);
+		_handle = CreateFileA(path, _access, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, _create, attributes, nullptr);
 		if (_handle == INVALID_HANDLE_VALUE)
 		{
-			_code = Code::CANNOT_OPEN_FILE;
+			_handle = nullptr;
+			_code = GetLastError() == ERROR_FILE_EXISTS ? Code::FILE_ALREADY_EXISTS : Code::CANNOT_OPEN_FILE;
 			break;
 		}
 
@@ -120,10 +162,22 @@ void MemoryMappedFile::open(const char* path, Access access, size_t size)
 		}
 		_size = __size.QuadPart;
 
+		if (hints & HINT_POPULATE) {
+			// SetEndOfFile already allocates the blocks, so only the pages need to be faulted in
+			const size_t page_size = getPageSize();
+			volatile char sink = 0;
+			for (size_t offset = 0; offset < _size; offset += page_size)
+				sink = _data[offset];
+			(void)sink;
+		}
+
 	} while (false);
 
 	if (_code != Code::SUCCESS) {
+		// 실패 원인은 close() 후에도 error()로 남긴다
+		Code code = _code;
 		close();
+		_code = code;
 	}
 }
 void MemoryMappedFile::close()
@@ -1,109 +1,43 @@
 ﻿#include "simple_log_server.hpp"
 #include <string>
-#include <algorithm>
 
 using namespace Bn3Monkey;
 
-Bn3Monkey::LogPool::LogPool(size_t max_line_per_files, size_t interval_lines_of_commit) :
-	_max_line_per_files(max_line_per_files),
-	_interval_lines_of_commit(interval_lines_of_commit),
-	_prev_commit_line(0),
-	_next_commit_line(_interval_lines_of_commit),
-	_current_lines(0)
+static SimpleLogServerConfiguration createConfiguration(uint32_t port)
 {
-	_current_file = rotate();
+	SimpleLogServerConfiguration configuration;
+	configuration.port = port;
+	return configuration;
 }
 
-void Bn3Monkey::LogPool::write(const LogLine& line)
+SimpleLogServer::SimpleLogServer(uint32_t port) : SimpleLogServer(createConfiguration(port))
 {
-	_current_lines = append(_current_file, line, _current_lines);
-	synchronize(_current_file, _current_lines);
-	if (!hasCapacity()) {
-		_current_file = rotate();
-	}
-}
-
-size_t Bn3Monkey::LogPool::append(MemoryMappedFile& file, const LogLine& line, size_t current_lines)
-{
-	char* data = file.data();
-	char* dest = data + current_lines * sizeof(LogLine);
-	memcpy(dest, reinterpret_cast<const char*>(&line), sizeof(LogLine));
-	dest[sizeof(LogLine) - 1] = '\n';
-
-	std::replace(dest, dest + sizeof(LogLine), static_cast<unsigned char>('\0'), static_cast<unsigned char>(' '));
-
-	return current_lines + 1;
-}
-
-void Bn3Monkey::LogPool::synchronize(MemoryMappedFile& file, size_t current_lines)
-{
-	if (current_lines == _next_commit_line) {
-		file.commit(_prev_commit_line, _next_commit_line);
-		_prev_commit_line = _next_commit_line;
-		_next_commit_line += _interval_lines_of_commit;
-	}
-}
-
-bool Bn3Monkey::LogPool::hasCapacity()
-{
-	return _current_lines < _max_line_per_files;
-}
-
-const char* Bn3Monkey::LogPool::createLogFileName()
-{
-	static char buffer[1024]{ 0 };
-	std::time_t now = std::time(nullptr);
-	std::tm tm{};
-#ifdef _WIN32
-	localtime_s(&tm, &now);
-#else
-	tm = *std::localtime(&now);
-#endif
-
-	// 파일명: log_YYYYMMDD_HHMMSS.txt
-	std::snprintf(
-		buffer,
-		sizeof(buffer),
-		"log_%04d%02d%02d_%02d%02d%02d.txt",
-		tm.tm_year + 1900,
-		tm.tm_mon + 1,
-		tm.tm_mday,
-		tm.tm_hour,
-		tm.tm_min,
-		tm.tm_sec
-	);
-
-	return buffer;
-}
-
-MemoryMappedFile Bn3Monkey::LogPool::rotate()
-{
-	auto* filename = createLogFileName();
-	
-
-	_prev_commit_line = 0;
-	_next_commit_line = _interval_lines_of_commit;
-
-	_current_lines = 0;
-	return MemoryMappedFile(filename, MemoryMappedFile::Access::READWRITE_WITH_CREATE, _max_line_per_files * sizeof(LogLine));
-
 }
 
-
-
-
-
-
-SimpleLogServer::SimpleLogServer(uint32_t port) : _port(port), _request_server{
+SimpleLogServer::SimpleLogServer(const SimpleLogServerConfiguration& configuration) :
+	_port(configuration.port),
+	_writer(configuration.shards, configuration.pool, configuration.writer),
+	_console(configuration.console),
+	_request_server{
 		Bn3Monkey::SocketConfiguration {
 			"0.0.0.0",
-			port,
+			configuration.port,
 			false
 		}
 	}
 {
 	Bn3Monkey::initializeSecuritySocket();
-	auto res = _request_server.open(&_request_handler, 4);
+	if (!configuration.metrics.file.empty() || configuration.metrics.http_port != 0) {
+		_metrics_exporter = std::make_unique<LogMetricsExporter>(configuration.metrics, [&](std::string& output) { dumpMetrics(output); });
+	}
+
+	if (configuration.ingestion == LogIngestion::EPOLL) {
+		_epoll_server = std::make_unique<LogEpollServer>(configuration.port, configuration.epoll);
+		_is_initialized = _epoll_server->open(&_request_handler, &_request_handler);
+		return;
+	}
+
+	auto res = _request_server.open(&_request_handler, configuration.worker_count);
 	_is_initialized = res.code() == Bn3Monkey::SocketCode::SUCCESS;
 	if (!_is_initialized) {
 		printf("[[SYSTEM]] Error (%s)", res.message());
@@ -113,16 +47,34 @@ SimpleLogServer::SimpleLogServer(uint32_t port) : _port(port), _request_server{
 }
 SimpleLogServer::~SimpleLogServer() {
 
-	if (_is_initialized) {
+	if (_epoll_server) {
+		_epoll_server->close();
+	}
+	else if (_is_initialized) {
 		_request_server.close();
 	}
 	Bn3Monkey::releaseSecuritySocket();
 }
 
+void SimpleLogServer::dumpMetrics(std::string& output)
+{
+	LogMetrics::render(output);
+
+	LogMetrics::renderHeader(output, "slog_writer_pending_lines", "gauge", "Lines staged for the writer threads and not written yet");
+	LogMetrics::renderValue(output, "slog_writer_pending_lines", static_cast<double>(_writer.pending()));
+	LogMetrics::renderHeader(output, "slog_shards", "gauge", "Pool shards of the server");
+	LogMetrics::renderValue(output, "slog_shards", static_cast<double>(_writer.size()));
+}
+
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
 #endif // _WIN32
 
 #include <random>
@@ -157,54 +109,58 @@ void SimpleLogServer::sendTestLog(bool is_hard_test)
 		WSAStartup(MAKEWORD(2, 2), &wsa);
 
 		SOCKET sock = socket(AF_INET, SOCK_STREAM, 0);
+#else
+		int sock = socket(AF_INET, SOCK_STREAM, 0);
+#endif // _WIN32
 
 		sockaddr_in addr{};
 		addr.sin_family = AF_INET;
 		addr.sin_port = htons(_port);  // 원하는 서버 포트
 		inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
 
-		if (connect(sock, (sockaddr*)&addr, sizeof(addr)) != 0) {
-			return;
-		}
+		if (connect(sock, (sockaddr*)&addr, sizeof(addr)) == 0) {
 
-		std::mt19937 rng{ std::random_device{}() };
+			std::mt19937 rng{ std::random_device{}() };
 
-		const int loop =
-			is_hard_test ? (1024 * 10 * 10) : 10;
+			const int loop =
+				is_hard_test ? (1024 * 10 * 10) : 10;
 
-		for (int i = 0; i < loop; ++i) {
+			for (int i = 0; i < loop; ++i) {
 
-			LogColor color = randomLogColor(rng);
+				LogColor color = randomLogColor(rng);
 
-			std::string msg =
-				"Sample LogLine Protocol Test #" + std::to_string(i);
+				std::string msg =
+					"Sample LogLine Protocol Test #" + std::to_string(i);
 
-			LogLine line(
-				"SimpleLogServer::sendTestLog",
-				"TEST",
-				color,
-				msg.c_str()
-			);
+				LogLine line(
+					"SimpleLogServer::sendTestLog",
+					"TEST",
+					color,
+					msg.c_str()
+				);
 
-			// 🔥 핵심: LogLine 전체를 그대로 전송
-			const char* raw = reinterpret_cast<const char*>(&line);
-			size_t remaining = LogLine::SIZE;
+				// 🔥 핵심: 헤더 + 실제 내용 길이만큼만 전송
+				const char* raw = reinterpret_cast<const char*>(&line);
+				size_t remaining = line.wireSize();
 
-			while (remaining > 0) {
-				int sent = send(sock, raw, (int)remaining, 0);
-				if (sent <= 0)
-					break;
-				raw += sent;
-				remaining -= sent;
-			}
+				while (remaining > 0) {
+					int sent = send(sock, raw, (int)remaining, 0);
+					if (sent <= 0)
+						break;
+					raw += sent;
+					remaining -= sent;
+				}
 
-			if (!is_hard_test)
-				Sleep(200);
+				if (!is_hard_test)
+					std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			}
 		}
 
+#ifdef _WIN32
 		closesocket(sock);
 		WSACleanup();
-
+#else
+		close(sock);
 #endif // _WIN32
 		}
 	}.join();
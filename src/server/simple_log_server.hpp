@@ -14,64 +14,20 @@
 #include <array>
 
 #include <simple_log_protocol.hpp>
-#include "memory_mapped_file/memory_mapped_file.hpp"
+#include "log_pool/log_pool.hpp"
+#include "log_writer/log_writer.hpp"
+#include "log_writer/log_sharded_writer.hpp"
+#include "log_console/log_console.hpp"
+#include "log_format/log_format_dictionary.hpp"
+#include "log_ingestion/log_epoll_server.hpp"
+#include "log_metrics/log_metrics.hpp"
+#include "log_metrics/log_metrics_exporter.hpp"
 
 namespace Bn3Monkey {
 
-    class LogPool {
+    class SimpleLogServerHandler : public Bn3Monkey::SocketRequestHandler, public LogFrameSynchronizer {
     public:
-        LogPool(size_t max_line_per_files = 4096, size_t interval_lines_of_commit = 64);
-
-        inline operator bool() const { return _is_initialized; }
-        void write(const LogLine& line);
-
-    private:
-        bool _is_initialized{ false };
-        size_t _max_line_per_files;
-        size_t _interval_lines_of_commit;
-
-        size_t _prev_commit_line;
-        size_t _next_commit_line;
-
-        size_t _current_lines;
-        MemoryMappedFile _current_file;
-
-        const char* createLogFileName();
-
-        MemoryMappedFile rotate();
-        size_t append(MemoryMappedFile& file, const LogLine& line, size_t current_lines);
-        void synchronize(MemoryMappedFile& file, size_t current_lines);
-        bool hasCapacity();
-
-    };
-
-    class LogPrinter
-    {
-        struct LogColorSetter {
-            LogColorSetter(LogColor color) {
-                const uint32_t v = static_cast<uint32_t>(color);
-                int32_t r = (v >> 16) & 0xFF;
-                int32_t g = (v >> 8) & 0xFF;
-                int32_t b = v & 0xFF;
-                printf("\x1b[38;2;%d;%d;%dm", r, g, b);
-            }
-            ~LogColorSetter() {
-                printf("\x1b[0m");
-            }
-        };
-    public:
-        static void print(const LogLine& logline) {
-            {
-                LogColorSetter color_setter{ logline.header.color };
-                printf("%s %s %s | %s\n", logline.header.date_format, logline.header.signature, logline.header.tag, logline.content);
-            }
-        }
-    };
-
-
-    class SimpleLogServerHandler : public Bn3Monkey::SocketRequestHandler {
-    public:
-        SimpleLogServerHandler(LogPool& pool) : _pool(pool) {}
+        SimpleLogServerHandler(LogShardedWriter& writer, LogConsoleSink& console) : _writer(writer), _console(console) {}
 
         // SocketRequestHandler��(��) ���� ��ӵ�
         size_t getHeaderSize() override
@@ -80,8 +36,7 @@ namespace Bn3Monkey {
         }
         size_t getPayloadSize(const char* header) override
         {
-            (void*)header;
-            return LogLine::CONTENT_SIZE;
+            return LogLine::getPayloadSize(header);
         }
         Bn3Monkey::SocketRequestMode onModeClassified(const char* header) override
         {
@@ -89,10 +44,12 @@ namespace Bn3Monkey {
         }
         void onClientConnected(const char* ip, int port) override
         {
+            LogMetrics::add(LogMetrics::Counter::CONNECTIONS_OPENED);
             printf("[[SYSTEM]] Log Client is connected : %s %d\n", ip, port);
         }
         void onClientDisconnected(const char* ip, int port) override
         {
+            LogMetrics::add(LogMetrics::Counter::CONNECTIONS_CLOSED);
             printf("[[SYSTEM]] Log Client is disconnected : %s %d\n", ip, port);
         }
         void onProcessed(const char* header, const char* input_buffer, size_t input_size, char* output_buffer, size_t* output_size) override
@@ -101,24 +58,105 @@ namespace Bn3Monkey {
         }
         void onProcessedWithoutResponse(const char* header, const char* input_buffer, size_t input_size) override
         {
+            onFrame(header, input_buffer, input_size);
+        }
+
+        // LogFrameSynchronizer (LogEpollServer only)
+        bool isFrameHeader(const char* header) override
+        {
+            return LogLine::isValid(header);
+        }
+        size_t findFrameHeader(const char* data, size_t size) override
+        {
+            return LogLine::findHeader(data, size);
+        }
+        bool onFrame(const char* header, const char* input_buffer, size_t input_size) override
+        {
+            LogMetrics::add(LogMetrics::Counter::BYTES_RECEIVED, sizeof(LogHeader) + input_size);
             if (LogLine::isValid(header))
             {
-                LogLine line{};
-                memcpy(&line.header, header, sizeof(line.header));
-                memcpy(&line.content, input_buffer, input_size);
-
-                LogPrinter::print(line);
-                _pool.write(line);
+                if (!LogLine::isIntact(header, input_buffer, input_size)) {
+                    LogMetrics::add(LogMetrics::Counter::CORRUPTED_RECORDS);
+                    return false;
+                }
+
+                LogHeader received;
+                memcpy(&received, header, sizeof(received));
+                received.upgradeLegacyTime();
+
+                if (received.flags & LogHeader::FLAG_FORMAT_DEFINITION) {
+                    LogMetrics::add(LogMetrics::Counter::FORMAT_DEFINITIONS);
+                    _formats.define(received.format_id, input_buffer, input_size);
+                    return true;
+                }
+                LogMetrics::add(LogMetrics::Counter::LINES_RECEIVED);
+                LogMetrics::addClient(received.signature, sizeof(LogHeader) + input_size);
+
+                // 스택에 LogLine을 만들어 복사하지 않고 writer의 arena 슬롯에 바로 채운다.
+                // writer가 가득 차서 버려지는 줄은 콘솔에만 보이도록 스레드별 임시 줄에 채운다.
+                size_t shard = 0;
+                LogLine* line = _writer.reserve(received, shard);
+                bool is_staged = line != nullptr;
+                if (!is_staged) {
+                    thread_local LogLine dropped;
+                    line = &dropped;
+                }
+
+                line->header = received;
+                if (received.flags & LogHeader::FLAG_FORMATTED) {
+                    _formats.expand(*line, input_buffer, input_size);
+                }
+                else {
+                    // 슬롯에는 이전 줄이 남아 있으므로 받은 만큼만 복사하고 끝을 표시한다
+                    size_t size = input_size < LogLine::CONTENT_SIZE ? input_size : LogLine::CONTENT_SIZE - 1;
+                    memcpy(line->content, input_buffer, size);
+                    line->content[size] = '\0';
+                }
+
+                if (is_staged)
+                    _writer.commit(shard);
+                _console.print(*line);
+                return true;
+            }
+            else {
+                LogMetrics::add(LogMetrics::Counter::INVALID_RECORDS);
+                return false;
             }
         }
 
     private:
-        LogPool& _pool;
+        LogShardedWriter& _writer;
+        LogConsoleSink& _console;
+        LogFormatDictionary _formats;
+    };
+
+    enum class LogIngestion
+    {
+        // SocketRequestServer with worker_count workers
+        SECURITY_SOCKET,
+        // LogEpollServer (Linux only)
+        EPOLL,
+    };
+
+    struct SimpleLogServerConfiguration
+    {
+        uint32_t port{ 13579 };
+        LogIngestion ingestion{ LogIngestion::SECURITY_SOCKET };
+        size_t worker_count{ 4 };
+        LogEpollServerConfiguration epoll;
+        // segments are written by shards.shard_count pools, each with its own writer thread
+        LogShardConfiguration shards;
+        LogPoolConfiguration pool;
+        // on_written is called on the writer thread of each shard
+        LogWriterConfiguration writer;
+        LogConsoleConfiguration console;
+        LogMetricsConfiguration metrics;
     };
 
     class SimpleLogServer {
     public:
         explicit SimpleLogServer(uint32_t port);
+        explicit SimpleLogServer(const SimpleLogServerConfiguration& configuration);
         virtual ~SimpleLogServer();
 
         inline operator bool() const {
@@ -127,15 +165,24 @@ namespace Bn3Monkey {
 
         void sendTestLog(bool is_hard_test);
 
+        inline void setConsoleEnabled(bool is_enabled) { _console.setEnabled(is_enabled); }
+        inline bool isConsoleEnabled() const { return _console.isEnabled(); }
+
+        // Appends the metrics of the process and the queue depths of this server in the Prometheus text format
+        void dumpMetrics(std::string& output);
+
     private:
         bool _is_initialized{ false };
 
         uint32_t _port;
 
-        LogPool _pool;
+        LogShardedWriter _writer;
+        LogConsoleSink _console;
 
-        SimpleLogServerHandler _request_handler{ _pool };
+        SimpleLogServerHandler _request_handler{ _writer, _console };
         Bn3Monkey::SocketRequestServer _request_server;
+        std::unique_ptr<LogEpollServer> _epoll_server;
+        std::unique_ptr<LogMetricsExporter> _metrics_exporter;
 
     };
 }
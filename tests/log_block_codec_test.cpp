@@ -0,0 +1,91 @@
+#include "simple_log_test.hpp"
+
+#include <log_pool/log_block_codec.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    bool roundTrip(const std::vector<char>& raw)
+    {
+        std::vector<char> compressed(LogBlockCodec::getCompressBound(raw.size()));
+        size_t size = LogBlockCodec::compress(raw.data(), raw.size(), compressed.data(), compressed.size());
+        if (size == 0 && !raw.empty())
+            return false;
+
+        std::vector<char> restored(raw.size() + 1, 'x');
+        if (!LogBlockCodec::decompress(compressed.data(), size, restored.data(), raw.size()))
+            return false;
+        // nothing is written past raw_size
+        return memcmp(restored.data(), raw.data(), raw.size()) == 0 && restored[raw.size()] == 'x';
+    }
+}
+
+SIMPLE_LOG_TEST(LogBlockCodec_RoundTrip)
+{
+    std::vector<char> raw;
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+
+    raw.assign(1, 'a');
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+
+    raw.assign(64 * 1024, 0);
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+
+    // records-like text : repeated prefixes with changing numbers
+    std::string text;
+    for (int i = 0; text.size() < 64 * 1024; i++)
+        text += "2026-10-17 12:00:00.000 Test::Codec INFO | request " + std::to_string(i * 7919) + " done\n";
+    raw.assign(text.begin(), text.end());
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+
+    // incompressible
+    uint32_t state = 12345;
+    raw.resize(64 * 1024);
+    for (auto& value : raw) {
+        state = state * 1103515245u + 12345u;
+        value = static_cast<char>(state >> 24);
+    }
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+
+    // matches longer than 15 + 255 and offsets up to the window
+    raw.assign(70000, 0);
+    for (size_t i = 0; i < raw.size(); i++)
+        raw[i] = static_cast<char>(i % 65536 < 300 ? 'z' : (i * 13) >> 3);
+    SIMPLE_LOG_CHECK(roundTrip(raw));
+}
+
+SIMPLE_LOG_TEST(LogBlockCodec_KnownBlock)
+{
+    // "abcd" + match (offset 4, length 12) + "efghi"
+    const char block[] = { 0x48, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x50, 'e', 'f', 'g', 'h', 'i' };
+    const char* raw = "abcdabcdabcdabcdefghi";
+    char dest[21];
+    SIMPLE_LOG_CHECK(LogBlockCodec::decompress(block, sizeof(block), dest, sizeof(dest)));
+    SIMPLE_LOG_CHECK(memcmp(dest, raw, sizeof(dest)) == 0);
+}
+
+SIMPLE_LOG_TEST(LogBlockCodec_RejectsDamagedBlock)
+{
+    std::string text;
+    for (int i = 0; i < 200; i++)
+        text += "line " + std::to_string(i) + " of the damaged block\n";
+    std::vector<char> compressed(LogBlockCodec::getCompressBound(text.size()));
+    size_t size = LogBlockCodec::compress(text.data(), text.size(), compressed.data(), compressed.size());
+    SIMPLE_LOG_CHECK(size > 0 && size < text.size());
+
+    std::vector<char> dest(text.size());
+    // cut short, or restoring to another size
+    SIMPLE_LOG_CHECK(!LogBlockCodec::decompress(compressed.data(), size / 2, dest.data(), dest.size()));
+    SIMPLE_LOG_CHECK(!LogBlockCodec::decompress(compressed.data(), size, dest.data(), dest.size() - 1));
+
+    // an offset pointing before the start
+    const char block[] = { 0x18, 'a', 0x10, 0x00, 0x50, 'e', 'f', 'g', 'h', 'i' };
+    char small[32];
+    SIMPLE_LOG_CHECK(!LogBlockCodec::decompress(block, sizeof(block), small, 1 + 12 + 5));
+}
@@ -0,0 +1,47 @@
+#include "simple_log_test.hpp"
+
+#include <simple_log_checksum.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+SIMPLE_LOG_TEST(LogChecksum_KnownValues)
+{
+    // CRC-32C check value (RFC 3720 and the CRC catalogue)
+    SIMPLE_LOG_CHECK(LogChecksum::compute("123456789", 9) == 0xE3069283u);
+    SIMPLE_LOG_CHECK(LogChecksum::computeSoftware("123456789", 9) == 0xE3069283u);
+    SIMPLE_LOG_CHECK(LogChecksum::compute("", 0) == 0);
+
+    // RFC 3720 B.4 : 32 bytes of zeros, 32 bytes of 0xFF
+    std::vector<char> data(32, 0);
+    SIMPLE_LOG_CHECK(LogChecksum::compute(data.data(), data.size()) == 0x8A9136AAu);
+    memset(data.data(), 0xFF, data.size());
+    SIMPLE_LOG_CHECK(LogChecksum::compute(data.data(), data.size()) == 0x62A8AB43u);
+}
+
+SIMPLE_LOG_TEST(LogChecksum_AcceleratedMatchesSoftware)
+{
+    std::vector<char> data(1024 + 16);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<char>(i * 31 + 7);
+
+    // every alignment and every tail length of the wide loops
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t size = 0; size <= 80; size++)
+            SIMPLE_LOG_CHECK(LogChecksum::compute(data.data() + offset, size) == LogChecksum::computeSoftware(data.data() + offset, size));
+    }
+    SIMPLE_LOG_CHECK(LogChecksum::compute(data.data(), 1024) == LogChecksum::computeSoftware(data.data(), 1024));
+}
+
+SIMPLE_LOG_TEST(LogChecksum_Continues)
+{
+    const char* text = "The quick brown fox jumps over the lazy dog";
+    size_t size = strlen(text);
+    uint32_t whole = LogChecksum::compute(text, size);
+    for (size_t split = 0; split <= size; split++) {
+        SIMPLE_LOG_CHECK(LogChecksum::compute(text + split, size - split, LogChecksum::compute(text, split)) == whole);
+        SIMPLE_LOG_CHECK(LogChecksum::computeSoftware(text + split, size - split, LogChecksum::computeSoftware(text, split)) == whole);
+    }
+}
@@ -0,0 +1,137 @@
+#include "simple_log_test.hpp"
+
+#include <log_client_queue.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    // One header for every frame, so that a frame is known from its content
+    LogHeader makeHeader(const std::string& content)
+    {
+        static const LogHeader header{ "Test::Queue", "TEST", LogColor::Green };
+        LogHeader ret = header;
+        ret.payload_size = static_cast<uint32_t>(content.size() + 1);
+        return ret;
+    }
+    // Frame as the queue holds it : header, content and its NUL
+    std::string makeFrame(const std::string& content)
+    {
+        LogHeader header = makeHeader(content);
+        std::string ret(reinterpret_cast<const char*>(&header), sizeof(LogHeader));
+        ret.append(content);
+        ret.push_back('\0');
+        return ret;
+    }
+    bool push(LogClientQueue& queue, const std::string& content)
+    {
+        return queue.push(makeHeader(content), content.data(), content.size());
+    }
+    // Staged bytes, joining the spans
+    std::string peek(const LogClientQueue& queue, size_t* span_count = nullptr)
+    {
+        const char* spans[2];
+        size_t sizes[2];
+        size_t count = queue.peek(spans, sizes);
+        if (span_count)
+            *span_count = count;
+        std::string ret;
+        for (size_t i = 0; i < count; i++)
+            ret.append(spans[i], sizes[i]);
+        return ret;
+    }
+}
+
+SIMPLE_LOG_TEST(LogClientQueue_SplitsFrameAcrossWrap)
+{
+    LogClientQueue queue{ LogLine::SIZE };
+    std::string first(500, 'a');
+    SIMPLE_LOG_CHECK(push(queue, first));
+    queue.consume(makeFrame(first).size());
+    SIMPLE_LOG_CHECK(queue.pending() == 0 && !queue.hasPartialFrame());
+
+    // 597 + 697 bytes : the second frame runs past the end of the ring
+    std::string second(600, 'b');
+    SIMPLE_LOG_CHECK(push(queue, second));
+    size_t span_count = 0;
+    SIMPLE_LOG_CHECK(peek(queue, &span_count) == makeFrame(second));
+    SIMPLE_LOG_CHECK(span_count == 2);
+
+    // a header cut by the wrap still gives the frame size
+    queue.consume(makeFrame(second).size());
+    SIMPLE_LOG_CHECK(queue.pending() == 0 && !queue.hasPartialFrame());
+    std::string third(10, 'c');
+    std::string fourth(20, 'd');
+    // head at 1294 & 1023 = 270, so after 748 bytes the payload_size of the third frame is cut by the end
+    std::string filler(748 - sizeof(LogHeader) - 1, 'e');
+    SIMPLE_LOG_CHECK(push(queue, filler));
+    queue.consume(makeFrame(filler).size());
+    SIMPLE_LOG_CHECK(push(queue, third));
+    SIMPLE_LOG_CHECK(push(queue, fourth));
+    SIMPLE_LOG_CHECK(peek(queue, &span_count) == makeFrame(third) + makeFrame(fourth));
+    SIMPLE_LOG_CHECK(span_count == 2);
+    queue.consume(10);
+    SIMPLE_LOG_CHECK(queue.hasPartialFrame());
+    queue.consume(makeFrame(third).size() - 10);
+    SIMPLE_LOG_CHECK(!queue.hasPartialFrame());
+    SIMPLE_LOG_CHECK(peek(queue) == makeFrame(fourth));
+}
+
+SIMPLE_LOG_TEST(LogClientQueue_DropsPartialFrame)
+{
+    LogClientQueue queue{ LogLine::SIZE };
+    std::string first = "first";
+    std::string second = "second";
+    SIMPLE_LOG_CHECK(push(queue, first));
+    SIMPLE_LOG_CHECK(push(queue, second));
+    SIMPLE_LOG_CHECK(peek(queue) == makeFrame(first) + makeFrame(second));
+
+    // a connection broke after 50 bytes of the first frame
+    queue.consume(50);
+    SIMPLE_LOG_CHECK(queue.hasPartialFrame());
+    SIMPLE_LOG_CHECK(queue.pending() == makeFrame(first).size() + makeFrame(second).size() - 50);
+    queue.dropPartialFrame();
+    SIMPLE_LOG_CHECK(!queue.hasPartialFrame());
+    // the next connection starts at the header of the second frame
+    std::string rest = peek(queue);
+    SIMPLE_LOG_CHECK(rest == makeFrame(second));
+    SIMPLE_LOG_CHECK(LogLine::isValid(rest.data()));
+
+    // nothing to drop on a frame boundary
+    queue.dropPartialFrame();
+    SIMPLE_LOG_CHECK(peek(queue) == makeFrame(second));
+    queue.consume(rest.size());
+    SIMPLE_LOG_CHECK(queue.pending() == 0 && !queue.hasPartialFrame());
+}
+
+SIMPLE_LOG_TEST(LogClientQueue_RejectsPushWhenFull)
+{
+    LogClientQueue queue{ LogLine::SIZE };
+    std::string content(200, 'x');
+    size_t frame_size = makeFrame(content).size();
+    size_t count = 0;
+    while (push(queue, content))
+        count++;
+    SIMPLE_LOG_CHECK(count == LogLine::SIZE / frame_size);
+    SIMPLE_LOG_CHECK(queue.pending() == count * frame_size);
+
+    // a rejected push leaves what is staged as it was
+    std::string staged = peek(queue);
+    SIMPLE_LOG_CHECK(!push(queue, content));
+    SIMPLE_LOG_CHECK(peek(queue) == staged);
+
+    // a smaller frame still fits into the room left
+    size_t room = LogLine::SIZE - queue.pending();
+    SIMPLE_LOG_CHECK(push(queue, std::string(room - sizeof(LogHeader) - 1, 'y')));
+    SIMPLE_LOG_CHECK(queue.pending() == LogLine::SIZE);
+    SIMPLE_LOG_CHECK(!push(queue, ""));
+
+    // room comes back as the sender consumes
+    queue.consume(frame_size);
+    SIMPLE_LOG_CHECK(push(queue, content));
+    SIMPLE_LOG_CHECK(!push(queue, content));
+}
@@ -0,0 +1,177 @@
+#include "simple_log_test.hpp"
+
+#include <simple_log_format.hpp>
+#include <log_format/log_format_dictionary.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    // Arguments as a client encodes them
+    template<typename... Args>
+    std::vector<char> encodeArguments(const Args&... args)
+    {
+        std::vector<char> ret(1024);
+        char* output = ret.data();
+        ((output = LogFormat::encode(output, ret.data() + ret.size(), args)), ...);
+        ret.resize(output - ret.data());
+        return ret;
+    }
+
+    std::string expand(const char* format, const std::vector<char>& arguments, size_t output_size = 256)
+    {
+        std::vector<char> output(output_size, 'x');
+        size_t size = LogFormat::expand(format, arguments.data(), arguments.size(), output.data(), output.size());
+        if (output_size == 0)
+            return std::string(size, '?');
+        if (output[size] != '\0')
+            return "(not terminated)";
+        return std::string(output.data(), size);
+    }
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsArguments)
+{
+    int value = -3;
+    SIMPLE_LOG_CHECK(expand("{} {} {} {} {} {}", encodeArguments(true, 'c', value, 42u, 1.5, "text")) == "true c -3 42 1.5 text");
+    SIMPLE_LOG_CHECK(expand("{}", encodeArguments(reinterpret_cast<void*>(0x1234))) == "0x1234");
+    SIMPLE_LOG_CHECK(expand("{}", encodeArguments(0.1)) == "0.1");
+
+    // missing arguments leave their placeholders
+    SIMPLE_LOG_CHECK(expand("{} and {}", encodeArguments(1)) == "1 and {}");
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsEscapes)
+{
+    SIMPLE_LOG_CHECK(expand("{{}} {{{}}}", encodeArguments(5)) == "{} {5}");
+    SIMPLE_LOG_CHECK(expand("{{{{", {}) == "{{");
+    SIMPLE_LOG_CHECK(LogFormat::countPlaceholders("{{}} {{{}}}") == 1);
+    SIMPLE_LOG_CHECK(LogFormat::countPlaceholders("{ }") == LogFormat::INVALID);
+    SIMPLE_LOG_CHECK(LogFormat::countPlaceholders("}") == LogFormat::INVALID);
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsTruncatedArguments)
+{
+    int64_t number = 7;
+    std::vector<std::vector<char>> cases = {
+        encodeArguments(true),
+        encodeArguments('c'),
+        encodeArguments(number),
+        encodeArguments(static_cast<uint64_t>(number)),
+        encodeArguments(1.5),
+        encodeArguments(reinterpret_cast<void*>(0x10)),
+        encodeArguments("text"),
+    };
+    for (auto& arguments : cases) {
+        // every cut of the value, keeping the type byte
+        for (size_t size = 1; size < arguments.size(); size++) {
+            std::vector<char> truncated{ arguments.begin(), arguments.begin() + size };
+            std::string text = expand("[{}] [{}]", truncated);
+            if (arguments[0] == static_cast<char>(LogFormat::ArgumentType::STRING) && size > 3)
+                SIMPLE_LOG_CHECK(text == "[" + std::string("text", size - 3) + "] [{}]");
+            else
+                SIMPLE_LOG_CHECK(text == "[] [{}]");
+        }
+    }
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsUnknownType)
+{
+    std::vector<char> arguments = encodeArguments(1, 2);
+    arguments[0] = 0x7F;
+    // the arguments after an unknown type cannot be read
+    SIMPLE_LOG_CHECK(expand("{} {} {}", arguments) == "{?} {} {}");
+
+    arguments = encodeArguments(1);
+    arguments[0] = 0;
+    SIMPLE_LOG_CHECK(expand("a{}b", arguments) == "a{?}b");
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsStringPastEnd)
+{
+    std::vector<char> arguments = encodeArguments("abc");
+    uint16_t length = 1000;
+    memcpy(arguments.data() + 1, &length, sizeof(length));
+    SIMPLE_LOG_CHECK(expand("<{}> {}", arguments) == "<abc> {}");
+}
+
+SIMPLE_LOG_TEST(LogFormat_ExpandsIntoSmallBuffer)
+{
+    SIMPLE_LOG_CHECK(expand("abcdefghijkl", {}, 8) == "abcdefg");
+    SIMPLE_LOG_CHECK(expand("{}", encodeArguments("abcdefghijkl"), 8) == "abcdefg");
+    SIMPLE_LOG_CHECK(expand("ab{}", encodeArguments(-1234567), 8) == "ab-1234");
+    SIMPLE_LOG_CHECK(expand("a{}", encodeArguments(1.0 / 3.0), 8) == "a0.3333");
+    SIMPLE_LOG_CHECK(expand("ab{{cd", {}, 4) == "ab{");
+    SIMPLE_LOG_CHECK(expand("ab", {}, 1) == "");
+    SIMPLE_LOG_CHECK(expand("ab", {}, 0) == "");
+
+    // the content of a line is never overrun
+    std::string long_format(2000, 'a');
+    std::vector<char> output(LogLine::CONTENT_SIZE + 16, 'x');
+    size_t size = LogFormat::expand(long_format.c_str(), nullptr, 0, output.data(), LogLine::CONTENT_SIZE);
+    SIMPLE_LOG_CHECK(size == LogLine::CONTENT_SIZE - 1);
+    SIMPLE_LOG_CHECK(output[LogLine::CONTENT_SIZE - 1] == '\0' && output[LogLine::CONTENT_SIZE] == 'x');
+}
+
+SIMPLE_LOG_TEST(LogFormatDictionary_DefinesAndExpands)
+{
+    LogFormatDictionary dictionary;
+    const char* format = "user {} logged in from {}";
+    uint64_t format_id = LogFormat::hash(format);
+    SIMPLE_LOG_CHECK(dictionary.define(format_id, format, strlen(format) + 1));
+    // a second definition of the same string is accepted and changes nothing
+    SIMPLE_LOG_CHECK(dictionary.define(format_id, format, strlen(format)));
+
+    std::vector<char> arguments = encodeArguments("alice", "10.0.0.1");
+    LogLine line{ "Test::Format", "TEST", LogColor::Green, "" };
+    line.header.flags |= LogHeader::FLAG_FORMATTED;
+    line.header.format_id = format_id;
+    SIMPLE_LOG_CHECK(dictionary.expand(line, arguments.data(), arguments.size()));
+    SIMPLE_LOG_CHECK(std::string(line.content) == "user alice logged in from 10.0.0.1");
+    SIMPLE_LOG_CHECK(line.header.format_id == 0);
+    SIMPLE_LOG_CHECK(!(line.header.flags & LogHeader::FLAG_FORMATTED));
+}
+
+SIMPLE_LOG_TEST(LogFormatDictionary_RejectsMismatchedId)
+{
+    LogFormatDictionary dictionary;
+    const char* format = "value {}";
+    const char* other = "other {}";
+    uint64_t format_id = LogFormat::hash(format);
+
+    // an id that is not the hash of its string cannot claim it
+    SIMPLE_LOG_CHECK(!dictionary.define(format_id, other, strlen(other)));
+    SIMPLE_LOG_CHECK(!dictionary.define(format_id + 1, format, strlen(format)));
+
+    std::vector<char> arguments = encodeArguments(1);
+    LogLine line{ "Test::Format", "TEST", LogColor::Green, "" };
+    line.header.flags |= LogHeader::FLAG_FORMATTED;
+    line.header.format_id = format_id;
+    SIMPLE_LOG_CHECK(!dictionary.expand(line, arguments.data(), arguments.size()));
+    SIMPLE_LOG_CHECK(std::string(line.content).find("unknown format") != std::string::npos);
+
+    // the rejected definitions did not take the id
+    SIMPLE_LOG_CHECK(dictionary.define(format_id, format, strlen(format)));
+    line.header.flags |= LogHeader::FLAG_FORMATTED;
+    line.header.format_id = format_id;
+    SIMPLE_LOG_CHECK(dictionary.expand(line, arguments.data(), arguments.size()));
+    SIMPLE_LOG_CHECK(std::string(line.content) == "value 1");
+}
+
+SIMPLE_LOG_TEST(LogFormatDictionary_NotesUnknownId)
+{
+    LogFormatDictionary dictionary;
+    std::vector<char> arguments = encodeArguments(1);
+    LogLine line{ "Test::Format", "TEST", LogColor::Green, "" };
+    line.header.flags |= LogHeader::FLAG_FORMATTED;
+    line.header.format_id = 0x0123456789abcdefull;
+    SIMPLE_LOG_CHECK(!dictionary.expand(line, arguments.data(), arguments.size()));
+    SIMPLE_LOG_CHECK(std::string(line.content) == "(unknown format 0123456789abcdef)");
+    SIMPLE_LOG_CHECK(line.header.format_id == 0);
+    SIMPLE_LOG_CHECK(!(line.header.flags & LogHeader::FLAG_FORMATTED));
+}
@@ -0,0 +1,181 @@
+#include "simple_log_test.hpp"
+
+#include <simple_log_protocol.hpp>
+#include <log_ingestion/log_epoll_server.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    // Frame as a client sends it : header and payload_size bytes of content
+    std::string makeFrame(const char* content, bool is_sealed)
+    {
+        LogLine line{ "Test::Frame", "TEST", LogColor::Green, content };
+        if (is_sealed)
+            line.seal();
+        return std::string(reinterpret_cast<const char*>(&line), line.wireSize());
+    }
+}
+
+SIMPLE_LOG_TEST(LogLine_FindsHeader)
+{
+    std::string frame = makeFrame("first", true);
+    SIMPLE_LOG_CHECK(LogLine::findHeader(frame.data(), frame.size()) == 0);
+
+    std::string stream = "xxS" + std::string("SLOx") + "SS" + frame;
+    SIMPLE_LOG_CHECK(LogLine::findHeader(stream.data(), stream.size()) == stream.size() - frame.size());
+
+    // the start of a magic at the end can be completed by the next read
+    const char* partial = "abcdSL";
+    SIMPLE_LOG_CHECK(LogLine::findHeader(partial, 6) == 4);
+    SIMPLE_LOG_CHECK(LogLine::findHeader(partial, 5) == 4);
+    SIMPLE_LOG_CHECK(LogLine::findHeader(partial, 4) == 4);
+    SIMPLE_LOG_CHECK(LogLine::findHeader("", 0) == 0);
+}
+
+SIMPLE_LOG_TEST(LogLine_ChecksFrames)
+{
+    std::string frame = makeFrame("checked", true);
+    const char* header = frame.data();
+    size_t payload_size = LogLine::getPayloadSize(header);
+    SIMPLE_LOG_CHECK(payload_size == strlen("checked") + 1);
+    SIMPLE_LOG_CHECK(LogLine::isValid(header));
+    SIMPLE_LOG_CHECK(LogLine::isIntact(header, header + sizeof(LogHeader), payload_size));
+
+    std::string damaged = frame;
+    damaged[sizeof(LogHeader) + 2] ^= 0x01;
+    SIMPLE_LOG_CHECK(!LogLine::isIntact(damaged.data(), damaged.data() + sizeof(LogHeader), payload_size));
+    damaged = frame;
+    damaged[offsetof(LogHeader, tag)] ^= 0x01;
+    SIMPLE_LOG_CHECK(!LogLine::isIntact(damaged.data(), damaged.data() + sizeof(LogHeader), payload_size));
+
+    // frames of clients that do not send checksums are not checked
+    std::string unsealed = makeFrame("unchecked", false);
+    unsealed[sizeof(LogHeader)] ^= 0x01;
+    SIMPLE_LOG_CHECK(LogLine::isIntact(unsealed.data(), unsealed.data() + sizeof(LogHeader), LogLine::getPayloadSize(unsealed.data())));
+
+    // headers a misaligned stream produces
+    damaged = frame;
+    damaged[offsetof(LogHeader, flags)] = static_cast<char>(0x80);
+    SIMPLE_LOG_CHECK(!LogLine::isValid(damaged.data()));
+    damaged = frame;
+    uint32_t payload_size_field = LogLine::CONTENT_SIZE + 1;
+    memcpy(&damaged[LogHeader::OFFSET_PAYLOAD_SIZE], &payload_size_field, sizeof(payload_size_field));
+    SIMPLE_LOG_CHECK(!LogLine::isValid(damaged.data()));
+}
+
+#if defined(__linux__)
+namespace
+{
+    class FrameCollector : public SocketRequestHandler, public LogFrameSynchronizer
+    {
+    public:
+        size_t getHeaderSize() override { return sizeof(LogHeader); }
+        size_t getPayloadSize(const char* header) override { return LogLine::getPayloadSize(header); }
+        SocketRequestMode onModeClassified(const char*) override { return SocketRequestMode::WRITE_STREAM; }
+        void onClientConnected(const char*, int) override {}
+        void onClientDisconnected(const char*, int) override {}
+        void onProcessed(const char*, const char*, size_t, char*, size_t*) override {}
+        void onProcessedWithoutResponse(const char* header, const char* input_buffer, size_t input_size) override { onFrame(header, input_buffer, input_size); }
+
+        bool isFrameHeader(const char* header) override { return LogLine::isValid(header); }
+        size_t findFrameHeader(const char* data, size_t size) override { return LogLine::findHeader(data, size); }
+        bool onFrame(const char* header, const char* payload, size_t payload_size) override {
+            if (!LogLine::isIntact(header, payload, payload_size))
+                return false;
+            std::lock_guard<std::mutex> lock(_mutex);
+            _contents.emplace_back(payload, strnlen(payload, payload_size));
+            return true;
+        }
+
+        std::vector<std::string> wait(size_t count) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (std::chrono::steady_clock::now() < deadline) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_contents.size() >= count)
+                        break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            // frames that should not have come
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _contents;
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<std::string> _contents;
+    };
+}
+
+SIMPLE_LOG_TEST(LogEpollServer_ResynchronizesStream)
+{
+    FrameCollector collector;
+    LogEpollServerConfiguration configuration;
+    configuration.reactor_count = 1;
+
+    std::unique_ptr<LogEpollServer> server;
+    uint32_t port = 0;
+    for (uint32_t candidate = 19931; candidate < 19951 && !server; candidate++) {
+        server = std::make_unique<LogEpollServer>(candidate, configuration);
+        if (server->open(&collector, &collector))
+            port = candidate;
+        else
+            server.reset();
+    }
+    SIMPLE_LOG_CHECK(server != nullptr);
+    if (!server)
+        return;
+
+    // stray bytes, a damaged frame and a partial magic between intact frames
+    std::string damaged = makeFrame("damaged", true);
+    damaged[sizeof(LogHeader) + 1] ^= 0x01;
+    std::string stream = makeFrame("one", true)
+        + "garbage"
+        + makeFrame("two", false)
+        + damaged
+        + "SLO"
+        + makeFrame("three", true)
+        + makeFrame("four", true);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool is_connected = fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    SIMPLE_LOG_CHECK(is_connected);
+    if (is_connected) {
+        // in small pieces, so that headers are cut between reads
+        for (size_t offset = 0; offset < stream.size(); offset += 37) {
+            size_t size = std::min<size_t>(37, stream.size() - offset);
+            SIMPLE_LOG_CHECK(send(fd, stream.data() + offset, size, MSG_NOSIGNAL) == static_cast<ssize_t>(size));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::vector<std::string> contents = collector.wait(4);
+        SIMPLE_LOG_CHECK((contents == std::vector<std::string>{ "one", "two", "three", "four" }));
+    }
+    if (fd >= 0)
+        ::close(fd);
+    server->close();
+}
+#endif
@@ -0,0 +1,108 @@
+#include "simple_log_test.hpp"
+
+#include <log_metrics/log_metrics_exporter.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace Bn3Monkey;
+
+#if defined(__linux__)
+namespace
+{
+    std::unique_ptr<LogMetricsExporter> makeExporter(uint32_t& port, LogMetricsExporter::Render render)
+    {
+        for (uint32_t candidate = 19951; candidate < 19971; candidate++) {
+            LogMetricsConfiguration configuration;
+            configuration.http_port = candidate;
+            auto exporter = std::make_unique<LogMetricsExporter>(configuration, render);
+            if (exporter->isServing()) {
+                port = candidate;
+                return exporter;
+            }
+        }
+        return nullptr;
+    }
+
+    int connectTo(uint32_t port)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // Status line of the response to request
+    std::string request(uint32_t port, const std::string& text)
+    {
+        int fd = connectTo(port);
+        if (fd < 0)
+            return "";
+        send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+        std::string response;
+        char buffer[256];
+        ssize_t result;
+        while ((result = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, static_cast<size_t>(result));
+        ::close(fd);
+        return response.substr(0, response.find("\r\n"));
+    }
+}
+
+SIMPLE_LOG_TEST(LogMetricsExporter_ServesMetricsPath)
+{
+    uint32_t port = 0;
+    auto exporter = makeExporter(port, [](std::string& output) { output = "simple_log_test 1\n"; });
+    SIMPLE_LOG_CHECK(exporter != nullptr);
+    if (!exporter)
+        return;
+
+    SIMPLE_LOG_CHECK(request(port, "GET /metrics HTTP/1.1\r\n\r\n") == "HTTP/1.0 200 OK");
+    SIMPLE_LOG_CHECK(request(port, "GET /metrics?name=x HTTP/1.1\r\n\r\n") == "HTTP/1.0 200 OK");
+    SIMPLE_LOG_CHECK(request(port, "GET / HTTP/1.1\r\n\r\n") == "HTTP/1.0 200 OK");
+    SIMPLE_LOG_CHECK(request(port, "GET /metricsfoo HTTP/1.1\r\n\r\n") == "HTTP/1.0 404 Not Found");
+    SIMPLE_LOG_CHECK(request(port, "GET /metrics/x HTTP/1.1\r\n\r\n") == "HTTP/1.0 404 Not Found");
+}
+
+SIMPLE_LOG_TEST(LogMetricsExporter_StopsWithUnreadResponse)
+{
+    // larger than the socket buffers, so that the response cannot be sent while the client does not read
+    uint32_t port = 0;
+    auto exporter = makeExporter(port, [](std::string& output) { output.assign(32 * 1024 * 1024, 'x'); });
+    SIMPLE_LOG_CHECK(exporter != nullptr);
+    if (!exporter)
+        return;
+
+    int fd = connectTo(port);
+    SIMPLE_LOG_CHECK(fd >= 0);
+    if (fd >= 0) {
+        int size = 4096;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        const char* text = "GET /metrics HTTP/1.1\r\n\r\n";
+        send(fd, text, strlen(text), MSG_NOSIGNAL);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    exporter.reset();
+    SIMPLE_LOG_CHECK(std::chrono::steady_clock::now() - begin < std::chrono::seconds(2));
+    if (fd >= 0)
+        ::close(fd);
+}
+#endif
@@ -0,0 +1,61 @@
+#include "simple_log_test.hpp"
+#include "log_segment_samples.hpp"
+
+#include <log_pool/log_segment_recovery.hpp>
+#include <log_query/log_query.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+SIMPLE_LOG_TEST(LogQuery_ReadsClosedAndLiveSegments)
+{
+    LogSegmentSamples::resetDirectory("query");
+
+    // closed without an index, then the segment still being written (zero tail, no footer)
+    for (const char* name : { "query/log_20260101_000000_0000.slog", "query/log_20260101_000000_0001.slog", "query/log_20260101_000000_0002.slog" }) {
+        std::vector<size_t> offsets;
+        std::vector<char> data = LogSegmentSamples::makeRecords(30, offsets);
+        data.resize(64 * 1024, 0);
+        LogSegmentSamples::writeFile(name, data);
+    }
+    for (const char* name : { "query/log_20260101_000000_0000.slog", "query/log_20260101_000000_0001.slog" }) {
+        LogSegmentScan scan = LogSegmentRecovery::recover(name);
+        SIMPLE_LOG_CHECK(LogSegmentRecovery::close(name, scan));
+    }
+
+    for (size_t thread_count : { 1, 4 }) {
+        size_t count = 0;
+        size_t matched = LogQuery::run("query", LogQueryFilter{}, [&](const LogRecord&) { count++; return true; }, thread_count);
+        SIMPLE_LOG_CHECK(matched == 90);
+        SIMPLE_LOG_CHECK(count == 90);
+    }
+}
+
+SIMPLE_LOG_TEST(LogSegmentReader_SkipsRecordsFailingChecksum)
+{
+    LogSegmentSamples::resetDirectory("query_checksum");
+    std::string path = "query_checksum/log_20260101_000000_0000.slog";
+
+    // framing intact, content damaged
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(30, offsets);
+    data[offsets[11] - 3] ^= 0x01;
+    data[offsets[20] - 3] ^= 0x01;
+    LogSegmentSamples::writeFile(path, data);
+
+    std::vector<uint64_t> sequences = LogSegmentSamples::readSequences(path);
+    SIMPLE_LOG_CHECK(sequences.size() == 28);
+    SIMPLE_LOG_CHECK(std::find(sequences.begin(), sequences.end(), 10) == sequences.end());
+    SIMPLE_LOG_CHECK(std::find(sequences.begin(), sequences.end(), 19) == sequences.end());
+
+    std::vector<uint64_t> followed;
+    LogSegmentFollower follower{ path };
+    LogRecord record;
+    while (follower.next(record))
+        followed.push_back(record.header().sequence);
+    SIMPLE_LOG_CHECK(followed == sequences);
+    SIMPLE_LOG_CHECK(follower.offset() == data.size());
+}
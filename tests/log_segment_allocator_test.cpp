@@ -0,0 +1,96 @@
+#include "simple_log_test.hpp"
+#include "log_segment_samples.hpp"
+
+#include <log_pool/log_pool.hpp>
+#include <log_pool/log_segment_allocator.hpp>
+
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    // Names the allocator gives to the first segments of the second at now
+    std::vector<std::string> getSegmentPaths(const std::string& directory, std::time_t now, uint32_t count)
+    {
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &now);
+#else
+        localtime_r(&now, &tm);
+#endif
+        std::vector<std::string> ret;
+        for (uint32_t sequence = 0; sequence < count; sequence++) {
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "log_%04d%02d%02d_%02d%02d%02d_%04u.slog",
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, sequence);
+            ret.push_back(directory + "/" + buffer);
+        }
+        return ret;
+    }
+}
+
+SIMPLE_LOG_TEST(MemoryMappedFile_KeepsCreateNewError)
+{
+    LogSegmentSamples::resetDirectory("mapped_file");
+    std::string path = "mapped_file/existing.slog";
+    std::vector<char> data(100, 'k');
+    LogSegmentSamples::writeFile(path, data);
+
+    MemoryMappedFile file{ path.c_str(), MemoryMappedFile::Access::READWRITE_WITH_CREATE_NEW, 4096 };
+    SIMPLE_LOG_CHECK(!file);
+    SIMPLE_LOG_CHECK(file.error() == MemoryMappedFile::Code::FILE_ALREADY_EXISTS);
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(path) == data);
+}
+
+SIMPLE_LOG_TEST(LogSegmentAllocator_SkipsExistingSegments)
+{
+    LogSegmentSamples::resetDirectory("allocator");
+
+    // segments of a previous process, written in the seconds the allocator can pick
+    std::vector<char> data(100, 'k');
+    std::vector<std::string> existing;
+    std::time_t now = std::time(nullptr);
+    for (std::time_t second = now; second < now + 3; second++) {
+        for (auto& path : getSegmentPaths("allocator", second, 3)) {
+            LogSegmentSamples::writeFile(path, data);
+            existing.push_back(path);
+        }
+    }
+
+    LogSegmentWriterConfiguration configuration;
+    configuration.segment_size = 64 * 1024;
+    std::string path;
+    {
+        LogSegmentAllocator allocator{ configuration, "allocator" };
+        auto segment = allocator.acquire(path);
+        SIMPLE_LOG_CHECK(segment && *segment);
+        for (auto& item : existing)
+            SIMPLE_LOG_CHECK(path != item);
+        if (segment)
+            segment->release(0);
+        // the spare prepared next is removed with the allocator
+    }
+
+    for (auto& item : existing)
+        SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(item) == data);
+}
+
+SIMPLE_LOG_TEST(LogPool_ReportsDroppedLines)
+{
+    // segments cannot be created under a regular file
+    LogSegmentSamples::resetDirectory("pool_dropping");
+    LogSegmentSamples::writeFile("pool_dropping/file", std::vector<char>(10, 'f'));
+
+    LogPoolConfiguration configuration;
+    configuration.directory = "pool_dropping/file/segments";
+    configuration.is_compressed = false;
+    LogPool pool{ configuration };
+
+    std::vector<LogLine> lines(10, LogLine{ "Test::Pool", "TEST", LogColor::Green, "dropped" });
+    SIMPLE_LOG_CHECK(pool.writeBatch(lines.data(), lines.size()) == 0);
+    SIMPLE_LOG_CHECK(!pool.write(lines[0]));
+}
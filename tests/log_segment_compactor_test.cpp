@@ -0,0 +1,121 @@
+#include "simple_log_test.hpp"
+#include "log_segment_samples.hpp"
+
+#include <log_pool/log_pool.hpp>
+#include <log_pool/log_segment_compactor.hpp>
+#include <log_pool/log_segment_recovery.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+SIMPLE_LOG_TEST(LogSegmentCompactor_CompressesClosedSegment)
+{
+    LogSegmentSamples::resetDirectory("compactor_closed");
+    std::string path = "compactor_closed/log_20260101_000000_0000.slog";
+
+    // several blocks of records, then the footer
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(5000, offsets);
+    size_t records_size = data.size();
+    data.resize(records_size + LogSegmentFooter::SIZE);
+    LogSegmentFooter::encode(data.data() + records_size, offsets.size(), records_size);
+    LogSegmentSamples::writeFile(path, data);
+    std::vector<uint64_t> sequences = LogSegmentSamples::readSequences(path);
+    SIMPLE_LOG_CHECK(sequences.size() == 5000);
+
+    SIMPLE_LOG_CHECK(LogSegmentCompactor::compact(path));
+    std::string compressed_path = LogSegmentCompactor::getCompressedPath(path);
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(path));
+    SIMPLE_LOG_CHECK(std::filesystem::exists(compressed_path));
+    SIMPLE_LOG_CHECK(std::filesystem::file_size(compressed_path) < records_size);
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(compressed_path) == sequences);
+}
+
+SIMPLE_LOG_TEST(LogSegmentCompactor_LeavesDamagedSegment)
+{
+    LogSegmentSamples::resetDirectory("compactor_damaged");
+    std::string path = "compactor_damaged/log_20260101_000000_0000.slog";
+
+    // a record in the middle no longer matches its checksum
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(2000, offsets);
+    data[offsets[1000] + 40] ^= 0x01;
+    LogSegmentSamples::writeFile(path, data);
+
+    SIMPLE_LOG_CHECK(!LogSegmentCompactor::compact(path));
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(LogSegmentCompactor::getCompressedPath(path)));
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(LogSegmentCompactor::getCompressedPath(path) + ".tmp"));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(path) == data);
+
+    // bytes that are not records behind the last one
+    offsets.clear();
+    data = LogSegmentSamples::makeRecords(2000, offsets);
+    data.resize(data.size() + 64, 'x');
+    LogSegmentSamples::writeFile(path, data);
+    SIMPLE_LOG_CHECK(!LogSegmentCompactor::compact(path));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(path) == data);
+}
+
+SIMPLE_LOG_TEST(LogSegmentCompactor_MarksRefusedSegment)
+{
+    LogSegmentSamples::resetDirectory("compactor_marked");
+    std::string path = "compactor_marked/log_20260101_000000_0000.slog";
+
+    // closed, then damaged
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(100, offsets);
+    size_t records_size = data.size();
+    data.resize(records_size + LogSegmentFooter::SIZE);
+    LogSegmentFooter::encode(data.data() + records_size, offsets.size(), records_size);
+    data[offsets[50] + 40] ^= 0x01;
+    LogSegmentSamples::writeFile(path, data);
+
+    SIMPLE_LOG_CHECK(!LogSegmentCompactor::compact(path));
+    uint64_t closed_size = 0;
+    uint8_t flags = 0;
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::isClosed(path, closed_size, &flags));
+    SIMPLE_LOG_CHECK(closed_size == records_size);
+    SIMPLE_LOG_CHECK(flags & LogSegmentFooter::FLAG_DAMAGED);
+    // only the footer changed
+    std::vector<char> marked = LogSegmentSamples::readFile(path);
+    SIMPLE_LOG_CHECK(marked.size() == data.size() && std::equal(data.begin(), data.begin() + records_size, marked.begin()));
+
+    // a LogPool starting on the directory does not hand it to the compactor again
+    {
+        LogPoolConfiguration configuration;
+        configuration.directory = "compactor_marked";
+        configuration.max_bytes_per_file = 64 * 1024;
+        LogPool pool{ configuration };
+    }
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(path) == marked);
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(LogSegmentCompactor::getCompressedPath(path)));
+}
+
+SIMPLE_LOG_TEST(LogPool_DoesNotCompressDamagedRecovery)
+{
+    LogSegmentSamples::resetDirectory("compactor_recovered");
+    std::string path = "compactor_recovered/log_20260101_000000_0000.slog";
+
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(100, offsets);
+    data[offsets[50] + 2] ^= 0x01;
+    data.resize(64 * 1024, 0);
+    LogSegmentSamples::writeFile(path, data);
+
+    {
+        LogPoolConfiguration configuration;
+        configuration.directory = "compactor_recovered";
+        configuration.max_bytes_per_file = 64 * 1024;
+        LogPool pool{ configuration };
+    }
+    uint64_t records_size = 0;
+    uint8_t flags = 0;
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::isClosed(path, records_size, &flags));
+    SIMPLE_LOG_CHECK(flags & LogSegmentFooter::FLAG_DAMAGED);
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(LogSegmentCompactor::getCompressedPath(path)));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(path).size() == 99);
+}
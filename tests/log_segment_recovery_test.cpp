@@ -0,0 +1,175 @@
+#include "simple_log_test.hpp"
+#include "log_segment_samples.hpp"
+
+#include <log_pool/log_pool.hpp>
+#include <log_pool/log_segment_recovery.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+SIMPLE_LOG_TEST(LogSegmentRecovery_SkipsDamagedRecord)
+{
+    LogSegmentSamples::resetDirectory("recovery_damaged");
+    std::string path = "recovery_damaged/log_20260101_000000_0000.slog";
+
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(100, offsets);
+    size_t records_size = data.size();
+    size_t damaged_size = offsets[41] - offsets[40];
+    // a size that does not add up : the record cannot be walked over
+    data[offsets[40] + 2] ^= 0x01;
+    data.resize(64 * 1024, 0);
+    LogSegmentSamples::writeFile(path, data);
+
+    LogSegmentIndexBuilder index{ 16 };
+    LogSegmentScan scan = LogSegmentRecovery::recover(path, &index);
+    SIMPLE_LOG_CHECK(!scan.is_closed);
+    SIMPLE_LOG_CHECK(scan.record_count == 99);
+    SIMPLE_LOG_CHECK(index.recordCount() == 99);
+    SIMPLE_LOG_CHECK(scan.records_size == records_size);
+    SIMPLE_LOG_CHECK(scan.skipped_size == damaged_size);
+    SIMPLE_LOG_CHECK(!scan.isClean());
+    // the scan only reads
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(path) == data);
+
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::close(path, scan));
+    SIMPLE_LOG_CHECK(index.save(LogSegmentIndexBuilder::getPath(path).c_str()));
+    uint64_t closed_size = 0;
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::isClosed(path, closed_size));
+    SIMPLE_LOG_CHECK(closed_size == records_size);
+
+    std::vector<char> closed = LogSegmentSamples::readFile(path);
+    SIMPLE_LOG_CHECK(closed.size() == records_size + LogSegmentFooter::SIZE);
+    SIMPLE_LOG_CHECK(std::equal(data.begin(), data.begin() + records_size, closed.begin()));
+
+    std::vector<uint64_t> sequences = LogSegmentSamples::readSequences(path);
+    SIMPLE_LOG_CHECK(sequences.size() == 99);
+    SIMPLE_LOG_CHECK(std::find(sequences.begin(), sequences.end(), 40) == sequences.end());
+    SIMPLE_LOG_CHECK(!sequences.empty() && sequences.back() == 99);
+
+    // without the index, the reader gets past the damaged record by itself
+    std::filesystem::remove(LogSegmentIndexBuilder::getPath(path));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(path) == sequences);
+}
+
+SIMPLE_LOG_TEST(LogSegmentRecovery_KeepsTornTail)
+{
+    LogSegmentSamples::resetDirectory("recovery_torn");
+    std::string path = "recovery_torn/log_20260101_000000_0000.slog";
+
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(51, offsets);
+    size_t records_size = offsets[50];
+    // the last record was cut in the middle of its content
+    size_t written_size = data.size() - 3;
+    data.resize(written_size);
+    data.resize(64 * 1024, 0);
+    LogSegmentSamples::writeFile(path, data);
+
+    LogSegmentScan scan = LogSegmentRecovery::recover(path);
+    SIMPLE_LOG_CHECK(scan.record_count == 50);
+    SIMPLE_LOG_CHECK(scan.records_size == records_size);
+    SIMPLE_LOG_CHECK(scan.skipped_size == 0);
+    SIMPLE_LOG_CHECK(scan.written_size == written_size);
+    SIMPLE_LOG_CHECK(!scan.isClean());
+
+    // only the zero tail is cut, the torn record stays in front of the footer
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::close(path, scan));
+    std::vector<char> closed = LogSegmentSamples::readFile(path);
+    SIMPLE_LOG_CHECK(closed.size() == written_size + LogSegmentFooter::SIZE);
+    SIMPLE_LOG_CHECK(std::equal(data.begin(), data.begin() + written_size, closed.begin()));
+    uint64_t closed_size = 0;
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::isClosed(path, closed_size));
+    SIMPLE_LOG_CHECK(closed_size == records_size);
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(path).size() == 50);
+
+    // a second scan sees the same segment, closed
+    LogSegmentScan rescan = LogSegmentRecovery::recover(path);
+    SIMPLE_LOG_CHECK(rescan.is_closed);
+    SIMPLE_LOG_CHECK(rescan.record_count == 50);
+    SIMPLE_LOG_CHECK(rescan.records_size == records_size);
+}
+
+SIMPLE_LOG_TEST(LogPool_RecoversSegments)
+{
+    LogSegmentSamples::resetDirectory("recovery_pool");
+    std::string damaged_path = "recovery_pool/log_20260101_000000_0000.slog";
+    std::string garbage_path = "recovery_pool/log_20260101_000000_0001.slog";
+    std::string empty_path = "recovery_pool/log_20260101_000000_0002.slog";
+
+    std::vector<size_t> offsets;
+    std::vector<char> damaged = LogSegmentSamples::makeRecords(20, offsets);
+    size_t damaged_records_size = damaged.size();
+    damaged[offsets[5] + 10] ^= 0x01;
+    damaged.resize(64 * 1024, 0);
+    LogSegmentSamples::writeFile(damaged_path, damaged);
+
+    std::vector<char> garbage(64 * 1024, 0);
+    for (size_t i = 0; i < 4096; i++)
+        garbage[i] = static_cast<char>('a' + i % 26);
+    LogSegmentSamples::writeFile(garbage_path, garbage);
+    LogSegmentSamples::writeFile(empty_path, std::vector<char>(64 * 1024, 0));
+
+    {
+        LogPoolConfiguration configuration;
+        configuration.directory = "recovery_pool";
+        configuration.max_bytes_per_file = 64 * 1024;
+        configuration.is_compressed = false;
+        LogPool pool{ configuration };
+    }
+
+    // the damaged segment is closed, not appended to, and keeps every byte of its records
+    uint64_t records_size = 0;
+    SIMPLE_LOG_CHECK(LogSegmentRecovery::isClosed(damaged_path, records_size));
+    std::vector<char> closed = LogSegmentSamples::readFile(damaged_path);
+    SIMPLE_LOG_CHECK(records_size == damaged_records_size);
+    SIMPLE_LOG_CHECK(closed.size() >= records_size && std::equal(closed.begin(), closed.begin() + records_size, damaged.begin()));
+    SIMPLE_LOG_CHECK(std::filesystem::exists(LogSegmentIndexBuilder::getPath(damaged_path)));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(damaged_path).size() == 19);
+
+    // content without any record is moved aside, an unused segment is removed
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(garbage_path));
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readFile(garbage_path + LogSegmentRecovery::CORRUPT_EXTENSION) == garbage);
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(empty_path));
+}
+
+SIMPLE_LOG_TEST(LogPool_RebuildsTornIndex)
+{
+    LogSegmentSamples::resetDirectory("recovery_index");
+    std::string path = "recovery_index/log_20260101_000000_0000.slog";
+    std::string index_path = LogSegmentIndexBuilder::getPath(path);
+
+    // a closed segment whose index was cut while it was written
+    std::vector<size_t> offsets;
+    std::vector<char> data = LogSegmentSamples::makeRecords(300, offsets);
+    size_t records_size = data.size();
+    data.resize(records_size + LogSegmentFooter::SIZE);
+    LogSegmentFooter::encode(data.data() + records_size, offsets.size(), records_size);
+    LogSegmentSamples::writeFile(path, data);
+
+    LogSegmentIndexBuilder builder{ 16 };
+    LogSegmentRecovery::recover(path, &builder);
+    SIMPLE_LOG_CHECK(builder.save(index_path.c_str()));
+    SIMPLE_LOG_CHECK(!std::filesystem::exists(index_path + ".tmp"));
+    std::vector<char> index = LogSegmentSamples::readFile(index_path);
+    index.resize(index.size() / 2);
+    LogSegmentSamples::writeFile(index_path, index);
+    SIMPLE_LOG_CHECK(!LogSegmentIndex{ index_path.c_str() });
+
+    {
+        LogPoolConfiguration configuration;
+        configuration.directory = "recovery_index";
+        configuration.max_bytes_per_file = 64 * 1024;
+        configuration.is_compressed = false;
+        LogPool pool{ configuration };
+    }
+
+    LogSegmentIndex rebuilt{ index_path.c_str() };
+    SIMPLE_LOG_CHECK(rebuilt);
+    SIMPLE_LOG_CHECK(rebuilt && rebuilt.recordCount() == 300);
+    SIMPLE_LOG_CHECK(LogSegmentSamples::readSequences(path).size() == 300);
+}
@@ -0,0 +1,74 @@
+#ifndef __BN3MONKEY_LOG_SEGMENT_SAMPLES__
+#define __BN3MONKEY_LOG_SEGMENT_SAMPLES__
+
+#include <log_pool/log_record.hpp>
+#include <log_query/log_segment_reader.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Bn3Monkey
+{
+    // Segment bytes for the tests, written without a LogPool
+    class LogSegmentSamples
+    {
+    public:
+        // Records as a LogPool writes them (sequence i, timestamp 1000 + i), with the offset of each
+        static inline std::vector<char> makeRecords(size_t count, std::vector<size_t>& offsets) {
+            std::vector<char> ret;
+            char record[LogRecord::MAX_SIZE];
+            for (size_t i = 0; i < count; i++) {
+                std::string content = "record " + std::to_string(i);
+                LogLine line{ "Test::Segment", "TEST", LogColor::Green, content.c_str() };
+                line.header.timestamp = 1000 + i;
+                line.header.sequence = i;
+                size_t size = LogRecord::encode(record, line);
+                offsets.push_back(ret.size());
+                ret.insert(ret.end(), record, record + size);
+            }
+            return ret;
+        }
+
+        static inline void writeFile(const std::string& path, const std::vector<char>& data) {
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file)
+                return;
+            fwrite(data.data(), 1, data.size(), file);
+            fclose(file);
+        }
+
+        static inline std::vector<char> readFile(const std::string& path) {
+            std::error_code error;
+            auto size = std::filesystem::file_size(path, error);
+            if (error)
+                return {};
+            std::vector<char> ret(static_cast<size_t>(size));
+            FILE* file = fopen(path.c_str(), "rb");
+            if (!file)
+                return {};
+            ret.resize(fread(ret.data(), 1, ret.size(), file));
+            fclose(file);
+            return ret;
+        }
+
+        // Sequences of the records a LogSegmentReader finds in the segment
+        static inline std::vector<uint64_t> readSequences(const std::string& path) {
+            std::vector<uint64_t> ret;
+            LogSegmentReader reader{ path };
+            LogRecord record;
+            while (reader.next(record))
+                ret.push_back(record.header().sequence);
+            return ret;
+        }
+
+        static inline void resetDirectory(const std::string& directory) {
+            std::error_code error;
+            std::filesystem::remove_all(directory, error);
+            std::filesystem::create_directories(directory, error);
+        }
+    };
+}
+
+#endif // __BN3MONKEY_LOG_SEGMENT_SAMPLES__
@@ -0,0 +1,79 @@
+// Behavioral tests of the server storage paths.
+// Segments are written into a scratch directory, which is removed at the end.
+
+#include "simple_log_test.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    struct TestCase {
+        const char* name;
+        LogTest::Function function;
+    };
+
+    std::vector<TestCase>& getTests()
+    {
+        static std::vector<TestCase> tests;
+        return tests;
+    }
+
+    size_t failures = 0;
+}
+
+void Bn3Monkey::LogTest::add(const char* name, Function function)
+{
+    getTests().push_back(TestCase{ name, function });
+}
+
+void Bn3Monkey::LogTest::fail(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d : %s\n", file, line, expression);
+    failures++;
+}
+
+size_t Bn3Monkey::LogTest::run(const char* filter)
+{
+    size_t failed = 0;
+    size_t count = 0;
+    for (auto& test : getTests()) {
+        if (filter && !strstr(test.name, filter))
+            continue;
+        count++;
+        size_t before = failures;
+        test.function();
+        bool is_passed = failures == before;
+        if (!is_passed)
+            failed++;
+        printf("[%s] %s\n", is_passed ? "PASS" : "FAIL", test.name);
+    }
+    printf("%zu tests, %zu failed\n", count, failed);
+    return failed;
+}
+
+int main(int argc, char** argv)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    fs::path directory = fs::temp_directory_path(error) / "simple_log_tests";
+    fs::remove_all(directory, error);
+    fs::create_directories(directory, error);
+    fs::current_path(directory, error);
+    if (error) {
+        printf("[[SYSTEM]] Cannot use %s (%s)\n", directory.string().c_str(), error.message().c_str());
+        return -1;
+    }
+
+    size_t failed = LogTest::run(argc > 1 ? argv[1] : nullptr);
+
+    fs::current_path(directory.parent_path(), error);
+    fs::remove_all(directory, error);
+    return failed == 0 ? 0 : 1;
+}
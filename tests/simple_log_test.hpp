@@ -0,0 +1,41 @@
+#ifndef __BN3MONKEY_SIMPLE_LOG_TEST__
+#define __BN3MONKEY_SIMPLE_LOG_TEST__
+
+#include <cstddef>
+
+namespace Bn3Monkey
+{
+    // Minimal test registry : each test registers itself at startup and reports failed checks without stopping.
+    //
+    //   SIMPLE_LOG_TEST(LogChecksum_KnownValue)
+    //   {
+    //       SIMPLE_LOG_CHECK(LogChecksum::compute("123456789", 9) == 0xE3069283);
+    //   }
+    class LogTest
+    {
+    public:
+        using Function = void (*)();
+
+        struct Registrar {
+            Registrar(const char* name, Function function) { add(name, function); }
+        };
+
+        static void add(const char* name, Function function);
+        static void fail(const char* file, int line, const char* expression);
+        // Runs the tests whose name contains filter (nullptr : all) and returns the number of failed ones
+        static size_t run(const char* filter);
+    };
+}
+
+#define SIMPLE_LOG_TEST(name) \
+    static void name(); \
+    static Bn3Monkey::LogTest::Registrar name##_registrar{ #name, name }; \
+    static void name()
+
+#define SIMPLE_LOG_CHECK(expression) \
+    do { \
+        if (!(expression)) \
+            Bn3Monkey::LogTest::fail(__FILE__, __LINE__, #expression); \
+    } while (0)
+
+#endif // __BN3MONKEY_SIMPLE_LOG_TEST__
@@ -0,0 +1,226 @@
+// Prints the logs a SimpleLogServer wrote, straight from its segment files.
+//
+// Closed segments are mapped read-only and scanned in place; their sidecar index skips the blocks
+// that cannot match the time range, tag or signature. With --follow the segment being written is
+// tailed and the query moves on to the next segment when the server rotates.
+// A sharded server (shard_NN subdirectories) is read shard by shard and merged by timestamp.
+
+#include <log_query/log_query.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Bn3Monkey;
+
+namespace
+{
+    struct Options
+    {
+        std::string directory{ "." };
+        LogQueryFilter filter;
+        // 0 : every matching record
+        size_t tail{ 0 };
+        bool is_following{ false };
+        bool is_counting{ false };
+        size_t thread_count{ std::max<size_t>(std::thread::hardware_concurrency(), 1) };
+    };
+
+    std::atomic<bool> is_interrupted{ false };
+
+    void printUsage()
+    {
+        printf(
+            "usage: slog-query [options]\n"
+            "  --directory PATH        where the server writes its segments, shards are merged (default: .)\n"
+            "  --from TIME             \"YYYY-MM-DD HH:MM:SS[:mmm]\" (local time) or nanoseconds since the epoch\n"
+            "  --to TIME               (inclusive)\n"
+            "  --tag TAG\n"
+            "  --signature SIGNATURE\n"
+            "  --color NAME            Blue, DarkBlue, Green, ... or 0xRRGGBB\n"
+            "  --grep TEXT             contents containing TEXT (repeat for any of several)\n"
+            "  --tail N                only the last N matching records\n"
+            "  --follow                keep printing records as they are written (last 10 first, unless --tail)\n"
+            "  --count                 print the number of matching records only\n"
+            "  --threads N             segments searched in parallel (default: number of cores)\n");
+    }
+
+    bool parseTime(const char* text, uint64_t& time)
+    {
+        size_t size = strlen(text);
+        if (size > 0 && strspn(text, "0123456789") == size) {
+            time = strtoull(text, nullptr, 10);
+            return true;
+        }
+        time = LogTimestamp::parse(text, size);
+        return time != 0;
+    }
+
+    bool parseColor(const char* text, LogColor& color)
+    {
+        static const struct {
+            const char* name;
+            LogColor color;
+        } colors[] = {
+            { "Blue", LogColor::Blue }, { "DarkBlue", LogColor::DarkBlue },
+            { "Green", LogColor::Green }, { "DarkGreen", LogColor::DarkGreen },
+            { "Purple", LogColor::Purple }, { "Violet", LogColor::Violet },
+            { "Orange", LogColor::Orange }, { "Yellow", LogColor::Yellow },
+            { "Red", LogColor::Red }, { "DarkRed", LogColor::DarkRed },
+            { "Teal", LogColor::Teal }, { "Olive", LogColor::Olive },
+        };
+        for (auto& item : colors) {
+            if (!strcmp(item.name, text)) {
+                color = item.color;
+                return true;
+            }
+        }
+
+        char* end = nullptr;
+        long value = strtol(text, &end, 0);
+        if (end == text || *end != '\0')
+            return false;
+        color = static_cast<LogColor>(value);
+        return true;
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        bool is_tail_given = false;
+        std::vector<std::string> patterns;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+
+            if (arg == "--directory") options.directory = value();
+            else if (arg == "--from") { if (!parseTime(value(), options.filter.from)) return false; }
+            else if (arg == "--to") { if (!parseTime(value(), options.filter.to)) return false; }
+            else if (arg == "--tag") options.filter.tag = value();
+            else if (arg == "--signature") options.filter.signature = value();
+            else if (arg == "--color") {
+                if (!parseColor(value(), options.filter.color))
+                    return false;
+                options.filter.is_color_filtered = true;
+            }
+            else if (arg == "--grep") patterns.push_back(value());
+            else if (arg == "--tail") {
+                options.tail = strtoul(value(), nullptr, 10);
+                is_tail_given = true;
+            }
+            else if (arg == "--follow") options.is_following = true;
+            else if (arg == "--count") options.is_counting = true;
+            else if (arg == "--threads") options.thread_count = std::max<size_t>(strtoul(value(), nullptr, 10), 1);
+            else return false;
+        }
+
+        options.filter.content = LogContentMatcher{ std::move(patterns) };
+        if (options.is_following && !is_tail_given)
+            options.tail = 10;
+        return true;
+    }
+
+    // Keeps the last records of a query as text
+    class TailBuffer
+    {
+    public:
+        explicit TailBuffer(size_t capacity) : _lines(capacity) {}
+
+        void push(const LogRecord& record)
+        {
+            auto& line = _lines[_next % _lines.size()];
+            line.resize(LogRecord::MAX_SIZE + LogTimestamp::TEXT_SIZE + 8);
+            line.resize(std::min(record.render(&line[0], line.size()), line.size() - 1));
+            _next++;
+        }
+
+        void flush()
+        {
+            size_t count = std::min(_next, _lines.size());
+            for (size_t i = _next - count; i < _next; i++) {
+                auto& line = _lines[i % _lines.size()];
+                fwrite(line.data(), 1, line.size(), stdout);
+            }
+            _next = 0;
+        }
+
+    private:
+        std::vector<std::string> _lines;
+        size_t _next{ 0 };
+    };
+
+    void print(const LogRecord& record)
+    {
+        char buffer[LogRecord::MAX_SIZE + LogTimestamp::TEXT_SIZE + 8];
+        size_t size = std::min(record.render(buffer, sizeof(buffer)), sizeof(buffer) - 1);
+        fwrite(buffer, 1, size, stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return -1;
+    }
+
+    static char output_buffer[1 << 20];
+    setvbuf(stdout, output_buffer, _IOFBF, sizeof(output_buffer));
+    signal(SIGINT, [](int) { is_interrupted = true; });
+
+    const char* directory = options.directory.c_str();
+    const auto& filter = options.filter;
+
+    if (options.is_counting) {
+        size_t count = LogQuery::run(directory, filter, [](const LogRecord&) { return !is_interrupted; }, options.thread_count);
+        printf("%zu\n", count);
+        return 0;
+    }
+
+    if (!options.is_following) {
+        if (options.tail == 0) {
+            LogQuery::run(directory, filter, [](const LogRecord& record) {
+                print(record);
+                return !is_interrupted;
+            }, options.thread_count);
+        }
+        else {
+            TailBuffer tail{ options.tail };
+            LogQuery::run(directory, filter, [&](const LogRecord& record) {
+                tail.push(record);
+                return !is_interrupted;
+            }, options.thread_count);
+            tail.flush();
+        }
+        fflush(stdout);
+        return 0;
+    }
+
+    // 처음 따라잡을 때까지는 마지막 N개만 모아 두었다가 출력하고, 그 뒤로는 바로 출력한다
+    TailBuffer tail{ options.tail ? options.tail : 1 };
+    bool is_caught_up = false;
+    LogQuery::follow(directory, filter,
+        [&](const LogRecord& record) {
+            if (is_caught_up)
+                print(record);
+            else if (options.tail > 0)
+                tail.push(record);
+            return !is_interrupted;
+        },
+        [&]() {
+            if (!is_caught_up) {
+                tail.flush();
+                is_caught_up = true;
+            }
+            fflush(stdout);
+            return !is_interrupted;
+        });
+    fflush(stdout);
+    return 0;
+}